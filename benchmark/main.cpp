@@ -0,0 +1,764 @@
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Frame.h"
+#include "FrameCompute.h"
+#include "FrameKernels.h"
+#include "FrameBayer.h"
+#include "FrameTensor.h"
+#include "FramePyramid.h"
+#include "FrameTransform.h"
+
+
+
+// Link namespaces.
+using namespace std;
+using namespace std::chrono;
+using namespace cr::video;
+
+
+
+/// Guard bytes before and after buffers (kernels read rows from index -2).
+const size_t g_guard = 64;
+/// Maximum shift of buffer data from 32 bytes alignment.
+const size_t g_maxShift = 32;
+/// Fixed widths of checks (around SIMD register sizes).
+const int g_widths[] = {1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 32, 33, 47, 63, 64, 65,
+                        95, 127, 128, 129, 255, 257, 1921};
+/// Width of benchmark.
+const int g_benchWidth = 1920;
+/// Names of SIMD levels.
+const char* g_levelNames[] = {"SCALAR", "SSE41", "AVX2"};
+
+
+
+/// Buffer with random guard bytes around data. Data starts at random shift
+/// from guard (unaligned), buffers can be copied.
+struct Buffer
+{
+    vector<uint8_t> bytes;
+    size_t offset{0};
+
+    uint8_t* ptr() { return &bytes[offset]; }
+    uint16_t* ptr16() { return (uint16_t*)&bytes[offset]; }
+    float* ptrF() { return (float*)&bytes[offset]; }
+    int* ptrI() { return (int*)&bytes[offset]; }
+};
+
+
+
+/// Data of one kernel call: inputs, parameters and two sets of outputs
+/// (reference and checked level).
+struct Data
+{
+    int width{0};
+    int height{0};
+    int param{0};
+    int param2{0};
+    bool flag{false};
+    float scale{1.0f};
+    float offset{0.0f};
+    vector<Buffer> inputs;
+    vector<Buffer> outputs[2];
+    /// Source frame, tensor parameters and results of frame functions.
+    Frame frame;
+    TensorParams tensor;
+    vector<uint8_t> results[2];
+};
+
+
+
+/// Benchmark case: kernel or frame function.
+struct Case
+{
+    string name;
+    /// Minimum width.
+    int minWidth;
+    /// Prepare data for width. Benchmark uses fixed parameters.
+    function<void(Data& data, int width, bool isBench, mt19937& rng)> prepare;
+    /// Run kernel or function with SIMD level writing output set.
+    function<void(SimdLevel level, Data& data, int out)> run;
+    /// Number of processed pixels (elements).
+    function<double(const Data& data)> pixels;
+};
+
+
+
+/// Make buffer with random content.
+Buffer makeBuffer(size_t size, mt19937& rng, size_t align = 1)
+{
+    Buffer buffer;
+    buffer.bytes.resize(size + g_maxShift + 2 * g_guard);
+    for (auto& value : buffer.bytes)
+        value = (uint8_t)rng();
+    buffer.offset = g_guard + (rng() % g_maxShift) / align * align;
+    return buffer;
+}
+
+
+
+/// Make buffer of 16 bit values [0, maxValue].
+Buffer makeBuffer16(size_t count, int maxValue, mt19937& rng)
+{
+    Buffer buffer = makeBuffer(count * 2, rng, 2);
+    for (size_t i = 0; i < count; ++i)
+        buffer.ptr16()[i] = (uint16_t)(rng() % ((uint32_t)maxValue + 1));
+    return buffer;
+}
+
+
+
+/// Add input buffer.
+void addInput(Data& data, size_t size, mt19937& rng)
+{
+    data.inputs.push_back(makeBuffer(size, rng));
+}
+
+
+
+/// Add output buffer (the same content in both output sets).
+void addOutput(Data& data, const Buffer& buffer)
+{
+    data.outputs[0].push_back(buffer);
+    data.outputs[1].push_back(buffer);
+}
+
+
+
+/// Random value [min, max].
+int random(mt19937& rng, int min, int max)
+{
+    return min + (int)(rng() % (uint32_t)(max - min + 1));
+}
+
+
+
+/// Random frame.
+Frame makeFrame(int width, int height, Fourcc fourcc, mt19937& rng)
+{
+    Frame frame(width, height, fourcc);
+    for (int64_t i = 0; i < frame.size; ++i)
+        frame.data[i] = (uint8_t)rng();
+    return frame;
+}
+
+
+
+/// Kernels table of SIMD level.
+const kernels::KernelTable& table(SimdLevel level)
+{
+    return kernels::getTable(level);
+}
+
+
+
+/// Make cases.
+vector<Case> makeCases()
+{
+    vector<Case> cases;
+    auto rowPixels = [](const Data& data) { return (double)data.width; };
+    auto blockPixels = [](const Data& data) { return (double)data.width * data.height; };
+
+    // Bayer kernels: rows are read from index -2 to index width + 1.
+    cases.push_back({"bayerBilinearRow", 4,
+        [](Data& data, int width, bool, mt19937& rng)
+        {
+            data.width = width;
+            data.flag = rng() % 2 == 0;
+            for (int i = 0; i < 3; ++i)
+                addInput(data, width, rng);
+            for (int i = 0; i < 3; ++i)
+                addOutput(data, makeBuffer(width, rng));
+        },
+        [](SimdLevel level, Data& data, int out)
+        {
+            const uint8_t* rows[3] = {data.inputs[0].ptr(), data.inputs[1].ptr(),
+                                      data.inputs[2].ptr()};
+            table(level).bayerBilinearRow(rows, data.width, data.flag, data.outputs[out][0].ptr(),
+                                          data.outputs[out][1].ptr(), data.outputs[out][2].ptr());
+        }, rowPixels});
+
+    cases.push_back({"bayerGreenRow", 4,
+        [](Data& data, int width, bool, mt19937& rng)
+        {
+            data.width = width;
+            data.flag = rng() % 2 == 0;
+            for (int i = 0; i < 5; ++i)
+                addInput(data, width, rng);
+            addOutput(data, makeBuffer(width, rng));
+        },
+        [](SimdLevel level, Data& data, int out)
+        {
+            const uint8_t* rows[5];
+            for (int i = 0; i < 5; ++i)
+                rows[i] = data.inputs[i].ptr();
+            table(level).bayerGreenRow(rows, data.width, data.flag, data.outputs[out][0].ptr());
+        }, rowPixels});
+
+    cases.push_back({"bayerColorRow", 4,
+        [](Data& data, int width, bool, mt19937& rng)
+        {
+            data.width = width;
+            data.flag = rng() % 2 == 0;
+            for (int i = 0; i < 6; ++i)
+                addInput(data, width, rng);
+            for (int i = 0; i < 2; ++i)
+                addOutput(data, makeBuffer(width, rng));
+        },
+        [](SimdLevel level, Data& data, int out)
+        {
+            const uint8_t* rows[3] = {data.inputs[0].ptr(), data.inputs[1].ptr(),
+                                      data.inputs[2].ptr()};
+            const uint8_t* greens[3] = {data.inputs[3].ptr(), data.inputs[4].ptr(),
+                                        data.inputs[5].ptr()};
+            table(level).bayerColorRow(rows, greens, data.width, data.flag,
+                                       data.outputs[out][0].ptr(), data.outputs[out][1].ptr());
+        }, rowPixels});
+
+    // Conversion and scaling kernels.
+    auto prepareTensor = [](Data& data, int width, bool isBench, mt19937& rng)
+    {
+        data.width = width;
+        data.param = isBench ? 77 : random(rng, 0, 256);
+        data.scale = isBench ? 1.0f / 255.0f : (float)random(rng, 1, 1000) / 7919.0f;
+        data.offset = isBench ? -0.5f : (float)random(rng, -1000, 1000) / 997.0f;
+        data.inputs.push_back(makeBuffer16(width, 255 * 256, rng));
+        data.inputs.push_back(makeBuffer16(width, 255 * 256, rng));
+        addOutput(data, makeBuffer(width * 4, rng, 4));
+    };
+    cases.push_back({"tensorRow", 1, prepareTensor,
+        [](SimdLevel level, Data& data, int out)
+        {
+            table(level).tensorRow(data.inputs[0].ptr16(), data.inputs[1].ptr16(), data.param,
+                                   data.width, data.scale, data.offset,
+                                   data.outputs[out][0].ptrF());
+        }, rowPixels});
+
+    cases.push_back({"tensorRowHalf", 1, prepareTensor,
+        [](SimdLevel level, Data& data, int out)
+        {
+            table(level).tensorRowHalf(data.inputs[0].ptr16(), data.inputs[1].ptr16(),
+                                       data.param, data.width, data.scale, data.offset,
+                                       data.outputs[out][0].ptr16());
+        }, rowPixels});
+
+    cases.push_back({"resampleRow", 1,
+        [](Data& data, int width, bool isBench, mt19937& rng)
+        {
+            // Source row is 3 times wider (1920 -> 640 scale of benchmark) and
+            // is read to max(index) + 3 (guard bytes).
+            data.width = width;
+            int srcWidth = 3 * width;
+            addInput(data, srcWidth, rng);
+            data.inputs.push_back(makeBuffer((size_t)width * 4, rng, 4));
+            data.inputs.push_back(makeBuffer((size_t)width * 4, rng, 4));
+            for (int x = 0; x < width; ++x)
+            {
+                data.inputs[1].ptrI()[x] = isBench ? 3 * x + 1 : random(rng, 0, srcWidth - 1);
+                data.inputs[2].ptrI()[x] = isBench ? 128 : random(rng, 0, 255);
+            }
+            addOutput(data, makeBuffer((size_t)width * 2, rng, 2));
+        },
+        [](SimdLevel level, Data& data, int out)
+        {
+            table(level).resampleRow(data.inputs[0].ptr(), data.inputs[1].ptrI(),
+                                     data.inputs[2].ptrI(), data.width,
+                                     data.outputs[out][0].ptr16());
+        }, rowPixels});
+
+    cases.push_back({"yuvToRgbRow", 1,
+        [](Data& data, int width, bool, mt19937& rng)
+        {
+            data.width = width;
+            for (int i = 0; i < 3; ++i)
+                addInput(data, width, rng);
+            for (int i = 0; i < 3; ++i)
+                addOutput(data, makeBuffer(width, rng));
+        },
+        [](SimdLevel level, Data& data, int out)
+        {
+            table(level).yuvToRgbRow(data.inputs[0].ptr(), data.inputs[1].ptr(),
+                                     data.inputs[2].ptr(), data.width,
+                                     data.outputs[out][0].ptr(), data.outputs[out][1].ptr(),
+                                     data.outputs[out][2].ptr());
+        }, rowPixels});
+
+    cases.push_back({"lerpRow", 1,
+        [](Data& data, int width, bool isBench, mt19937& rng)
+        {
+            data.width = width;
+            data.param = isBench ? 77 : random(rng, 0, 256);
+            addInput(data, width, rng);
+            addInput(data, width, rng);
+            addOutput(data, makeBuffer(width * 2, rng, 2));
+        },
+        [](SimdLevel level, Data& data, int out)
+        {
+            table(level).lerpRow(data.inputs[0].ptr(), data.inputs[1].ptr(), data.param,
+                                 data.width, data.outputs[out][0].ptr16());
+        }, rowPixels});
+
+    cases.push_back({"downscaleRow", 1,
+        [](Data& data, int width, bool, mt19937& rng)
+        {
+            data.width = width;
+            addInput(data, width * 2, rng);
+            addInput(data, width * 2, rng);
+            addOutput(data, makeBuffer(width, rng));
+        },
+        [](SimdLevel level, Data& data, int out)
+        {
+            table(level).downscaleRow(data.inputs[0].ptr(), data.inputs[1].ptr(), data.width,
+                                      data.outputs[out][0].ptr());
+        }, rowPixels});
+
+    // Transpose of blocks with padded and negative strides.
+    for (int elementSize = 1; elementSize <= 2; ++elementSize)
+    {
+        cases.push_back({elementSize == 1 ? "transpose8" : "transpose16", 1,
+            [elementSize](Data& data, int width, bool isBench, mt19937& rng)
+            {
+                data.width = width;
+                data.height = isBench ? 64 : random(rng, 1, 40);
+                data.param = (width + (isBench ? 0 : random(rng, 0, 16))) * elementSize;
+                data.param2 = (data.height + (isBench ? 0 : random(rng, 0, 16))) * elementSize;
+                data.flag = !isBench && rng() % 2 == 0;
+                addInput(data, (size_t)data.param * data.height, rng);
+                addOutput(data, makeBuffer((size_t)data.param2 * width, rng, elementSize));
+            },
+            [elementSize](SimdLevel level, Data& data, int out)
+            {
+                const uint8_t* src = data.inputs[0].ptr();
+                uint8_t* dst = data.outputs[out][0].ptr();
+                ptrdiff_t srcStride = data.param;
+                ptrdiff_t dstStride = data.param2;
+                if (data.flag)
+                {
+                    src += (ptrdiff_t)(data.height - 1) * srcStride;
+                    dst += (ptrdiff_t)(data.width - 1) * dstStride;
+                    srcStride = -srcStride;
+                    dstStride = -dstStride;
+                }
+                if (elementSize == 1)
+                    table(level).transpose8(src, srcStride, dst, dstStride, data.width, data.height);
+                else
+                    table(level).transpose16(src, srcStride, dst, dstStride, data.width, data.height);
+            }, blockPixels});
+    }
+
+    // Row kernels of transform, statistics and overlay.
+    for (int elementSize = 1; elementSize <= 2; ++elementSize)
+    {
+        cases.push_back({elementSize == 1 ? "reverse8" : "reverse16", 1,
+            [elementSize](Data& data, int width, bool, mt19937& rng)
+            {
+                data.width = width;
+                data.inputs.push_back(makeBuffer((size_t)width * elementSize, rng, elementSize));
+                addOutput(data, makeBuffer((size_t)width * elementSize, rng, elementSize));
+            },
+            [elementSize](SimdLevel level, Data& data, int out)
+            {
+                if (elementSize == 1)
+                    table(level).reverse8(data.inputs[0].ptr(), data.outputs[out][0].ptr(), data.width);
+                else
+                    table(level).reverse16(data.inputs[0].ptr(), data.outputs[out][0].ptr(), data.width);
+            }, rowPixels});
+
+        cases.push_back({elementSize == 1 ? "rangeRow8" : "rangeRow16", 1,
+            [elementSize](Data& data, int width, bool, mt19937& rng)
+            {
+                data.width = width;
+                data.inputs.push_back(makeBuffer((size_t)width * elementSize, rng, elementSize));
+                addOutput(data, makeBuffer(16, rng, 8));
+            },
+            [elementSize](SimdLevel level, Data& data, int out)
+            {
+                int min = 65535;
+                int max = 0;
+                uint64_t sum = 0;
+                if (elementSize == 1)
+                    table(level).rangeRow8(data.inputs[0].ptr(), data.width, min, max, sum);
+                else
+                    table(level).rangeRow16(data.inputs[0].ptr16(), data.width, min, max, sum);
+                uint8_t* result = data.outputs[out][0].ptr();
+                memcpy(result, &min, 4);
+                memcpy(result + 4, &max, 4);
+                memcpy(result + 8, &sum, 8);
+            }, rowPixels});
+    }
+
+    cases.push_back({"blendRow", 1,
+        [](Data& data, int width, bool, mt19937& rng)
+        {
+            data.width = width;
+            addInput(data, width, rng);
+            addInput(data, width, rng);
+            addOutput(data, makeBuffer(width, rng));
+        },
+        [](SimdLevel level, Data& data, int out)
+        {
+            table(level).blendRow(data.outputs[out][0].ptr(), data.inputs[0].ptr(),
+                                  data.inputs[1].ptr(), data.width);
+        }, rowPixels});
+
+    // Temporal kernels.
+    cases.push_back({"accumulateRow", 1,
+        [](Data& data, int width, bool isBench, mt19937& rng)
+        {
+            data.width = width;
+            data.param = isBench ? 3277 : random(rng, 1, 65535);
+            data.param2 = isBench ? 20 : random(rng, 0, 255);
+            data.flag = isBench || rng() % 2 == 0;
+            addInput(data, width, rng);
+            addOutput(data, makeBuffer16(width, 255 * 256, rng));
+            addOutput(data, makeBuffer(width, rng));
+        },
+        [](SimdLevel level, Data& data, int out)
+        {
+            table(level).accumulateRow(data.inputs[0].ptr(), data.outputs[out][0].ptr16(),
+                                       data.param, data.param2,
+                                       data.flag ? data.outputs[out][1].ptr() : nullptr,
+                                       data.width);
+        }, rowPixels});
+
+    cases.push_back({"differenceRow", 1,
+        [](Data& data, int width, bool isBench, mt19937& rng)
+        {
+            data.width = width;
+            data.param = isBench ? 20 : random(rng, 0, 255);
+            addInput(data, width, rng);
+            addInput(data, width, rng);
+            addOutput(data, makeBuffer(width, rng));
+        },
+        [](SimdLevel level, Data& data, int out)
+        {
+            table(level).differenceRow(data.inputs[0].ptr(), data.inputs[1].ptr(), data.param,
+                                       data.outputs[out][0].ptr(), data.width);
+        }, rowPixels});
+
+    for (int isMedian = 0; isMedian <= 1; ++isMedian)
+    {
+        cases.push_back({isMedian ? "medianRow" : "meanRow", 1,
+            [isMedian](Data& data, int width, bool isBench, mt19937& rng)
+            {
+                data.width = width;
+                data.height = isBench ? (isMedian ? 5 : 8) :
+                              random(rng, 1, isMedian ? 16 : (rng() % 8 == 0 ? 257 : 20));
+                for (int i = 0; i < data.height; ++i)
+                    addInput(data, width, rng);
+                addOutput(data, makeBuffer(width, rng));
+            },
+            [isMedian](SimdLevel level, Data& data, int out)
+            {
+                vector<const uint8_t*> rows(data.height);
+                for (int i = 0; i < data.height; ++i)
+                    rows[i] = data.inputs[i].ptr();
+                if (isMedian)
+                    table(level).medianRow(rows.data(), data.height, data.width,
+                                           data.outputs[out][0].ptr());
+                else
+                    table(level).meanRow(rows.data(), data.height, data.width,
+                                         data.outputs[out][0].ptr());
+            }, blockPixels});
+    }
+
+    // Deinterlace kernel with and without previous row, in place.
+    cases.push_back({"deinterlaceRow", 1,
+        [](Data& data, int width, bool isBench, mt19937& rng)
+        {
+            data.width = width;
+            data.param = isBench ? 10 : random(rng, 0, 255);
+            data.param2 = isBench ? 1 : random(rng, 0, 3);
+            for (int i = 0; i < 4; ++i)
+                addInput(data, width, rng);
+            addOutput(data, makeBuffer(width, rng));
+        },
+        [](SimdLevel level, Data& data, int out)
+        {
+            uint8_t* dst = data.outputs[out][0].ptr();
+            const uint8_t* current = (data.param2 & 2) ? dst : data.inputs[2].ptr();
+            const uint8_t* previous = (data.param2 & 1) ? data.inputs[3].ptr() : nullptr;
+            table(level).deinterlaceRow(data.inputs[0].ptr(), data.inputs[1].ptr(), current,
+                                        previous, data.param, data.width, dst);
+        }, rowPixels});
+
+    cases.push_back({"streamCopy", 1,
+        [](Data& data, int width, bool isBench, mt19937& rng)
+        {
+            data.width = isBench ? width * 1080 : width * random(rng, 1, 8) + random(rng, 0, 63);
+            addInput(data, data.width, rng);
+            addOutput(data, makeBuffer(data.width, rng));
+        },
+        [](SimdLevel level, Data& data, int out)
+        {
+            table(level).streamCopy(data.outputs[out][0].ptr(), data.inputs[0].ptr(),
+                                    (size_t)data.width);
+        }, rowPixels});
+
+    // Frame functions (SIMD level is forced for library).
+    cases.push_back({"demosaic", 4,
+        [](Data& data, int width, bool isBench, mt19937& rng)
+        {
+            data.width = width;
+            data.height = isBench ? 1080 : random(rng, 4, 24);
+            data.flag = !isBench && rng() % 2 == 0;
+            data.frame = makeFrame(width, data.height, Fourcc::RGGB8, rng);
+        },
+        [](SimdLevel level, Data& data, int out)
+        {
+            setSimdLevel(level);
+            Frame dst;
+            demosaic(data.frame, dst, Fourcc::RGB24,
+                     data.flag ? DemosaicMethod::EDGE_AWARE : DemosaicMethod::BILINEAR);
+            data.results[out].assign(dst.data, dst.data + dst.size);
+        }, blockPixels});
+
+    cases.push_back({"frameToTensor", 8,
+        [](Data& data, int width, bool isBench, mt19937& rng)
+        {
+            // Unaligned ROI of NV12 frame scaled to tensor.
+            width = width / 2 * 2;
+            data.height = isBench ? 1080 : random(rng, 4, 24) * 2;
+            data.frame = makeFrame(width, data.height, Fourcc::NV12, rng);
+            TensorParams& params = data.tensor;
+            params.roiX = isBench ? 0 : random(rng, 0, 3);
+            params.roiY = isBench ? 0 : random(rng, 0, 3);
+            params.roiWidth = width - params.roiX - (isBench ? 0 : random(rng, 0, 3));
+            params.roiHeight = data.height - params.roiY - (isBench ? 0 : random(rng, 0, 3));
+            params.width = isBench ? 640 : random(rng, 1, 300);
+            params.height = isBench ? 640 : random(rng, 1, 100);
+            params.type = !isBench && rng() % 2 == 0 ? TensorType::FLOAT16 : TensorType::FLOAT32;
+            params.layout = !isBench && rng() % 2 == 0 ? TensorLayout::HWC : TensorLayout::CHW;
+            data.width = width;
+            data.param = params.roiX;
+            data.param2 = params.roiY;
+        },
+        [](SimdLevel level, Data& data, int out)
+        {
+            setSimdLevel(level);
+            data.results[out].resize(getTensorSize(data.frame, data.tensor));
+            frameToTensor(data.frame, data.results[out].data(), data.tensor);
+        }, blockPixels});
+
+    cases.push_back({"pyramid", 2,
+        [](Data& data, int width, bool isBench, mt19937& rng)
+        {
+            data.width = width;
+            data.height = isBench ? 1080 : random(rng, 2, 40);
+            data.frame = makeFrame(width, data.height, Fourcc::GRAY, rng);
+        },
+        [](SimdLevel level, Data& data, int out)
+        {
+            setSimdLevel(level);
+            FramePyramid pyramid;
+            pyramid.build(data.frame, 5);
+            data.results[out].clear();
+            Frame frame;
+            for (int i = 1; i < pyramid.getLevelsCount(); ++i)
+                if (pyramid.getLevel(i, frame))
+                    data.results[out].insert(data.results[out].end(), frame.data,
+                                             frame.data + frame.size);
+        }, blockPixels});
+
+    cases.push_back({"transformFrame", 1,
+        [](Data& data, int width, bool isBench, mt19937& rng)
+        {
+            data.width = width;
+            data.height = isBench ? 1080 : random(rng, 1, 40);
+            data.param = isBench ? 0 : random(rng, 0, 5);
+            data.frame = makeFrame(width, data.height, Fourcc::YUV24, rng);
+        },
+        [](SimdLevel level, Data& data, int out)
+        {
+            setSimdLevel(level);
+            Frame dst;
+            transformFrame(data.frame, dst, (FrameTransform)data.param);
+            data.results[out].assign(dst.data, dst.data + dst.size);
+        }, blockPixels});
+
+    return cases;
+}
+
+
+
+/// Compare outputs of reference and checked levels.
+bool isEqual(const Data& data)
+{
+    if (data.results[0] != data.results[1])
+        return false;
+    for (size_t i = 0; i < data.outputs[0].size(); ++i)
+        if (data.outputs[0][i].bytes != data.outputs[1][i].bytes)
+            return false;
+    return true;
+}
+
+
+
+/// Check levels against scalar reference on random data.
+bool check(const Case& test, int iterations, mt19937& rng)
+{
+    const int maxLevel = (int)getMaxSimdLevel();
+    const int fixedCount = (int)(sizeof(g_widths) / sizeof(g_widths[0]));
+    for (int i = 0; i < fixedCount + iterations; ++i)
+    {
+        int width = i < fixedCount ? g_widths[i] : random(rng, 1, 700);
+        if (width < test.minWidth)
+            continue;
+
+        Data data;
+        test.prepare(data, width, false, rng);
+        vector<Buffer> outputs = data.outputs[1];
+        test.run(SimdLevel::SCALAR, data, 0);
+        for (int level = 1; level <= maxLevel; ++level)
+        {
+            data.outputs[1] = outputs;
+            test.run((SimdLevel)level, data, 1);
+            if (!isEqual(data))
+            {
+                cout << test.name << " " << g_levelNames[level] << ": result differs from "
+                     << "scalar reference (width " << data.width << ", height " << data.height
+                     << ", param " << data.param << ", param2 " << data.param2 << ")" << endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+
+
+/// Measure throughput of level (megapixels per second).
+double measure(const Case& test, Data& data, SimdLevel level, double minSeconds)
+{
+    test.run(level, data, 1);
+    int runs = 0;
+    steady_clock::time_point begin = steady_clock::now();
+    double seconds = 0.0;
+    do
+    {
+        test.run(level, data, 1);
+        ++runs;
+        seconds = duration<double>(steady_clock::now() - begin).count();
+    } while (seconds < minSeconds);
+    return test.pixels(data) * runs / seconds / 1e6;
+}
+
+
+
+/// Entry point. Options: -quick (short run for ctest), -save <file> (save
+/// throughput), -baseline <file> (compare throughput with saved),
+/// -tolerance <percent> (allowed slowdown, default 25).
+int main(int argc, char** argv)
+{
+    bool isQuick = false;
+    string saveFile;
+    string baselineFile;
+    double tolerance = 25.0;
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+        if (arg == "-quick")
+            isQuick = true;
+        else if (arg == "-save" && i + 1 < argc)
+            saveFile = argv[++i];
+        else if (arg == "-baseline" && i + 1 < argc)
+            baselineFile = argv[++i];
+        else if (arg == "-tolerance" && i + 1 < argc)
+            tolerance = atof(argv[++i]);
+        else
+        {
+            cout << "Usage: FrameBenchmark [-quick] [-save file] [-baseline file] "
+                 << "[-tolerance percent]" << endl;
+            return 1;
+        }
+    }
+
+    cout << "#######################################" << endl;
+    cout << "Frame class v" << Frame::getVersion() << " benchmark" << endl;
+    cout << "#######################################" << endl << endl;
+
+    // Baseline: case, level, throughput.
+    map<string, double> baseline;
+    if (!baselineFile.empty())
+    {
+        ifstream file(baselineFile);
+        if (!file)
+        {
+            cout << "Can't open baseline file " << baselineFile << endl;
+            return 1;
+        }
+        string name;
+        string level;
+        double value;
+        while (file >> name >> level >> value)
+            baseline[name + " " + level] = value;
+    }
+
+    // Processing is single threaded to measure SIMD paths.
+    const SimdLevel initialLevel = getSimdLevel();
+    const int initialThreads = getThreadsCount();
+    setThreadsCount(1);
+
+    const int maxLevel = (int)getMaxSimdLevel();
+    const double minSeconds = isQuick ? 0.01 : 0.2;
+    const int iterations = isQuick ? 50 : 500;
+    mt19937 rng(20261019);
+    bool isOk = true;
+    ostringstream saved;
+    cout << left << setw(18) << "Kernel" << setw(8) << "Level" << right << setw(12)
+         << "Mpix/s" << setw(10) << "Speedup" << "  Result" << endl;
+    for (const Case& test : makeCases())
+    {
+        bool isChecked = check(test, iterations, rng);
+        isOk = isOk && isChecked;
+
+        Data data;
+        test.prepare(data, g_benchWidth, true, rng);
+        double scalar = 0.0;
+        for (int level = 0; level <= maxLevel; ++level)
+        {
+            double value = measure(test, data, (SimdLevel)level, minSeconds);
+            if (level == 0)
+                scalar = value;
+            string key = test.name + " " + g_levelNames[level];
+            saved << key << " " << value << endl;
+
+            // Check regression.
+            string result = isChecked ? "OK" : "ERROR";
+            auto entry = baseline.find(key);
+            if (entry != baseline.end() && value < entry->second * (1.0 - tolerance / 100.0))
+            {
+                result = "SLOW (baseline " + to_string((int)entry->second) + ")";
+                isOk = false;
+            }
+            cout << left << setw(18) << test.name << setw(8) << g_levelNames[level] << right
+                 << fixed << setprecision(1) << setw(12) << value << setw(10)
+                 << setprecision(2) << value / scalar << "  " << result << endl;
+        }
+    }
+
+    setThreadsCount(initialThreads);
+    setSimdLevel(initialLevel);
+
+    if (!saveFile.empty())
+    {
+        ofstream file(saveFile);
+        file << saved.str();
+        if (!file)
+        {
+            cout << "Can't write file " << saveFile << endl;
+            return 1;
+        }
+    }
+
+    cout << endl << (isOk ? "OK" : "ERROR") << endl;
+    return isOk ? 0 : 1;
+}
@@ -1,4 +1,10 @@
+#include <climits>
+#include <utility>
 #include "Frame.h"
+#include "FrameCache.h"
+#include "FrameCopy.h"
+#include "FrameCountersImpl.h"
+#include "FrameKernels.h"
 #include "FrameVersion.h"
 
 
@@ -9,6 +15,20 @@ using namespace cr::video;
 
 
 
+namespace
+{
+
+/// Size of serialization header with 32-bit data size (bytes).
+const int64_t g_headerSize = 26;
+/// Size of serialization header with 64-bit data size (bytes).
+const int64_t g_largeHeaderSize = 34;
+/// Size of serialization header with 64-bit data size and content hash
+/// (bytes).
+const int64_t g_hashHeaderSize = 42;
+}
+
+
+
 string Frame::getVersion()
 {
     return FRAME_VERSION;
@@ -26,7 +46,7 @@ Frame::Frame()
 Frame::Frame(int _width,
              int _height,
              Fourcc _fourcc,
-             int _size,
+             int64_t _size,
              uint8_t* _data)
 {
     // Check frame size.
@@ -37,49 +57,35 @@ Frame::Frame(int _width,
     }
 
     // Calculate frame data size according to pixel format.
-    switch (_fourcc)
-    {
-    case Fourcc::BGR24:
-    case Fourcc::RGB24:
-    case Fourcc::YUV24:
-        size = _width * _height * 3;
-        break;
-    case Fourcc::NV12:
-    case Fourcc::NV21:
-    case Fourcc::YU12:
-    case Fourcc::YV12:
-        size = _width * (_height + _height / 2);
-        break;
-    case Fourcc::YUYV:
-    case Fourcc::UYVY:
-        size = _width * _height * 2;
-        break;
-    case Fourcc::JPEG:
-    case Fourcc::H264:
-    case Fourcc::HEVC:
-        size = _width * _height * 4;
-        break;
-    case Fourcc::GRAY:
-        size = _width * _height;
-        break;
-    default:
+    int64_t bufferSize = kernels::getBufferSize(_fourcc, _width, _height);
+    if (bufferSize < 0)
         return;
-    }
+    size = bufferSize;
 
     // Allocate memory.
     if (size > 0)
     {
-        data = new uint8_t[size];
-        memset(data, 0, size);
+        data = new uint8_t[(size_t)size];
         m_isAllocated = true;
+        FRAME_COUNT(ALLOCATIONS, 1);
+        FRAME_COUNT(BYTES_ALLOCATED, size);
     }
 
-    // Copy data.
+    // Copy data and clear the rest of buffer.
+    int64_t copied = 0;
     if (_size <= size && _data != nullptr)
     {
-        memcpy(data, _data, _size);
-        size = _size;
+        copyData(data, _data, (size_t)_size);
+        copied = _size;
+        FRAME_COUNT(BYTES_COPIED, _size);
     }
+    if (size > copied)
+    {
+        memset(data + copied, 0, (size_t)(size - copied));
+        FRAME_COUNT(BYTES_ZEROED, size - copied);
+    }
+    if (_size <= size && _data != nullptr)
+        size = _size;
 
     // Copy atributes.
     width = _width;
@@ -93,6 +99,9 @@ Frame::Frame(int _width,
 
 Frame::Frame(Frame &src)
 {
+    FRAME_LATENCY(COPY);
+    FRAME_COUNT(COPIES, 1);
+
     // free memory if allocated before.
     release();
 
@@ -104,51 +113,45 @@ Frame::Frame(Frame &src)
     frameId = src.frameId;
 
     // Calculate frame data size according to pixel format.
-    switch (fourcc)
-    {
-    case Fourcc::BGR24:
-    case Fourcc::RGB24:
-    case Fourcc::YUV24:
-        size = width * height * 3;
-        break;
-    case Fourcc::NV12:
-    case Fourcc::NV21:
-    case Fourcc::YU12:
-    case Fourcc::YV12:
-        size = width * (height + height / 2);
-        break;
-    case Fourcc::YUYV:
-    case Fourcc::UYVY:
-        size = width * height * 2;
-        break;
-    case Fourcc::JPEG:
-    case Fourcc::H264:
-    case Fourcc::HEVC:
-        size = width * height * 4;
-        break;
-    case Fourcc::GRAY:
-        size = width * height;
-        break;
-    default:
+    int64_t bufferSize = kernels::getBufferSize(fourcc, width, height);
+    if (bufferSize < 0)
         return;
-    }
+    size = bufferSize;
 
     // Allocate memory.
     if (size > 0)
     {
-        data = new uint8_t[size];
-        memset(data, 0, size);
+        data = new uint8_t[(size_t)size];
         m_isAllocated = true;
+        FRAME_COUNT(ALLOCATIONS, 1);
+        FRAME_COUNT(BYTES_ALLOCATED, size);
     }
 
-    // Copy data.
+    // Copy data and clear the rest of buffer.
+    int64_t copied = 0;
     if (src.size <= size && src.data != nullptr)
     {
-        memcpy(data, src.data, src.size);
+        copyData(data, src.data, (size_t)src.size);
+        copied = src.size;
+        FRAME_COUNT(BYTES_COPIED, src.size);
+    }
+    if (size > copied)
+    {
+        memset(data + copied, 0, (size_t)(size - copied));
+        FRAME_COUNT(BYTES_ZEROED, size - copied);
     }
 
-    // Copy size.
+    // Copy size and content hash.
     size = src.size;
+    if (copied == src.size)
+        copyHash(src);
+}
+
+
+
+Frame::Frame(Frame&& src)
+{
+    *this = std::move(src);
 }
 
 
@@ -157,7 +160,11 @@ Frame::~Frame()
 {
     // Release memory.
     if (m_isAllocated)
+    {
         delete[] data;
+        FRAME_COUNT(FREES, 1);
+    }
+    delete m_cache.load();
 }
 
 
@@ -167,8 +174,11 @@ Frame &Frame::operator= (const Frame &src)
     // Check yourself.
     if (this == &src)
         return *this;
+    FRAME_LATENCY(COPY);
+    FRAME_COUNT(COPIES, 1);
 
     // Copy frame ID and source ID.
+    invalidateCache();
     frameId = src.frameId;
     sourceId = src.sourceId;
 
@@ -177,9 +187,11 @@ Frame &Frame::operator= (const Frame &src)
         height == src.height &&
         fourcc == src.fourcc)
     {
-        // Copy frame data.
-        memcpy(data, src.data, src.size);
+        // Copy frame data and content hash.
+        copyData(data, src.data, (size_t)src.size);
+        FRAME_COUNT(BYTES_COPIED, src.size);
         size = src.size;
+        copyHash(src);
     }
     else
     {
@@ -189,54 +201,44 @@ Frame &Frame::operator= (const Frame &src)
         fourcc = src.fourcc;
 
         // Calculate frame data size according to pixel format.
-        switch (fourcc)
-        {
-        case Fourcc::BGR24:
-        case Fourcc::RGB24:
-        case Fourcc::YUV24:
-            size = width * height * 3;
-            break;
-        case Fourcc::NV12:
-        case Fourcc::NV21:
-        case Fourcc::YU12:
-        case Fourcc::YV12:
-            size = width * (height + height / 2);
-            break;
-        case Fourcc::YUYV:
-        case Fourcc::UYVY:
-            size = width * height * 2;
-            break;
-        case Fourcc::JPEG:
-        case Fourcc::H264:
-        case Fourcc::HEVC:
-            size = width * height * 4;
-            break;
-        case Fourcc::GRAY:
-            size = width * height;
-            break;
-        default:
+        int64_t bufferSize = kernels::getBufferSize(fourcc, width, height);
+        if (bufferSize < 0)
             return *this;
-        }
+        size = bufferSize;
 
         if (m_isAllocated)
+        {
             delete[] data;
+            FRAME_COUNT(FREES, 1);
+        }
 
         // Allocate memory.
         if (size > 0)
         {
-            data = new uint8_t[size];
-            memset(data, 0, size);
+            data = new uint8_t[(size_t)size];
             m_isAllocated = true;
+            FRAME_COUNT(ALLOCATIONS, 1);
+            FRAME_COUNT(BYTES_ALLOCATED, size);
         }
 
-        // Copy data.
+        // Copy data and clear the rest of buffer.
+        int64_t copied = 0;
         if (src.size <= size && src.data != nullptr && size > 0)
         {
-            memcpy(data, src.data, src.size);
+            copyData(data, src.data, (size_t)src.size);
+            copied = src.size;
+            FRAME_COUNT(BYTES_COPIED, src.size);
+        }
+        if (size > copied)
+        {
+            memset(data + copied, 0, (size_t)(size - copied));
+            FRAME_COUNT(BYTES_ZEROED, size - copied);
         }
 
-        // Copy size.
+        // Copy size and content hash.
         size = src.size;
+        if (copied == src.size)
+            copyHash(src);
     }
 
     return *this;
@@ -244,6 +246,41 @@ Frame &Frame::operator= (const Frame &src)
 
 
 
+Frame &Frame::operator= (Frame&& src)
+{
+    // Check yourself.
+    if (this == &src)
+        return *this;
+
+    // Release memory.
+    invalidateCache();
+    if (m_isAllocated)
+    {
+        delete[] data;
+        FRAME_COUNT(FREES, 1);
+    }
+
+    // Take atributes and data.
+    width = src.width;
+    height = src.height;
+    fourcc = src.fourcc;
+    size = src.size;
+    frameId = src.frameId;
+    sourceId = src.sourceId;
+    data = src.data;
+    m_isAllocated = src.m_isAllocated;
+    copyHash(src);
+
+    // Source frame becomes empty.
+    src.data = nullptr;
+    src.m_isAllocated = false;
+    src.release();
+
+    return *this;
+}
+
+
+
 void Frame::cloneTo(Frame& dst)
 {
     // Check yourself.
@@ -260,15 +297,20 @@ void Frame::cloneTo(Frame& dst)
     dst.fourcc = fourcc;
     dst.size = size;
 
-    // Copy pointer to data.
+    // Copy pointer to data and content hash.
+    dst.invalidateCache();
     dst.data = data;
     dst.m_isAllocated = false;
+    dst.copyHash(*this);
 }
 
 
 
 bool Frame::operator==(Frame &src)
 {
+    FRAME_LATENCY(COMPARE);
+    FRAME_COUNT(COMPARES, 1);
+
     // Check yourself.
     if (this == &src)
         return true;
@@ -286,10 +328,8 @@ bool Frame::operator==(Frame &src)
     if (data == src.data)
         return true;
 
-    if (size > 0 && src.size > 0)
-        for (int i = 0; i < size; ++i)
-            if (data[i] != src.data[i])
-                return false;
+    if (size > 0 && src.size > 0 && memcmp(data, src.data, (size_t)size) != 0)
+        return false;
 
     return true;
 }
@@ -298,6 +338,9 @@ bool Frame::operator==(Frame &src)
 
 bool Frame::operator!=(Frame &src)
 {
+    FRAME_LATENCY(COMPARE);
+    FRAME_COUNT(COMPARES, 1);
+
     // Check yourself.
     if (this == &src)
         return false;
@@ -315,10 +358,8 @@ bool Frame::operator!=(Frame &src)
     if (data == src.data)
         return false;
 
-    if (size > 0 && src.size > 0)
-        for (int i = 0; i < size; ++i)
-            if (data[i] != src.data[i])
-                return true;
+    if (size > 0 && src.size > 0 && memcmp(data, src.data, (size_t)size) != 0)
+        return true;
 
     return false;
 }
@@ -327,10 +368,12 @@ bool Frame::operator!=(Frame &src)
 
 void Frame::release()
 {
+    invalidateCache();
     if (m_isAllocated)
     {
         delete[] data;
         m_isAllocated = false;
+        FRAME_COUNT(FREES, 1);
     }
 
     // Reset fields.
@@ -344,10 +387,13 @@ void Frame::release()
 
 
 
-void Frame::serialize(uint8_t* _data, int& _size)
+void Frame::serialize(uint8_t* _data, int64_t& _size, bool withHash)
 {
+    FRAME_LATENCY(SERIALIZE);
+    FRAME_COUNT(SERIALIZATIONS, 1);
+
     // Copy Frame class version.
-    int pos = 0;
+    int64_t pos = 0;
     _data[pos] = FRAME_MAJOR_VERSION; pos += 1;
     _data[pos] = FRAME_MINOR_VERSION; pos += 1;
 
@@ -359,8 +405,12 @@ void Frame::serialize(uint8_t* _data, int& _size)
     uint32_t value = (uint32_t)fourcc;
     memcpy(&_data[pos], &value, 4); pos += 4;
 
-    // Copy size.
-    memcpy(&_data[pos], &size, 4); pos += 4;
+    // Copy size. Size which doesn't fit 32 bits is marked by -1 and follows
+    // source ID as 64-bit field. Header with content hash is marked by -2:
+    // 64-bit size and hash follow source ID.
+    const bool isLarge = size > INT32_MAX;
+    int32_t size32 = withHash ? -2 : (isLarge ? -1 : (int32_t)size);
+    memcpy(&_data[pos], &size32, 4); pos += 4;
 
     // Copy frame ID.
     memcpy(&_data[pos], &frameId, 4); pos += 4;
@@ -368,9 +418,25 @@ void Frame::serialize(uint8_t* _data, int& _size)
     // Copy source ID.
     memcpy(&_data[pos], &sourceId, 4); pos += 4;
 
+    // Copy 64-bit size and content hash.
+    if (isLarge || withHash)
+    {
+        memcpy(&_data[pos], &size, 8);
+        pos += 8;
+    }
+    if (withHash)
+    {
+        uint64_t hash = getHash();
+        memcpy(&_data[pos], &hash, 8);
+        pos += 8;
+    }
+
     // Copy data.
     if (size > 0)
-        memcpy(&_data[pos], data, size);
+    {
+        copyData(&_data[pos], data, (size_t)size);
+        FRAME_COUNT(BYTES_COPIED, size);
+    }
     pos += size;
 
     _size = pos;
@@ -378,10 +444,38 @@ void Frame::serialize(uint8_t* _data, int& _size)
 
 
 
-bool Frame::deserialize(uint8_t* _data, int _size)
+void Frame::serialize(uint8_t* _data, int& _size, bool withHash)
 {
+    // Check serialized size.
+    if (getSerializedSize(withHash) > INT_MAX)
+    {
+        _size = 0;
+        return;
+    }
+
+    int64_t serializedSize = 0;
+    serialize(_data, serializedSize, withHash);
+    _size = (int)serializedSize;
+}
+
+
+
+int64_t Frame::getSerializedSize(bool withHash) const
+{
+    if (withHash)
+        return g_hashHeaderSize + size;
+    return (size > INT32_MAX ? g_largeHeaderSize : g_headerSize) + size;
+}
+
+
+
+bool Frame::deserialize(uint8_t* _data, int64_t _size)
+{
+    FRAME_LATENCY(DESERIALIZE);
+    FRAME_COUNT(DESERIALIZATIONS, 1);
+
     // Check params.
-    if (_data == nullptr || _size < 26)
+    if (_data == nullptr || _size < g_headerSize)
         return false;
 
     // Check frame class version.
@@ -389,7 +483,7 @@ bool Frame::deserialize(uint8_t* _data, int _size)
         return false;
 
     // Get frame size.
-    int pos = 2;
+    int64_t pos = 2;
     int w = 0;
     int h = 0;
     memcpy(&w, &_data[pos], 4); pos += 4;
@@ -400,8 +494,8 @@ bool Frame::deserialize(uint8_t* _data, int _size)
     memcpy(&f, &_data[pos], 4); pos += 4;
 
     // Get size.
-    int s = 0;
-    memcpy(&s, &_data[pos], 4); pos += 4;
+    int32_t size32 = 0;
+    memcpy(&size32, &_data[pos], 4); pos += 4;
 
     // Get frame ID.
     int fId = 0;
@@ -411,9 +505,27 @@ bool Frame::deserialize(uint8_t* _data, int _size)
     int sId = 0;
     memcpy(&sId, &_data[pos], 4); pos += 4;
 
-    // Check size.
-    if (s != _size - 26)
+    // Get 64-bit size and content hash.
+    int64_t s = size32;
+    uint64_t hash = 0;
+    if (size32 == -1 || size32 == -2)
+    {
+        if (_size < (size32 == -1 ? g_largeHeaderSize : g_hashHeaderSize))
+            return false;
+        memcpy(&s, &_data[pos], 8);
+        pos += 8;
+    }
+    if (size32 == -2)
+    {
+        memcpy(&hash, &_data[pos], 8);
+        pos += 8;
+    }
+
+    // Check size: data must fit frame buffer.
+    int64_t bufferSize = kernels::getBufferSize((Fourcc)f, w, h);
+    if (s < 0 || s != _size - pos || bufferSize < 0 || s > bufferSize)
         return false;
+    invalidateCache();
 
     // Check FOURCC.
     if (width != w || height != h || fourcc != (Fourcc)f)
@@ -425,43 +537,21 @@ bool Frame::deserialize(uint8_t* _data, int _size)
 
         // Release memory.
         if (m_isAllocated)
-            delete[] data;
-
-        // Calculate frame data size according to pixel format.
-        switch ((Fourcc)f)
         {
-        case Fourcc::BGR24:
-        case Fourcc::RGB24:
-        case Fourcc::YUV24:
-            size = width * height * 3;
-            break;
-        case Fourcc::NV12:
-        case Fourcc::NV21:
-        case Fourcc::YU12:
-        case Fourcc::YV12:
-            size = width * (height + height / 2);
-            break;
-        case Fourcc::YUYV:
-        case Fourcc::UYVY:
-            size = width * height * 2;
-            break;
-        case Fourcc::JPEG:
-        case Fourcc::H264:
-        case Fourcc::HEVC:
-            size = width * height * 4;
-            break;
-        case Fourcc::GRAY:
-            size = width * height;
-            break;
-        default:
-            return false;
+            delete[] data;
+            m_isAllocated = false;
+            FRAME_COUNT(FREES, 1);
         }
+        data = nullptr;
 
         // Allocate memory.
+        size = bufferSize;
         if (size > 0)
         {
-            data = new uint8_t[size];
+            data = new uint8_t[(size_t)size];
             m_isAllocated = true;
+            FRAME_COUNT(ALLOCATIONS, 1);
+            FRAME_COUNT(BYTES_ALLOCATED, size);
         }
     }
 
@@ -475,7 +565,14 @@ bool Frame::deserialize(uint8_t* _data, int _size)
 
     // Copy data.
     if (size > 0)
-        memcpy(data, &_data[pos], size);
+    {
+        copyData(data, &_data[pos], (size_t)size);
+        FRAME_COUNT(BYTES_COPIED, size);
+    }
+
+    // Keep content hash.
+    if (size32 == -2)
+        getCache()->setHash(*this, hash);
 
     return true;
-}
\ No newline at end of file
+}
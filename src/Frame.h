@@ -1,4 +1,5 @@
 #pragma once
+#include <atomic>
 #include <cstdint>
 #include <cstring>
 #include <memory>
@@ -49,6 +50,30 @@ enum class Fourcc
     /// YV12 (YVU420) - Planar pixel format.
     /// https://docs.kernel.org/userspace-api/media/v4l/pixfmt-yuv-planar.html#v4l2-pix-fmt-yuv420
     YV12 = MAKE_FOURCC_CODE('Y', 'V', '1', '2'),
+    /// Bayer BGGR 8bit raw format.
+    /// https://docs.kernel.org/userspace-api/media/v4l/pixfmt-srggb8.html#v4l2-pix-fmt-sbggr8
+    BGGR8 = MAKE_FOURCC_CODE('B', 'A', '8', '1'),
+    /// Bayer GBRG 8bit raw format.
+    /// https://docs.kernel.org/userspace-api/media/v4l/pixfmt-srggb8.html#v4l2-pix-fmt-sgbrg8
+    GBRG8 = MAKE_FOURCC_CODE('G', 'B', 'R', 'G'),
+    /// Bayer GRBG 8bit raw format.
+    /// https://docs.kernel.org/userspace-api/media/v4l/pixfmt-srggb8.html#v4l2-pix-fmt-sgrbg8
+    GRBG8 = MAKE_FOURCC_CODE('G', 'R', 'B', 'G'),
+    /// Bayer RGGB 8bit raw format.
+    /// https://docs.kernel.org/userspace-api/media/v4l/pixfmt-srggb8.html#v4l2-pix-fmt-srggb8
+    RGGB8 = MAKE_FOURCC_CODE('R', 'G', 'G', 'B'),
+    /// Bayer BGGR 16bit raw format (little-endian).
+    /// https://docs.kernel.org/userspace-api/media/v4l/pixfmt-srggb16.html#v4l2-pix-fmt-sbggr16
+    BGGR16 = MAKE_FOURCC_CODE('B', 'Y', 'R', '2'),
+    /// Bayer GBRG 16bit raw format (little-endian).
+    /// https://docs.kernel.org/userspace-api/media/v4l/pixfmt-srggb16.html#v4l2-pix-fmt-sgbrg16
+    GBRG16 = MAKE_FOURCC_CODE('G', 'B', '1', '6'),
+    /// Bayer GRBG 16bit raw format (little-endian).
+    /// https://docs.kernel.org/userspace-api/media/v4l/pixfmt-srggb16.html#v4l2-pix-fmt-sgrbg16
+    GRBG16 = MAKE_FOURCC_CODE('G', 'R', '1', '6'),
+    /// Bayer RGGB 16bit raw format (little-endian).
+    /// https://docs.kernel.org/userspace-api/media/v4l/pixfmt-srggb16.html#v4l2-pix-fmt-srggb16
+    RGGB16 = MAKE_FOURCC_CODE('R', 'G', '1', '6'),
     /// JPEG compressed format.
     /// https://docs.kernel.org/userspace-api/media/v4l/pixfmt-compressed.html#v4l2-pix-fmt-jpeg
     JPEG  = MAKE_FOURCC_CODE('J', 'P', 'E', 'G'),
@@ -62,6 +87,11 @@ enum class Fourcc
 
 
 
+/// Cache of derived frame representations (internal).
+class FrameCache;
+
+
+
 /**
  * @brief Video frame class.
  */
@@ -82,7 +112,9 @@ public:
 
     /**
      * @brief Class constructor with parameters. This constructor allocates
-     * memory according to frame size and format,
+     * memory according to frame size and format. Frame stays empty if pixel
+     * format is not supported, width or height is negative or data size
+     * doesn't fit address space.
      * @param width Frame width (pixels).
      * @param height Frame height (pixels).
      * @param fourcc FOURCC code of data format.
@@ -90,7 +122,7 @@ public:
      * @param data Pointer to data buffer. If pointer to data provided the class
      * will copy data to internal buffer.
      */
-    Frame(int width, int height, Fourcc fourcc, int size = 0, uint8_t* data = nullptr);
+    Frame(int width, int height, Fourcc fourcc, int64_t size = 0, uint8_t* data = nullptr);
 
     /**
      * @brief Copy class constructor.
@@ -98,6 +130,13 @@ public:
      */
     Frame(Frame& src);
 
+    /**
+     * @brief Move class constructor. Takes data of source frame without
+     * copying, source frame becomes empty.
+     * @param src Source class object.
+     */
+    Frame(Frame&& src);
+
     /**
      * @brief Class destructor.
      */
@@ -109,6 +148,13 @@ public:
      */
     Frame& operator= (const Frame& src);
 
+    /**
+     * @brief Move operator "=". Operator takes data of source frame without
+     * copying, source frame becomes empty.
+     * @param src Source frame object.
+     */
+    Frame& operator= (Frame&& src);
+
     /**
      * @brief Operator "!=". Operator to compare two frame objects.
      * @param src Source frame object.
@@ -136,19 +182,83 @@ public:
 
     /**
      * @brief Serialize frame data. The method will encode data with params.
+     * Header has 32-bit size field (26 bytes header) if frame data size
+     * fits 32 bits or 64-bit size field (34 bytes header) for bigger frames.
+     * Header with content hash has 64-bit size and hash fields (42 bytes).
      * @param data Pointer to data buffer.
-     *             Buffer size mus be >= frame data size + 26.
+     *             Buffer size mus be >= getSerializedSize(withHash).
      * @param size Size of serialized data.
+     * @param withHash Write content hash (see getHash()) to header.
+     */
+    void serialize(uint8_t* data, int64_t& size, bool withHash = false);
+
+    /**
+     * @brief Serialize frame data if serialized data size fits int.
+     * @param data Pointer to data buffer.
+     *             Buffer size mus be >= getSerializedSize(withHash).
+     * @param size Size of serialized data or 0 if size doesn't fit int (data
+     * is not written).
+     * @param withHash Write content hash (see getHash()) to header.
+     */
+    void serialize(uint8_t* data, int& size, bool withHash = false);
+
+    /**
+     * @brief Get size of serialized frame.
+     * @param withHash Header with content hash.
+     * @return Size of serialized data (bytes).
      */
-    void serialize(uint8_t* data, int& size);
+    int64_t getSerializedSize(bool withHash = false) const;
 
     /**
-     * @brief Deserialize data to frame object.
+     * @brief Deserialize data to frame object. Supports all header variants.
+     * Content hash from header is cached by frame.
      * @param data Pointer to serialized data.
      * @param size Size of serialized data.
      * @return TRUE if the data deserialized or FALSE.
      */
-    bool deserialize(uint8_t* data, int size);
+    bool deserialize(uint8_t* data, int64_t size);
+
+    /**
+     * @brief Get derived representation of frame (other pixel format and/or
+     * size) from frame cache. First request converts frame, next requests
+     * with the same pixel format and size get the same read-only frame.
+     * Method is thread-safe. Cache is invalidated when frame data is
+     * written by frame methods and library functions, when frame data
+     * pointer, size or frame ID is changed and by invalidateCache().
+     * @param fourcc Pixel format. Supported: RGB24, BGR24, GRAY, YUYV, UYVY,
+     * NV12, NV21, YU12 and YV12 (frame pixel format for any raw source).
+     * @param width Width (pixels). 0 - frame width.
+     * @param height Height (pixels). 0 - frame height.
+     * @return Derived frame or nullptr if conversion is not supported.
+     */
+    std::shared_ptr<const Frame> getDerived(Fourcc fourcc, int width = 0,
+                                            int height = 0) const;
+
+    /**
+     * @brief Invalidate cache of derived representations and content hash.
+     * Must be called after frame data is written directly (through data
+     * pointer).
+     */
+    void invalidateCache();
+
+    /**
+     * @brief Get content hash of frame data (see getDataHash(...) in
+     * FrameHash.h). First request calculates hash (large frames by 1 MB
+     * bands in parallel), next requests get cached value. Hash is kept by
+     * frame cache (see getDerived(...)) and is copied by copy constructor,
+     * operator "=", cloneTo(...) and serialization with hash. Hash is not
+     * updated when frame data is written directly through data pointer:
+     * invalidateCache() must be called after such writes. Method is
+     * thread-safe.
+     * @return 64-bit hash of frame data.
+     */
+    uint64_t getHash() const;
+
+    /**
+     * @brief Check if content hash is calculated.
+     * @return TRUE if hash of current frame data is cached or FALSE.
+     */
+    bool hasHash() const;
 
     /// Frame width (pixels).
     int width{0};
@@ -157,7 +267,7 @@ public:
     /// FOURCC code of data format.
     Fourcc fourcc{Fourcc::YUV24};
     /// Frame data size (bytes).
-    int size{0};
+    int64_t size{0};
     /// ID of frame.
     int frameId{0};
     /// ID of video source.
@@ -167,8 +277,20 @@ public:
 
 private:
 
+    /// Stream deserializer keeps content hash from header.
+    friend class FrameDeserializer;
+
+    /// Get cache (created on first request).
+    FrameCache* getCache() const;
+    /// Get cached content hash.
+    bool getCachedHash(uint64_t& hash) const;
+    /// Copy cached content hash of frame with the same data.
+    void copyHash(const Frame& src);
+
     /// Flag data allocation.
     bool m_isAllocated{false};
+    /// Cache of derived representations (created on first request).
+    mutable std::atomic<FrameCache*> m_cache{nullptr};
 };
 }
 }
\ No newline at end of file
@@ -0,0 +1,233 @@
+#include "FrameBatch.h"
+#include "FrameCopy.h"
+#include "FrameKernels.h"
+#include "FrameVersion.h"
+
+
+
+// Link namespaces.
+using namespace std;
+using namespace std::chrono;
+using namespace cr::video;
+
+
+
+void FrameBatchWriter::setFlushPolicy(int maxBytes, int maxLatencyMs)
+{
+    m_maxBytes = maxBytes > 0 ? maxBytes : 0;
+    m_maxLatencyMs = maxLatencyMs > 0 ? maxLatencyMs : 0;
+}
+
+
+
+bool FrameBatchWriter::add(const Frame& frame)
+{
+    // Check frame.
+    if (frame.size < 0 || (frame.size > 0 && frame.data == nullptr))
+        return false;
+
+    // Check batch size.
+    int64_t newSize = (int64_t)getSize() + frame.size + RECORD_SIZE;
+    if (newSize > INT32_MAX || (m_maxBytes > 0 && m_count > 0 && newSize > m_maxBytes))
+        return false;
+
+    // Remove table of contents of finished batch.
+    if (m_isFinished)
+    {
+        m_size -= m_toc.size();
+        m_isFinished = false;
+    }
+
+    // Append frame data (buffer is not zero-filled before copy).
+    reserve(m_size + (size_t)frame.size);
+    if (frame.size > 0)
+        copyData(&m_buffer[m_size], frame.data, (size_t)frame.size);
+    m_size += (size_t)frame.size;
+
+    // Add record to table of contents.
+    uint8_t record[RECORD_SIZE];
+    uint32_t fourcc = (uint32_t)frame.fourcc;
+    int32_t size = (int32_t)frame.size;
+    memcpy(&record[0], &frame.width, 4);
+    memcpy(&record[4], &frame.height, 4);
+    memcpy(&record[8], &fourcc, 4);
+    memcpy(&record[12], &size, 4);
+    memcpy(&record[16], &frame.frameId, 4);
+    memcpy(&record[20], &frame.sourceId, 4);
+    m_toc.insert(m_toc.end(), record, record + RECORD_SIZE);
+
+    if (m_count == 0)
+        m_firstTime = steady_clock::now();
+    ++m_count;
+
+    return true;
+}
+
+
+
+bool FrameBatchWriter::isReady() const
+{
+    if (m_count == 0)
+        return false;
+    if (m_maxBytes > 0 && getSize() >= m_maxBytes)
+        return true;
+    return m_maxLatencyMs > 0 &&
+           steady_clock::now() - m_firstTime >= milliseconds(m_maxLatencyMs);
+}
+
+
+
+int FrameBatchWriter::getFramesCount() const
+{
+    return m_count;
+}
+
+
+
+int FrameBatchWriter::getSize() const
+{
+    return (int)(m_size + (m_isFinished ? 0 : m_toc.size()));
+}
+
+
+
+const uint8_t* FrameBatchWriter::getData(int& size)
+{
+    if (!m_isFinished)
+    {
+        // Header.
+        int tocOffset = (int)m_size;
+        reserve(m_size + m_toc.size());
+        m_buffer[0] = FRAME_MAJOR_VERSION;
+        m_buffer[1] = FRAME_MINOR_VERSION;
+        memcpy(&m_buffer[2], &m_count, 4);
+        memcpy(&m_buffer[6], &tocOffset, 4);
+
+        // Table of contents.
+        if (!m_toc.empty())
+            memcpy(&m_buffer[m_size], m_toc.data(), m_toc.size());
+        m_size += m_toc.size();
+        m_isFinished = true;
+    }
+
+    size = (int)m_size;
+    return m_buffer.get();
+}
+
+
+
+void FrameBatchWriter::clear()
+{
+    m_size = HEADER_SIZE;
+    m_toc.clear();
+    m_count = 0;
+    m_isFinished = false;
+}
+
+
+
+void FrameBatchWriter::reserve(size_t size)
+{
+    if (size <= m_capacity)
+        return;
+
+    // New buffer: twice bigger, at least maximum batch size.
+    size_t capacity = 2 * m_capacity;
+    if (capacity < (size_t)m_maxBytes)
+        capacity = (size_t)m_maxBytes;
+    if (capacity < size)
+        capacity = size;
+    unique_ptr<uint8_t[]> buffer(new uint8_t[capacity]);
+    if (m_buffer != nullptr)
+        copyData(buffer.get(), m_buffer.get(), m_size);
+    m_buffer = move(buffer);
+    m_capacity = capacity;
+}
+
+
+
+bool FrameBatchReader::open(uint8_t* data, int size)
+{
+    m_data = nullptr;
+    m_toc = nullptr;
+    m_offsets.clear();
+
+    // Check header.
+    if (data == nullptr || size < FrameBatchWriter::HEADER_SIZE ||
+        data[0] != FRAME_MAJOR_VERSION || data[1] != FRAME_MINOR_VERSION)
+        return false;
+    int count = 0;
+    int tocOffset = 0;
+    memcpy(&count, &data[2], 4);
+    memcpy(&tocOffset, &data[6], 4);
+    if (count < 0 || tocOffset < FrameBatchWriter::HEADER_SIZE ||
+        (int64_t)tocOffset + (int64_t)count * FrameBatchWriter::RECORD_SIZE != size)
+        return false;
+
+    // Check sizes of frames.
+    const uint8_t* toc = &data[tocOffset];
+    m_offsets.resize(count);
+    int64_t offset = FrameBatchWriter::HEADER_SIZE;
+    for (int i = 0; i < count; ++i)
+    {
+        int frameSize = 0;
+        memcpy(&frameSize, &toc[i * FrameBatchWriter::RECORD_SIZE + 12], 4);
+        if (frameSize < 0 || offset + frameSize > tocOffset)
+        {
+            m_offsets.clear();
+            return false;
+        }
+        m_offsets[i] = (int)offset;
+        offset += frameSize;
+    }
+    if (offset != tocOffset)
+    {
+        m_offsets.clear();
+        return false;
+    }
+
+    m_data = data;
+    m_toc = toc;
+    return true;
+}
+
+
+
+int FrameBatchReader::getFramesCount() const
+{
+    return (int)m_offsets.size();
+}
+
+
+
+bool FrameBatchReader::getFrame(int index, Frame& frame) const
+{
+    if (index < 0 || index >= (int)m_offsets.size())
+        return false;
+
+    // Check record: data must cover raw frame of record geometry.
+    const uint8_t* record = &m_toc[index * FrameBatchWriter::RECORD_SIZE];
+    int32_t width = 0;
+    int32_t height = 0;
+    uint32_t fourcc = 0;
+    int32_t size = 0;
+    memcpy(&width, &record[0], 4);
+    memcpy(&height, &record[4], 4);
+    memcpy(&fourcc, &record[8], 4);
+    memcpy(&size, &record[12], 4);
+    if (kernels::getBufferSize((Fourcc)fourcc, width, height) < 0 ||
+        kernels::getDataSize((Fourcc)fourcc, width, height) > size)
+        return false;
+
+    // Release frame memory and point to batch data.
+    frame.release();
+    frame.width = width;
+    frame.height = height;
+    frame.size = size;
+    memcpy(&frame.frameId, &record[16], 4);
+    memcpy(&frame.sourceId, &record[20], 4);
+    frame.fourcc = (Fourcc)fourcc;
+    frame.data = frame.size > 0 ? &m_data[m_offsets[index]] : nullptr;
+
+    return true;
+}
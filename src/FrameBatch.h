@@ -0,0 +1,166 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Frame.h"
+
+
+
+namespace cr
+{
+namespace video
+{
+
+/**
+ * @brief Writer of frame batches: packs frames into one contiguous buffer
+ * to send many frames by one write call. Batch format: version (2 bytes,
+ * the same as frame serialization), number of frames (4 bytes), offset of
+ * table of contents (4 bytes), frames data one after another, table of
+ * contents (for each frame: width, height, FOURCC, data size, frame ID and
+ * source ID, 4 bytes each - fields of frame serialization header).
+ */
+class FrameBatchWriter
+{
+public:
+
+    /**
+     * @brief Batch header size (bytes).
+     */
+    static const int HEADER_SIZE = 10;
+
+    /**
+     * @brief Size of table of contents record of one frame (bytes).
+     */
+    static const int RECORD_SIZE = 24;
+
+    /**
+     * @brief Set flush policy.
+     * @param maxBytes Maximum batch size (bytes, with header and table of
+     * contents). 0 - not limited.
+     * @param maxLatencyMs Maximum time from adding first frame to batch
+     * until batch is ready to flush (milliseconds). 0 - not limited.
+     */
+    void setFlushPolicy(int maxBytes, int maxLatencyMs);
+
+    /**
+     * @brief Add frame to batch. Frame data is copied.
+     * @param frame Frame.
+     * @return TRUE if the frame added or FALSE if batch size would exceed
+     * maximum size (flush batch and add frame again) or frame is not valid.
+     * Frame bigger than maximum size is added to empty batch.
+     */
+    bool add(const Frame& frame);
+
+    /**
+     * @brief Check if batch should be flushed according to flush policy.
+     * @return TRUE if batch is not empty and it reached maximum size or
+     * maximum latency.
+     */
+    bool isReady() const;
+
+    /**
+     * @brief Get number of frames in batch.
+     * @return Number of frames.
+     */
+    int getFramesCount() const;
+
+    /**
+     * @brief Get batch size with header and table of contents.
+     * @return Batch size (bytes).
+     */
+    int getSize() const;
+
+    /**
+     * @brief Finish batch: write table of contents. Data stays valid until
+     * next add(...) or clear() call.
+     * @param size Output batch size (bytes).
+     * @return Pointer to batch data.
+     */
+    const uint8_t* getData(int& size);
+
+    /**
+     * @brief Remove all frames from batch (after batch sent). Memory is kept
+     * for next batch.
+     */
+    void clear();
+
+private:
+
+    /**
+     * @brief Reserve buffer capacity keeping buffer data. Capacity grows
+     * geometrically and at least to maximum batch size, so frames are copied
+     * once in most cases.
+     * @param size Required capacity (bytes).
+     */
+    void reserve(size_t size);
+
+    /// Batch buffer: header and frames data (and table of contents when
+    /// batch is finished). Buffer is not initialized.
+    std::unique_ptr<uint8_t[]> m_buffer;
+    /// Size of buffer data (bytes).
+    size_t m_size{HEADER_SIZE};
+    /// Buffer capacity (bytes).
+    size_t m_capacity{0};
+    /// Table of contents.
+    std::vector<uint8_t> m_toc;
+    /// Number of frames.
+    int m_count{0};
+    /// Table of contents is written to buffer.
+    bool m_isFinished{false};
+    /// Maximum batch size (bytes).
+    int m_maxBytes{0};
+    /// Maximum latency (milliseconds).
+    int m_maxLatencyMs{0};
+    /// Time of adding first frame.
+    std::chrono::steady_clock::time_point m_firstTime;
+};
+
+
+
+/**
+ * @brief Zero-copy reader of frame batches. Frames returned by reader point
+ * to batch data (memory is not copied) and stay valid while batch data is
+ * valid.
+ */
+class FrameBatchReader
+{
+public:
+
+    /**
+     * @brief Open batch: check header and table of contents.
+     * @param data Pointer to batch data.
+     * @param size Batch size (bytes).
+     * @return TRUE if the batch is valid or FALSE if not.
+     */
+    bool open(uint8_t* data, int size);
+
+    /**
+     * @brief Get number of frames in opened batch.
+     * @return Number of frames.
+     */
+    int getFramesCount() const;
+
+    /**
+     * @brief Get frame from batch without copying data. Memory of output
+     * frame is released and frame data pointer is set to batch data.
+     * @param index Frame index.
+     * @param frame Output frame.
+     * @return TRUE if the frame is set or FALSE if index is not valid or
+     * frame record is not valid (data size is smaller than size of raw frame
+     * of record geometry, negative width or height, unknown FOURCC). Output
+     * frame is not changed in case of error.
+     */
+    bool getFrame(int index, Frame& frame) const;
+
+private:
+
+    /// Batch data.
+    uint8_t* m_data{nullptr};
+    /// Table of contents.
+    const uint8_t* m_toc{nullptr};
+    /// Offsets of frames data.
+    std::vector<int> m_offsets;
+};
+}
+}
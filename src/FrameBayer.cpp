@@ -0,0 +1,322 @@
+#include <climits>
+#include <vector>
+#include "FrameBayer.h"
+#include "FrameKernels.h"
+
+
+
+// Link namespaces.
+using namespace std;
+using namespace cr::video;
+using namespace cr::video::kernels;
+
+
+
+namespace
+{
+
+/// Padding of Bayer rows (pixels) required by kernels.
+const int g_pad = 2;
+
+
+
+/// Bayer pattern description.
+struct BayerPattern
+{
+    /// Pixel with even index in even row is green.
+    bool greenFirst{false};
+    /// Color presented in even row is red.
+    bool redRow{false};
+    /// 16bit data.
+    bool is16bit{false};
+};
+
+
+
+/// Get Bayer pattern description.
+bool getPattern(Fourcc fourcc, BayerPattern& pattern)
+{
+    switch (fourcc)
+    {
+    case Fourcc::RGGB8:
+    case Fourcc::RGGB16:
+        pattern.greenFirst = false;
+        pattern.redRow = true;
+        break;
+    case Fourcc::BGGR8:
+    case Fourcc::BGGR16:
+        pattern.greenFirst = false;
+        pattern.redRow = false;
+        break;
+    case Fourcc::GRBG8:
+    case Fourcc::GRBG16:
+        pattern.greenFirst = true;
+        pattern.redRow = true;
+        break;
+    case Fourcc::GBRG8:
+    case Fourcc::GBRG16:
+        pattern.greenFirst = true;
+        pattern.redRow = false;
+        break;
+    default:
+        return false;
+    }
+
+    pattern.is16bit = fourcc == Fourcc::RGGB16 || fourcc == Fourcc::BGGR16 ||
+                      fourcc == Fourcc::GRBG16 || fourcc == Fourcc::GBRG16;
+    return true;
+}
+
+
+
+/// Reflect coordinate (without border duplication) to range [0, size).
+inline int reflect(int value, int size)
+{
+    if (value < 0)
+        return -value;
+    if (value >= size)
+        return 2 * size - 2 - value;
+    return value;
+}
+
+
+
+/**
+ * @brief Demosaicing of rows band. Keeps small ring buffers of padded
+ * Bayer rows and green rows so every source row is read once per band.
+ */
+class BayerBand
+{
+public:
+
+    BayerBand(const Frame& src, const BayerPattern& pattern, DemosaicMethod method) :
+        m_src(src), m_pattern(pattern), m_method(method),
+        m_stride(src.width + 2 * g_pad),
+        m_raw(5 * m_stride), m_green(3 * m_stride), m_rgb(6 * src.width)
+    {
+        for (int i = 0; i < 5; ++i)
+            m_rawY[i] = INT_MIN;
+        for (int i = 0; i < 3; ++i)
+            m_greenY[i] = INT_MIN;
+    }
+
+    /// Get planar R, G and B rows (index 0 or 1 of rows pair) for row y.
+    void process(int y, int index, uint8_t*& r, uint8_t*& g, uint8_t*& b);
+
+private:
+
+    /// Get padded Bayer row.
+    const uint8_t* raw(int y);
+
+    /// Get padded green row (edge-aware method).
+    const uint8_t* green(int y);
+
+    /// Pad row by reflection.
+    void pad(uint8_t* row)
+    {
+        int w = m_src.width;
+        row[-1] = row[1];
+        row[-2] = row[2];
+        row[w] = row[w - 2];
+        row[w + 1] = row[w - 3];
+    }
+
+    /// Check if pixel with even index in row is green.
+    bool greenFirst(int y) const
+    {
+        return (y & 1) == 0 ? m_pattern.greenFirst : !m_pattern.greenFirst;
+    }
+
+    /// Check if color presented in row is red.
+    bool redRow(int y) const
+    {
+        return (y & 1) == 0 ? m_pattern.redRow : !m_pattern.redRow;
+    }
+
+    const Frame& m_src;
+    BayerPattern m_pattern;
+    DemosaicMethod m_method;
+    int m_stride;
+    vector<uint8_t> m_raw;
+    vector<uint8_t> m_green;
+    vector<uint8_t> m_rgb;
+    int m_rawY[5];
+    int m_greenY[3];
+};
+
+
+
+const uint8_t* BayerBand::raw(int y)
+{
+    int slot = (y + 10) % 5;
+    uint8_t* row = &m_raw[slot * m_stride + g_pad];
+    if (m_rawY[slot] == y)
+        return row;
+
+    // Copy source row. 16bit data is reduced by high bytes.
+    int w = m_src.width;
+    int srcY = reflect(y, m_src.height);
+    if (m_pattern.is16bit)
+    {
+        const uint8_t* src = &m_src.data[(size_t)srcY * w * 2 + 1];
+        for (int x = 0; x < w; ++x)
+            row[x] = src[2 * x];
+    }
+    else
+    {
+        memcpy(row, &m_src.data[(size_t)srcY * w], w);
+    }
+    pad(row);
+
+    m_rawY[slot] = y;
+    return row;
+}
+
+
+
+const uint8_t* BayerBand::green(int y)
+{
+    int slot = (y + 3) % 3;
+    uint8_t* row = &m_green[slot * m_stride + g_pad];
+    if (m_greenY[slot] == y)
+        return row;
+
+    // Rows outside frame are reflected.
+    int srcY = reflect(y, m_src.height);
+    const uint8_t* rows[5];
+    for (int i = 0; i < 5; ++i)
+        rows[i] = raw(srcY - 2 + i);
+    getTable().bayerGreenRow(rows, m_src.width, greenFirst(srcY), row);
+    pad(row);
+
+    m_greenY[slot] = y;
+    return row;
+}
+
+
+
+void BayerBand::process(int y, int index, uint8_t*& r, uint8_t*& g, uint8_t*& b)
+{
+    int w = m_src.width;
+    r = &m_rgb[(3 * index + 0) * w];
+    g = &m_rgb[(3 * index + 1) * w];
+    b = &m_rgb[(3 * index + 2) * w];
+    uint8_t* own = redRow(y) ? r : b;
+    uint8_t* other = redRow(y) ? b : r;
+
+    if (m_method == DemosaicMethod::BILINEAR)
+    {
+        const uint8_t* rows[3] = {raw(y - 1), raw(y), raw(y + 1)};
+        getTable().bayerBilinearRow(rows, w, greenFirst(y), own, g, other);
+        return;
+    }
+
+    // Green rows first because they use wider window of Bayer rows.
+    const uint8_t* greens[3] = {green(y - 1), green(y), green(y + 1)};
+    const uint8_t* rows[3] = {raw(y - 1), raw(y), raw(y + 1)};
+    getTable().bayerColorRow(rows, greens, w, greenFirst(y), own, other);
+    memcpy(g, greens[1], w);
+}
+
+
+
+/// Interleave planar rows to packed 24bit row.
+void packRow(const uint8_t* c0, const uint8_t* c1, const uint8_t* c2,
+             uint8_t* dst, int width)
+{
+    for (int x = 0; x < width; ++x)
+    {
+        dst[3 * x + 0] = c0[x];
+        dst[3 * x + 1] = c1[x];
+        dst[3 * x + 2] = c2[x];
+    }
+}
+
+
+
+/// Convert two planar RGB rows to NV12 rows.
+void rgbToNv12Rows(uint8_t* const r[2], uint8_t* const g[2], uint8_t* const b[2],
+                   uint8_t* y0, uint8_t* y1, uint8_t* uv, int width)
+{
+    for (int x = 0; x < width; ++x)
+    {
+        y0[x] = rgbToY(r[0][x], g[0][x], b[0][x]);
+        y1[x] = rgbToY(r[1][x], g[1][x], b[1][x]);
+    }
+
+    for (int x = 0; x < width; x += 2)
+    {
+        int rs = (r[0][x] + r[0][x + 1] + r[1][x] + r[1][x + 1] + 2) >> 2;
+        int gs = (g[0][x] + g[0][x + 1] + g[1][x] + g[1][x + 1] + 2) >> 2;
+        int bs = (b[0][x] + b[0][x + 1] + b[1][x] + b[1][x + 1] + 2) >> 2;
+        uv[x] = rgbToU(rs, gs, bs);
+        uv[x + 1] = rgbToV(rs, gs, bs);
+    }
+}
+}
+
+
+
+bool cr::video::isBayer(Fourcc fourcc)
+{
+    BayerPattern pattern;
+    return getPattern(fourcc, pattern);
+}
+
+
+
+bool cr::video::demosaic(const Frame& src, Frame& dst, Fourcc dstFourcc,
+                         DemosaicMethod method)
+{
+    // Check params.
+    BayerPattern pattern;
+    if (!getPattern(src.fourcc, pattern) || &src == &dst)
+        return false;
+    if (src.data == nullptr || src.width < 4 || src.height < 4 ||
+        src.size < getDataSize(src.fourcc, src.width, src.height))
+        return false;
+    if (dstFourcc != Fourcc::RGB24 &&
+        dstFourcc != Fourcc::BGR24 &&
+        dstFourcc != Fourcc::NV12)
+        return false;
+    if (dstFourcc == Fourcc::NV12 && (src.width % 2 != 0 || src.height % 2 != 0))
+        return false;
+
+    // Prepare output frame.
+    if (!prepareFrame(dst, src.width, src.height, dstFourcc))
+        return false;
+    dst.frameId = src.frameId;
+    dst.sourceId = src.sourceId;
+
+    // Process pairs of rows in parallel.
+    const int w = src.width;
+    const int h = src.height;
+    parallelFor((h + 1) / 2, 8, [&](int begin, int end)
+    {
+        BayerBand band(src, pattern, method);
+        uint8_t* r[2];
+        uint8_t* g[2];
+        uint8_t* b[2];
+        for (int pair = begin; pair < end; ++pair)
+        {
+            int y = 2 * pair;
+            int rows = y + 1 < h ? 2 : 1;
+            for (int i = 0; i < rows; ++i)
+            {
+                band.process(y + i, i, r[i], g[i], b[i]);
+                if (dstFourcc == Fourcc::RGB24)
+                    packRow(r[i], g[i], b[i], &dst.data[(size_t)(y + i) * w * 3], w);
+                else if (dstFourcc == Fourcc::BGR24)
+                    packRow(b[i], g[i], r[i], &dst.data[(size_t)(y + i) * w * 3], w);
+            }
+
+            if (dstFourcc == Fourcc::NV12)
+                rgbToNv12Rows(r, g, b,
+                              &dst.data[(size_t)y * w],
+                              &dst.data[(size_t)(y + 1) * w],
+                              &dst.data[(size_t)w * h + (size_t)pair * w], w);
+        }
+    });
+
+    return true;
+}
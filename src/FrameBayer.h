@@ -0,0 +1,49 @@
+#pragma once
+#include "Frame.h"
+
+
+
+namespace cr
+{
+namespace video
+{
+
+/**
+ * @brief Demosaicing methods.
+ */
+enum class DemosaicMethod
+{
+    /// Bilinear interpolation. Fastest method.
+    BILINEAR = 0,
+    /// Edge-aware interpolation. Green color is interpolated along edges
+    /// (Hamilton-Adams), red and blue colors are interpolated by color
+    /// differences. Less color artifacts on edges but slower.
+    EDGE_AWARE = 1
+};
+
+
+
+/**
+ * @brief Check if pixel format is Bayer raw format.
+ * @param fourcc Pixel format.
+ * @return TRUE if the format is Bayer format or FALSE if not.
+ */
+bool isBayer(Fourcc fourcc);
+
+/**
+ * @brief Convert Bayer raw frame to color frame (demosaicing). 16bit Bayer
+ * data is reduced to 8bit by 8 most significant bits. Function uses SIMD
+ * kernels and library thread pool (see FrameCompute.h).
+ * @param src Source frame with Bayer pixel format. Width and height must
+ * be >= 4.
+ * @param dst Output frame. Memory will be reallocated if output frame has
+ * another size or pixel format. Function copies frame ID and source ID.
+ * @param dstFourcc Output pixel format: RGB24, BGR24 or NV12. NV12 requires
+ * even width and height.
+ * @param method Demosaicing method.
+ * @return TRUE if the frame converted or FALSE if not.
+ */
+bool demosaic(const Frame& src, Frame& dst, Fourcc dstFourcc,
+              DemosaicMethod method = DemosaicMethod::BILINEAR);
+}
+}
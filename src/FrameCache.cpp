@@ -0,0 +1,218 @@
+#include <vector>
+#include "FrameCache.h"
+#include "FrameBayer.h"
+#include "FrameCopy.h"
+#include "FrameHash.h"
+#include "FrameKernels.h"
+#include "FrameMosaic.h"
+
+
+
+// Link namespaces.
+using namespace std;
+using namespace cr::video;
+using namespace cr::video::kernels;
+
+
+
+namespace
+{
+
+/// Convert frame to other pixel format and size.
+shared_ptr<const Frame> convert(const Frame& frame, Fourcc fourcc, int width, int height)
+{
+    // Check params.
+    if (frame.data == nullptr || width <= 0 || height <= 0 ||
+        getDataSize(fourcc, width, height) <= 0 ||
+        frame.size < getDataSize(frame.fourcc, frame.width, frame.height))
+        return nullptr;
+    shared_ptr<Frame> dst = make_shared<Frame>(width, height, fourcc);
+    if (dst->data == nullptr)
+        return nullptr;
+    dst->frameId = frame.frameId;
+    dst->sourceId = frame.sourceId;
+
+    // The same pixel format and size: copy.
+    if (fourcc == frame.fourcc && width == frame.width && height == frame.height)
+    {
+        copyData(dst->data, frame.data, (size_t)dst->size);
+        return dst;
+    }
+
+    // Bayer source: demosaic directly or to intermediate BGR24 frame.
+    const Frame* src = &frame;
+    Frame rgb;
+    if (isBayer(frame.fourcc))
+    {
+        if (width == frame.width && height == frame.height &&
+            (fourcc == Fourcc::RGB24 || fourcc == Fourcc::BGR24 || fourcc == Fourcc::NV12))
+            return demosaic(frame, *dst, fourcc) ? dst : nullptr;
+        if (!demosaic(frame, rgb, Fourcc::BGR24))
+            return nullptr;
+        src = &rgb;
+    }
+
+    // Scale and convert.
+    FrameMosaic mosaic;
+    vector<MosaicCell> cells(1);
+    cells[0].width = width;
+    cells[0].height = height;
+    if (!mosaic.setLayout(cells) || !mosaic.compose(&src, 1, *dst))
+        return nullptr;
+
+    return dst;
+}
+}
+
+
+
+shared_ptr<const Frame> FrameCache::get(const Frame& frame, Fourcc fourcc,
+                                        int width, int height)
+{
+    unique_lock<mutex> lock(m_mutex);
+    checkState(frame);
+
+    // Representation is ready or is being converted by other thread.
+    Key key((uint32_t)fourcc, width, height);
+    auto entry = m_entries.find(key);
+    if (entry != m_entries.end())
+    {
+        shared_future<shared_ptr<const Frame>> result = entry->second;
+        lock.unlock();
+        return result.get();
+    }
+
+    // Convert frame without lock.
+    promise<shared_ptr<const Frame>> result;
+    m_entries[key] = result.get_future().share();
+    lock.unlock();
+    shared_ptr<const Frame> derived = convert(frame, fourcc, width, height);
+    result.set_value(derived);
+
+    return derived;
+}
+
+
+
+bool FrameCache::getHash(const Frame& frame, uint64_t& hash)
+{
+    lock_guard<mutex> lock(m_mutex);
+    checkState(frame);
+    hash = m_hash;
+    return m_hasHash;
+}
+
+
+
+void FrameCache::setHash(const Frame& frame, uint64_t hash)
+{
+    lock_guard<mutex> lock(m_mutex);
+    checkState(frame);
+    m_hash = hash;
+    m_hasHash = true;
+}
+
+
+
+void FrameCache::clear()
+{
+    lock_guard<mutex> lock(m_mutex);
+    m_entries.clear();
+    m_hasHash = false;
+    m_data = nullptr;
+}
+
+
+
+void FrameCache::checkState(const Frame& frame)
+{
+    if (frame.data != m_data || frame.width != m_width || frame.height != m_height ||
+        frame.fourcc != m_fourcc || frame.size != m_size ||
+        frame.frameId != m_frameId || frame.sourceId != m_sourceId)
+    {
+        m_entries.clear();
+        m_hasHash = false;
+        m_data = frame.data;
+        m_width = frame.width;
+        m_height = frame.height;
+        m_fourcc = frame.fourcc;
+        m_size = frame.size;
+        m_frameId = frame.frameId;
+        m_sourceId = frame.sourceId;
+    }
+}
+
+
+
+shared_ptr<const Frame> Frame::getDerived(Fourcc _fourcc, int _width, int _height) const
+{
+    return getCache()->get(*this, _fourcc, _width > 0 ? _width : width,
+                           _height > 0 ? _height : height);
+}
+
+
+
+uint64_t Frame::getHash() const
+{
+    FrameCache* cache = getCache();
+    uint64_t hash = 0;
+    if (cache->getHash(*this, hash))
+        return hash;
+
+    // Calculate hash without lock: concurrent requests calculate the same
+    // value.
+    hash = getDataHash(data, size > 0 ? (size_t)size : 0);
+    cache->setHash(*this, hash);
+    return hash;
+}
+
+
+
+bool Frame::hasHash() const
+{
+    uint64_t hash = 0;
+    return getCachedHash(hash);
+}
+
+
+
+bool Frame::getCachedHash(uint64_t& hash) const
+{
+    FrameCache* cache = m_cache.load();
+    return cache != nullptr && cache->getHash(*this, hash);
+}
+
+
+
+void Frame::copyHash(const Frame& src)
+{
+    uint64_t hash = 0;
+    if (src.getCachedHash(hash))
+        getCache()->setHash(*this, hash);
+}
+
+
+
+FrameCache* Frame::getCache() const
+{
+    // Create cache on first request.
+    FrameCache* cache = m_cache.load();
+    if (cache == nullptr)
+    {
+        FrameCache* created = new FrameCache();
+        if (m_cache.compare_exchange_strong(cache, created))
+            cache = created;
+        else
+            delete created;
+    }
+    return cache;
+}
+
+
+
+void Frame::invalidateCache()
+{
+    FrameCache* cache = m_cache.load();
+    if (cache != nullptr)
+        cache->clear();
+}
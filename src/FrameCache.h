@@ -0,0 +1,88 @@
+#pragma once
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include "Frame.h"
+
+
+
+/*
+ * Internal header. Declares cache of derived frame representations and
+ * content hash used by Frame::getDerived(...) and Frame::getHash().
+ */
+
+
+
+namespace cr
+{
+namespace video
+{
+
+/**
+ * @brief Cache of derived representations and content hash of one frame.
+ */
+class FrameCache
+{
+public:
+
+    /**
+     * @brief Get derived representation. First request converts frame,
+     * concurrent requests of the same representation wait for it.
+     * @param frame Source frame (owner of cache).
+     * @param fourcc Pixel format.
+     * @param width Width (pixels).
+     * @param height Height (pixels).
+     * @return Derived frame or nullptr if conversion is not supported.
+     */
+    std::shared_ptr<const Frame> get(const Frame& frame, Fourcc fourcc,
+                                     int width, int height);
+
+    /**
+     * @brief Get cached content hash.
+     * @param frame Source frame (owner of cache).
+     * @param hash Output hash.
+     * @return TRUE if hash of current frame state is cached or FALSE.
+     */
+    bool getHash(const Frame& frame, uint64_t& hash);
+
+    /**
+     * @brief Set content hash of current frame state.
+     * @param frame Source frame (owner of cache).
+     * @param hash Hash.
+     */
+    void setHash(const Frame& frame, uint64_t hash);
+
+    /**
+     * @brief Remove all representations and hash.
+     */
+    void clear();
+
+private:
+
+    /// Drop cached data of previous frame state (mutex must be locked).
+    void checkState(const Frame& frame);
+
+    /// Representation key: pixel format, width and height.
+    typedef std::tuple<uint32_t, int, int> Key;
+
+    /// Representations.
+    std::map<Key, std::shared_future<std::shared_ptr<const Frame>>> m_entries;
+    /// Source frame state of cached representations.
+    const uint8_t* m_data{nullptr};
+    int m_width{0};
+    int m_height{0};
+    Fourcc m_fourcc{Fourcc::YUV24};
+    int64_t m_size{0};
+    int m_frameId{0};
+    int m_sourceId{0};
+    /// Content hash.
+    uint64_t m_hash{0};
+    /// Flag of cached content hash.
+    bool m_hasHash{false};
+    /// Mutex.
+    std::mutex m_mutex;
+};
+}
+}
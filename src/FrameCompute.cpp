@@ -0,0 +1,297 @@
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "FrameCompute.h"
+#include "FrameNuma.h"
+#if defined(FRAME_SIMD)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+
+
+// Link namespaces.
+using namespace std;
+using namespace cr::video;
+
+
+
+namespace
+{
+
+/// Thread pool to run parts of parallel loops.
+class ThreadPool
+{
+public:
+
+    ThreadPool(int count, int node) : m_node(node)
+    {
+        for (int i = 0; i < count; ++i)
+            m_threads.emplace_back(&ThreadPool::process, this);
+    }
+
+    ~ThreadPool()
+    {
+        {
+            lock_guard<mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cond.notify_all();
+        for (auto& thread : m_threads)
+            thread.join();
+    }
+
+    void run(function<void()> task)
+    {
+        {
+            lock_guard<mutex> lock(m_mutex);
+            m_tasks.push_back(move(task));
+        }
+        m_cond.notify_one();
+    }
+
+private:
+
+    void process();
+
+    int m_node;
+    vector<thread> m_threads;
+    deque<function<void()>> m_tasks;
+    mutex m_mutex;
+    condition_variable m_cond;
+    bool m_stop{false};
+};
+
+
+
+/// Flag of thread pool thread.
+thread_local bool g_isPoolThread = false;
+/// Current SIMD level.
+atomic<int> g_simdLevel{-1};
+/// Thread pool mutex.
+mutex g_poolMutex;
+/// Thread pools: not pinned threads (index 0) and threads of NUMA nodes.
+vector<shared_ptr<ThreadPool>> g_pools;
+/// Number of threads in thread pools including caller thread.
+vector<int> g_poolsThreads;
+/// Number of threads set by user. 0 - hardware threads.
+atomic<int> g_threadsCount{0};
+
+
+
+void ThreadPool::process()
+{
+    g_isPoolThread = true;
+    if (m_node >= 0)
+        setThreadNumaNode(m_node);
+    while (true)
+    {
+        function<void()> task;
+        {
+            unique_lock<mutex> lock(m_mutex);
+            m_cond.wait(lock, [this]{ return m_stop || !m_tasks.empty(); });
+            if (m_stop && m_tasks.empty())
+                return;
+            task = move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        task();
+    }
+}
+
+
+
+/// Detect SIMD level supported by CPU.
+SimdLevel detectSimdLevel()
+{
+#if defined(FRAME_SIMD)
+    uint32_t regs[4] = {0, 0, 0, 0};
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    uint32_t maxLeaf = (uint32_t)info[0];
+    if (maxLeaf < 1)
+        return SimdLevel::SCALAR;
+    __cpuid(info, 1);
+    regs[2] = (uint32_t)info[2];
+#else
+    uint32_t maxLeaf = __get_cpuid_max(0, nullptr);
+    if (maxLeaf < 1)
+        return SimdLevel::SCALAR;
+    __get_cpuid(1, &regs[0], &regs[1], &regs[2], &regs[3]);
+#endif
+
+    // SSSE3 (bit 9) and SSE4.1 (bit 19).
+    if ((regs[2] & (1u << 9)) == 0 || (regs[2] & (1u << 19)) == 0)
+        return SimdLevel::SCALAR;
+
+    // OSXSAVE (bit 27), AVX (bit 28) and F16C (bit 29).
+    const uint32_t avxMask = (1u << 27) | (1u << 28) | (1u << 29);
+    if ((regs[2] & avxMask) != avxMask || maxLeaf < 7)
+        return SimdLevel::SSE41;
+
+    // Check that OS saves YMM registers.
+#if defined(_MSC_VER)
+    uint64_t xcr0 = _xgetbv(0);
+#else
+    uint32_t xcr0Low = 0;
+    uint32_t xcr0High = 0;
+    __asm__ volatile("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+    uint64_t xcr0 = ((uint64_t)xcr0High << 32) | xcr0Low;
+#endif
+    if ((xcr0 & 6) != 6)
+        return SimdLevel::SSE41;
+
+    // AVX2 (leaf 7, EBX bit 5).
+#if defined(_MSC_VER)
+    __cpuidex(info, 7, 0);
+    regs[1] = (uint32_t)info[1];
+#else
+    __cpuid_count(7, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+    if ((regs[1] & (1u << 5)) == 0)
+        return SimdLevel::SSE41;
+
+    return SimdLevel::AVX2;
+#else
+    return SimdLevel::SCALAR;
+#endif
+}
+
+
+
+/// Get thread pool of NUMA node (-1 - not pinned) for current threads count.
+shared_ptr<ThreadPool> getPool(int threads, int node)
+{
+    lock_guard<mutex> lock(g_poolMutex);
+    size_t index = (size_t)(node + 1);
+    if (g_pools.size() <= index)
+    {
+        g_pools.resize(index + 1);
+        g_poolsThreads.resize(index + 1, 0);
+    }
+    if (g_pools[index] == nullptr || g_poolsThreads[index] != threads)
+    {
+        g_pools[index] = make_shared<ThreadPool>(threads - 1, node);
+        g_poolsThreads[index] = threads;
+    }
+    return g_pools[index];
+}
+}
+
+
+
+SimdLevel cr::video::getMaxSimdLevel()
+{
+    static const SimdLevel level = detectSimdLevel();
+    return level;
+}
+
+
+
+SimdLevel cr::video::getSimdLevel()
+{
+    int level = g_simdLevel.load(memory_order_relaxed);
+    if (level < 0)
+        return getMaxSimdLevel();
+    return (SimdLevel)level;
+}
+
+
+
+bool cr::video::setSimdLevel(SimdLevel level)
+{
+    // Check CPU support.
+    if ((int)level > (int)getMaxSimdLevel())
+        return false;
+
+    g_simdLevel.store((int)level, memory_order_relaxed);
+    return true;
+}
+
+
+
+void cr::video::setThreadsCount(int count)
+{
+    g_threadsCount.store(count < 0 ? 0 : count, memory_order_relaxed);
+}
+
+
+
+int cr::video::getThreadsCount()
+{
+    int count = g_threadsCount.load(memory_order_relaxed);
+    if (count > 0)
+        return count;
+
+    count = (int)thread::hardware_concurrency();
+    return count > 0 ? count : 1;
+}
+
+
+
+void cr::video::parallelFor(int count, int grain, const function<void(int, int)>& func)
+{
+    parallelForNode(-1, count, grain, func);
+}
+
+
+
+void cr::video::parallelForNode(int node, int count, int grain,
+                                const function<void(int, int)>& func)
+{
+    // Check params.
+    if (count <= 0)
+        return;
+    if (grain < 1)
+        grain = 1;
+
+    // Calculate number of parts.
+    int threads = getThreadsCount();
+    int parts = (count + grain - 1) / grain;
+    if (parts > threads)
+        parts = threads;
+
+    // Run in caller thread for small ranges and nested calls.
+    if (parts <= 1 || g_isPoolThread)
+    {
+        func(0, count);
+        return;
+    }
+
+    // Pools of nodes are used only on NUMA machines.
+    if (node < 0 || node >= getNumaNodesCount() || getNumaNodesCount() == 1)
+        node = -1;
+    shared_ptr<ThreadPool> pool = getPool(threads, node);
+
+    // Run parts except first in thread pool.
+    mutex doneMutex;
+    condition_variable doneCond;
+    int pending = parts - 1;
+    for (int i = 1; i < parts; ++i)
+    {
+        int begin = (int)((int64_t)count * i / parts);
+        int end = (int)((int64_t)count * (i + 1) / parts);
+        pool->run([&, begin, end]()
+        {
+            func(begin, end);
+            lock_guard<mutex> lock(doneMutex);
+            if (--pending == 0)
+                doneCond.notify_one();
+        });
+    }
+
+    // Run first part in caller thread.
+    func(0, (int)((int64_t)count / parts));
+
+    // Wait other parts.
+    unique_lock<mutex> lock(doneMutex);
+    doneCond.wait(lock, [&pending]{ return pending == 0; });
+}
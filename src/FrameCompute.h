@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+
+
+
+namespace cr
+{
+namespace video
+{
+
+/**
+ * @brief SIMD instruction set levels used by frame processing functions.
+ */
+enum class SimdLevel
+{
+    /// Portable C++ code without SIMD intrinsics.
+    SCALAR = 0,
+    /// SSE4.1 (including SSSE3) instruction set.
+    SSE41 = 1,
+    /// AVX2 (including F16C) instruction set.
+    AVX2 = 2
+};
+
+
+
+/**
+ * @brief Get highest SIMD level supported by CPU and by library build.
+ * @return SIMD level.
+ */
+SimdLevel getMaxSimdLevel();
+
+/**
+ * @brief Get SIMD level used by frame processing functions. By default the
+ * library uses highest supported SIMD level.
+ * @return SIMD level.
+ */
+SimdLevel getSimdLevel();
+
+/**
+ * @brief Force SIMD level used by frame processing functions. Can be used
+ * to compare results and performance of different implementations.
+ * @param level SIMD level.
+ * @return TRUE if the level is set or FALSE if CPU doesn't support it.
+ */
+bool setSimdLevel(SimdLevel level);
+
+/**
+ * @brief Set number of threads used by frame processing functions.
+ * @param count Number of threads. 0 - number of hardware threads,
+ * 1 - processing in caller thread only.
+ */
+void setThreadsCount(int count);
+
+/**
+ * @brief Get number of threads used by frame processing functions.
+ * @return Number of threads.
+ */
+int getThreadsCount();
+
+/**
+ * @brief Run function for range [0, count) split into parts processed in
+ * parallel by library thread pool. Caller thread processes one part and
+ * waits for others. Nested calls from pool threads run in caller thread.
+ * @param count Number of items (for example frame rows).
+ * @param grain Minimum number of items in one part.
+ * @param func Function to process items [begin, end).
+ */
+void parallelFor(int count, int grain, const std::function<void(int, int)>& func);
+
+/**
+ * @brief The same as parallelFor(...) but parts are processed by threads
+ * pinned to CPUs of NUMA node (see FrameNuma.h). Each node has own thread
+ * pool created on first call. Caller thread processes one part too, so to
+ * process all parts on node caller thread must be pinned to the node (see
+ * setThreadNumaNode(...)). On systems with one node works as parallelFor(...).
+ * @param node NUMA node index or -1 (not pinned threads).
+ * @param count Number of items (for example frame rows).
+ * @param grain Minimum number of items in one part.
+ * @param func Function to process items [begin, end).
+ */
+void parallelForNode(int node, int count, int grain,
+                     const std::function<void(int, int)>& func);
+}
+}
@@ -0,0 +1,139 @@
+#include <atomic>
+#include "FrameCopy.h"
+#include "FrameCompute.h"
+#include "FrameKernels.h"
+
+
+
+// Link namespaces.
+using namespace std;
+using namespace cr::video;
+using namespace cr::video::kernels;
+
+
+
+namespace
+{
+
+/// Size of band of parallel copy (bytes).
+const size_t g_bandBytes = (size_t)1 << 20;
+/// Minimum number of bands processed by one task.
+const int g_grainBands = 4;
+/// Threshold of streaming copy (bytes).
+atomic<size_t> g_streamBytes{(size_t)4 << 20};
+/// Threshold of parallel copy (bytes).
+atomic<size_t> g_parallelBytes{(size_t)32 << 20};
+
+
+
+/// Select copy strategy by data size.
+CopyStrategy selectStrategy(size_t size, CopyStrategy strategy)
+{
+    if (strategy != CopyStrategy::AUTO)
+        return strategy;
+    if (size < g_streamBytes.load(memory_order_relaxed))
+        return CopyStrategy::MEMCPY;
+    if (size < g_parallelBytes.load(memory_order_relaxed))
+        return CopyStrategy::STREAM;
+    return CopyStrategy::PARALLEL;
+}
+}
+
+
+
+void cr::video::setCopyThresholds(size_t streamBytes, size_t parallelBytes)
+{
+    g_streamBytes.store(streamBytes, memory_order_relaxed);
+    g_parallelBytes.store(parallelBytes, memory_order_relaxed);
+}
+
+
+
+void cr::video::getCopyThresholds(size_t& streamBytes, size_t& parallelBytes)
+{
+    streamBytes = g_streamBytes.load(memory_order_relaxed);
+    parallelBytes = g_parallelBytes.load(memory_order_relaxed);
+}
+
+
+
+void cr::video::copyData(uint8_t* dst, const uint8_t* src, size_t size,
+                         CopyStrategy strategy)
+{
+    if (dst == nullptr || src == nullptr || size == 0)
+        return;
+
+    const KernelTable& table = getTable();
+    switch (selectStrategy(size, strategy))
+    {
+    case CopyStrategy::STREAM:
+        table.streamCopy(dst, src, size);
+        return;
+    case CopyStrategy::PARALLEL:
+        break;
+    default:
+        memcpy(dst, src, size);
+        return;
+    }
+
+    // Bands of streaming copy in parallel.
+    const int bands = (int)((size + g_bandBytes - 1) / g_bandBytes);
+    parallelFor(bands, g_grainBands, [&](int begin, int end)
+    {
+        size_t first = (size_t)begin * g_bandBytes;
+        size_t last = (size_t)end * g_bandBytes;
+        if (last > size)
+            last = size;
+        table.streamCopy(dst + first, src + first, last - first);
+    });
+}
+
+
+
+bool cr::video::copyPlane(const FramePlane& src, const FramePlane& dst,
+                          CopyStrategy strategy)
+{
+    // Check params (strides must be positive).
+    if (src.data == nullptr || dst.data == nullptr || src.width <= 0 || src.height <= 0 ||
+        src.elementSize <= 0 || dst.width != src.width || dst.height != src.height ||
+        dst.elementSize != src.elementSize || src.stride <= 0 || dst.stride <= 0)
+        return false;
+    const ptrdiff_t srcStride = src.stride;
+    const ptrdiff_t dstStride = dst.stride;
+    const size_t rowBytes = (size_t)src.width * (size_t)src.elementSize;
+    if ((size_t)srcStride < rowBytes || (size_t)dstStride < rowBytes)
+        return false;
+
+    // Continuous planes are copied as one block.
+    const size_t size = rowBytes * (size_t)src.height;
+    if ((size_t)srcStride == rowBytes && (size_t)dstStride == rowBytes)
+    {
+        copyData(dst.data, src.data, size, strategy);
+        return true;
+    }
+
+    // Rows.
+    strategy = selectStrategy(size, strategy);
+    const KernelTable& table = getTable();
+    auto copyRows = [&](int begin, int end)
+    {
+        for (int y = begin; y < end; ++y)
+        {
+            uint8_t* to = dst.data + (ptrdiff_t)y * dstStride;
+            const uint8_t* from = src.data + (ptrdiff_t)y * srcStride;
+            if (strategy == CopyStrategy::MEMCPY)
+                memcpy(to, from, rowBytes);
+            else
+                table.streamCopy(to, from, rowBytes);
+        }
+    };
+    if (strategy != CopyStrategy::PARALLEL)
+    {
+        copyRows(0, src.height);
+        return true;
+    }
+    const int grainRows = (int)(g_grainBands * g_bandBytes / rowBytes) + 1;
+    parallelFor(src.height, grainRows, copyRows);
+
+    return true;
+}
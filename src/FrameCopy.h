@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "FramePlane.h"
+
+
+
+namespace cr
+{
+namespace video
+{
+
+/**
+ * @brief Strategies of data copy.
+ */
+enum class CopyStrategy
+{
+    /// Strategy selected by size (see setCopyThresholds(...)).
+    AUTO = 0,
+    /// Regular memcpy (data stays in cache).
+    MEMCPY = 1,
+    /// Non-temporal streaming stores which bypass cache (SIMD builds,
+    /// memcpy for scalar SIMD level).
+    STREAM = 2,
+    /// Streaming copy split into bands processed by library thread pool.
+    PARALLEL = 3
+};
+
+
+
+/**
+ * @brief Set thresholds of automatic copy strategy: data smaller than
+ * stream threshold is copied by memcpy, data smaller than parallel
+ * threshold by streaming stores and bigger data by parallel streaming copy.
+ * Defaults: 4 MB and 32 MB.
+ * @param streamBytes Stream threshold (bytes).
+ * @param parallelBytes Parallel threshold (bytes).
+ */
+void setCopyThresholds(size_t streamBytes, size_t parallelBytes);
+
+/**
+ * @brief Get thresholds of automatic copy strategy.
+ * @param streamBytes Stream threshold (bytes).
+ * @param parallelBytes Parallel threshold (bytes).
+ */
+void getCopyThresholds(size_t& streamBytes, size_t& parallelBytes);
+
+/**
+ * @brief Copy data. Used by Frame copy operations.
+ * @param dst Destination. Must not overlap source.
+ * @param src Source.
+ * @param size Size (bytes).
+ * @param strategy Copy strategy.
+ */
+void copyData(uint8_t* dst, const uint8_t* src, size_t size,
+              CopyStrategy strategy = CopyStrategy::AUTO);
+
+/**
+ * @brief Copy plane with any strides (for example field view, see
+ * FrameDeinterlace.h, or region of bigger plane). Strategy is selected by
+ * total size of plane rows. Strides must be positive and not less than row
+ * size.
+ * @param src Source plane.
+ * @param dst Destination plane with the same width, height and element size.
+ * Must not overlap source.
+ * @param strategy Copy strategy.
+ * @return TRUE if the plane is copied or FALSE if parameters not valid.
+ */
+bool copyPlane(const FramePlane& src, const FramePlane& dst,
+               CopyStrategy strategy = CopyStrategy::AUTO);
+}
+}
@@ -0,0 +1,244 @@
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include "FrameCountersImpl.h"
+
+
+
+// Link namespaces.
+using namespace std;
+using namespace cr::video;
+using namespace cr::video::counters;
+
+
+
+namespace
+{
+
+#if defined(FRAME_COUNTERS)
+/// Number of counters.
+const int g_countersCount = (int)Counter::COUNT;
+/// Number of operations with latency sampling.
+const int g_operationsCount = 4;
+
+
+
+/// Counters of one thread. Only owner thread writes counters.
+struct ThreadCounters
+{
+    ThreadCounters();
+    ~ThreadCounters();
+
+    /// Counters values.
+    atomic<uint64_t> values[g_countersCount];
+    /// Number of operations calls (for latency sampling).
+    uint32_t calls{0};
+};
+
+
+
+/// Counters of all threads.
+struct Registry
+{
+    /// Mutex to protect list of threads, retired counters and baseline.
+    mutex threadsMutex;
+    /// Counters of running threads.
+    vector<ThreadCounters*> threads;
+    /// Counters of finished threads.
+    uint64_t retired[g_countersCount]{};
+    /// Counters at last reset.
+    uint64_t baseline[g_countersCount]{};
+};
+
+
+
+/// Latency statistics of operation.
+struct LatencyValues
+{
+    atomic<uint64_t> samples{0};
+    atomic<uint64_t> totalNs{0};
+    atomic<uint64_t> maxNs{0};
+};
+
+
+
+/// Registry is never destroyed: threads can finish after static objects.
+Registry& getRegistry()
+{
+    static Registry* registry = new Registry();
+    return *registry;
+}
+
+
+
+/// Counters of calling thread.
+thread_local ThreadCounters t_counters;
+/// Latency sampling period.
+atomic<int> g_samplingPeriod{0};
+/// Latency statistics of operations.
+LatencyValues g_latency[g_operationsCount];
+
+
+
+ThreadCounters::ThreadCounters()
+{
+    for (auto& value : values)
+        value.store(0, memory_order_relaxed);
+    Registry& registry = getRegistry();
+    lock_guard<mutex> lock(registry.threadsMutex);
+    registry.threads.push_back(this);
+}
+
+
+
+ThreadCounters::~ThreadCounters()
+{
+    Registry& registry = getRegistry();
+    lock_guard<mutex> lock(registry.threadsMutex);
+    for (int i = 0; i < g_countersCount; ++i)
+        registry.retired[i] += values[i].load(memory_order_relaxed);
+    for (size_t i = 0; i < registry.threads.size(); ++i)
+    {
+        if (registry.threads[i] == this)
+        {
+            registry.threads.erase(registry.threads.begin() + (long)i);
+            break;
+        }
+    }
+}
+
+
+
+/// Sum of counters of all threads (registry must be locked).
+void getTotals(Registry& registry, uint64_t totals[g_countersCount])
+{
+    for (int i = 0; i < g_countersCount; ++i)
+        totals[i] = registry.retired[i];
+    for (ThreadCounters* thread : registry.threads)
+        for (int i = 0; i < g_countersCount; ++i)
+            totals[i] += thread->values[i].load(memory_order_relaxed);
+}
+#endif
+}
+
+
+
+void cr::video::counters::add(Counter counter, uint64_t value)
+{
+#if defined(FRAME_COUNTERS)
+    // Only owner thread writes: no read-modify-write atomic operation.
+    atomic<uint64_t>& current = t_counters.values[(int)counter];
+    current.store(current.load(memory_order_relaxed) + value, memory_order_relaxed);
+#else
+    (void)counter;
+    (void)value;
+#endif
+}
+
+
+
+LatencyScope::LatencyScope(FrameOperation operation) : m_operation(operation)
+{
+#if defined(FRAME_COUNTERS)
+    int period = g_samplingPeriod.load(memory_order_relaxed);
+    if (period > 0 && ++t_counters.calls % (uint32_t)period == 0)
+    {
+        m_isSampled = true;
+        m_start = chrono::steady_clock::now();
+    }
+#endif
+}
+
+
+
+LatencyScope::~LatencyScope()
+{
+#if defined(FRAME_COUNTERS)
+    if (!m_isSampled)
+        return;
+    uint64_t time = (uint64_t)chrono::duration_cast<chrono::nanoseconds>(
+                    chrono::steady_clock::now() - m_start).count();
+    LatencyValues& latency = g_latency[(int)m_operation];
+    latency.samples.fetch_add(1, memory_order_relaxed);
+    latency.totalNs.fetch_add(time, memory_order_relaxed);
+    uint64_t maxTime = latency.maxNs.load(memory_order_relaxed);
+    while (time > maxTime &&
+           !latency.maxNs.compare_exchange_weak(maxTime, time, memory_order_relaxed));
+#endif
+}
+
+
+
+bool cr::video::isCountersEnabled()
+{
+#if defined(FRAME_COUNTERS)
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+
+FrameCounters cr::video::getCounters()
+{
+    FrameCounters result;
+#if defined(FRAME_COUNTERS)
+    uint64_t totals[g_countersCount];
+    {
+        Registry& registry = getRegistry();
+        lock_guard<mutex> lock(registry.threadsMutex);
+        getTotals(registry, totals);
+        for (int i = 0; i < g_countersCount; ++i)
+            totals[i] -= registry.baseline[i];
+    }
+    result.allocations = totals[(int)Counter::ALLOCATIONS];
+    result.frees = totals[(int)Counter::FREES];
+    result.bytesAllocated = totals[(int)Counter::BYTES_ALLOCATED];
+    result.bytesZeroed = totals[(int)Counter::BYTES_ZEROED];
+    result.bytesCopied = totals[(int)Counter::BYTES_COPIED];
+    result.copies = totals[(int)Counter::COPIES];
+    result.compares = totals[(int)Counter::COMPARES];
+    result.serializations = totals[(int)Counter::SERIALIZATIONS];
+    result.deserializations = totals[(int)Counter::DESERIALIZATIONS];
+    for (int i = 0; i < g_operationsCount; ++i)
+    {
+        result.latency[i].samples = g_latency[i].samples.load(memory_order_relaxed);
+        result.latency[i].totalNs = g_latency[i].totalNs.load(memory_order_relaxed);
+        result.latency[i].maxNs = g_latency[i].maxNs.load(memory_order_relaxed);
+    }
+#endif
+    return result;
+}
+
+
+
+void cr::video::resetCounters()
+{
+#if defined(FRAME_COUNTERS)
+    // Counters of threads are not written by other threads: reset keeps
+    // current totals as baseline.
+    {
+        Registry& registry = getRegistry();
+        lock_guard<mutex> lock(registry.threadsMutex);
+        getTotals(registry, registry.baseline);
+    }
+    for (auto& latency : g_latency)
+    {
+        latency.samples.store(0, memory_order_relaxed);
+        latency.totalNs.store(0, memory_order_relaxed);
+        latency.maxNs.store(0, memory_order_relaxed);
+    }
+#endif
+}
+
+
+
+void cr::video::setLatencySampling(int period)
+{
+#if defined(FRAME_COUNTERS)
+    g_samplingPeriod.store(period < 0 ? 0 : period, memory_order_relaxed);
+#else
+    (void)period;
+#endif
+}
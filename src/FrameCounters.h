@@ -0,0 +1,98 @@
+#pragma once
+#include <cstdint>
+
+
+
+namespace cr
+{
+namespace video
+{
+
+/**
+ * @brief Frame operations with latency sampling.
+ */
+enum class FrameOperation
+{
+    /// Deep copy (copy constructor and operator=).
+    COPY = 0,
+    /// Comparison (operator== and operator!=).
+    COMPARE = 1,
+    /// Serialization.
+    SERIALIZE = 2,
+    /// Deserialization.
+    DESERIALIZE = 3
+};
+
+
+
+/**
+ * @brief Latency statistics of sampled calls of operation.
+ */
+struct FrameLatency
+{
+    /// Number of sampled calls.
+    uint64_t samples{0};
+    /// Total time of sampled calls (nanoseconds).
+    uint64_t totalNs{0};
+    /// Maximum time of sampled call (nanoseconds).
+    uint64_t maxNs{0};
+};
+
+
+
+/**
+ * @brief Snapshot of frame counters (sum of counters of all threads since
+ * last reset).
+ */
+struct FrameCounters
+{
+    /// Number of frame data allocations.
+    uint64_t allocations{0};
+    /// Number of frame data releases.
+    uint64_t frees{0};
+    /// Bytes of allocated frame data.
+    uint64_t bytesAllocated{0};
+    /// Bytes of frame data filled by zeros.
+    uint64_t bytesZeroed{0};
+    /// Bytes of frame data copied (copies, serialization and deserialization).
+    uint64_t bytesCopied{0};
+    /// Number of deep copies (copy constructor and operator=).
+    uint64_t copies{0};
+    /// Number of comparisons (operator== and operator!=).
+    uint64_t compares{0};
+    /// Number of serialize(...) calls.
+    uint64_t serializations{0};
+    /// Number of deserialize(...) calls.
+    uint64_t deserializations{0};
+    /// Latency statistics of operations (index - FrameOperation).
+    FrameLatency latency[4];
+};
+
+
+
+/**
+ * @brief Check if counters are compiled in library (FRAME_COUNTERS CMake
+ * option). If not, counting code is not compiled and snapshots are empty.
+ * @return TRUE if counters are enabled or FALSE if not.
+ */
+bool isCountersEnabled();
+
+/**
+ * @brief Get snapshot of counters. Method is thread-safe.
+ * @return Counters since last reset.
+ */
+FrameCounters getCounters();
+
+/**
+ * @brief Reset counters and latency statistics.
+ */
+void resetCounters();
+
+/**
+ * @brief Set latency sampling period: every N-th call of operation in each
+ * thread is timed. Disabled by default.
+ * @param period Sampling period. 0 - sampling disabled, 1 - every call.
+ */
+void setLatencySampling(int period);
+}
+}
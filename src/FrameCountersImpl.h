@@ -0,0 +1,90 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include "FrameCounters.h"
+
+
+
+/*
+ * Internal header. Declares macros to update frame counters. If library is
+ * built without FRAME_COUNTERS definition macros expand to nothing.
+ */
+
+
+
+namespace cr
+{
+namespace video
+{
+namespace counters
+{
+
+/**
+ * @brief Counters (the same order as fields of FrameCounters).
+ */
+enum class Counter
+{
+    ALLOCATIONS = 0,
+    FREES,
+    BYTES_ALLOCATED,
+    BYTES_ZEROED,
+    BYTES_COPIED,
+    COPIES,
+    COMPARES,
+    SERIALIZATIONS,
+    DESERIALIZATIONS,
+    COUNT
+};
+
+/**
+ * @brief Add value to counter of calling thread.
+ * @param counter Counter.
+ * @param value Value.
+ */
+void add(Counter counter, uint64_t value);
+
+/**
+ * @brief Scope of operation call: time of call is recorded if call is
+ * sampled.
+ */
+class LatencyScope
+{
+public:
+
+    /**
+     * @brief Class constructor. Starts timer if call is sampled.
+     * @param operation Operation.
+     */
+    explicit LatencyScope(FrameOperation operation);
+
+    /**
+     * @brief Class destructor. Records time of sampled call.
+     */
+    ~LatencyScope();
+
+private:
+
+    /// Operation.
+    FrameOperation m_operation;
+    /// Flag of sampled call.
+    bool m_isSampled{false};
+    /// Start time of sampled call.
+    std::chrono::steady_clock::time_point m_start;
+};
+}
+}
+}
+
+
+
+#if defined(FRAME_COUNTERS)
+/// Add value to counter.
+#define FRAME_COUNT(counter, value) \
+    cr::video::counters::add(cr::video::counters::Counter::counter, (uint64_t)(value))
+/// Sample latency of operation till the end of scope.
+#define FRAME_LATENCY(operation) \
+    cr::video::counters::LatencyScope frameLatencyScope(cr::video::FrameOperation::operation)
+#else
+#define FRAME_COUNT(counter, value) ((void)0)
+#define FRAME_LATENCY(operation) ((void)0)
+#endif
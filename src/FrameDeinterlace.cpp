@@ -0,0 +1,185 @@
+#include <cstring>
+#include "FrameDeinterlace.h"
+#include "FrameBayer.h"
+#include "FrameCompute.h"
+#include "FrameKernels.h"
+#include "FrameLut.h"
+
+
+
+// Link namespaces.
+using namespace cr::video;
+using namespace cr::video::kernels;
+
+
+
+namespace
+{
+
+/// Minimum number of rows processed by one task.
+const int g_grainRows = 16;
+
+
+
+/// Get planes of frame supported by deinterlacers.
+int getDeinterlacePlanes(const Frame& frame, FramePlane planes[3])
+{
+    if (isBayer(frame.fourcc) || getSampleBits(frame.fourcc) != 8 || frame.height < 2)
+        return 0;
+    return getPlanes(frame, planes);
+}
+
+
+
+/// Bob or motion-adaptive deinterlacing (previous frame is set).
+bool processField(const Frame& src, const Frame* previous, Field field,
+                  int threshold, Frame& dst)
+{
+    // Check params.
+    FramePlane planes[3];
+    FramePlane previousPlanes[3];
+    int count = getDeinterlacePlanes(src, planes);
+    if (count == 0 || (field != Field::TOP && field != Field::BOTTOM))
+        return false;
+    if (previous != nullptr &&
+        (previous == &dst || threshold < 0 || threshold > 255 ||
+         previous->width != src.width || previous->height != src.height ||
+         previous->fourcc != src.fourcc || getPlanes(*previous, previousPlanes) != count))
+        return false;
+
+    // Prepare output frame.
+    const bool isInPlace = &dst == &src;
+    if (!isInPlace)
+    {
+        if (!prepareFrame(dst, src.width, src.height, src.fourcc))
+            return false;
+        dst.frameId = src.frameId;
+        dst.sourceId = src.sourceId;
+    }
+    else
+    {
+        dst.invalidateCache();
+    }
+    FramePlane dstPlanes[3];
+    getPlanes(dst, dstPlanes);
+
+    const KernelTable& table = getTable();
+    const int fieldRow = (int)field;
+    for (int p = 0; p < count; ++p)
+    {
+        const FramePlane& s = planes[p];
+        const FramePlane& d = dstPlanes[p];
+        const int rowBytes = s.width * s.elementSize;
+        parallelFor(s.height, g_grainRows, [&](int begin, int end)
+        {
+            for (int y = begin; y < end; ++y)
+            {
+                const uint8_t* row = &s.data[(size_t)y * s.stride];
+                uint8_t* out = &d.data[(size_t)y * d.stride];
+
+                // Rows of field (and rows without field neighbours) are copied.
+                const bool hasAbove = y > 0;
+                const bool hasBelow = y + 1 < s.height;
+                if ((y & 1) == fieldRow || (!hasAbove && !hasBelow))
+                {
+                    if (!isInPlace)
+                        memcpy(out, row, rowBytes);
+                    continue;
+                }
+
+                const int above = hasAbove ? y - 1 : y + 1;
+                const int below = hasBelow ? y + 1 : y - 1;
+                const uint8_t* old = previous == nullptr ? nullptr :
+                                     &previousPlanes[p].data[(size_t)y * s.stride];
+                table.deinterlaceRow(&s.data[(size_t)above * s.stride],
+                                     &s.data[(size_t)below * s.stride], row, old,
+                                     threshold, rowBytes, out);
+            }
+        });
+    }
+
+    return true;
+}
+}
+
+
+
+int cr::video::getFieldPlanes(const Frame& frame, Field field, FramePlane planes[3])
+{
+    if (planes == nullptr || (field != Field::TOP && field != Field::BOTTOM))
+        return 0;
+    int count = getPlanes(frame, planes);
+    for (int p = 0; p < count; ++p)
+    {
+        // Every field must have at least one row in every plane.
+        FramePlane& plane = planes[p];
+        if (plane.height < 2)
+            return 0;
+        plane.data += (size_t)plane.stride * (int)field;
+        plane.height = (plane.height - (int)field + 1) / 2;
+        plane.stride *= 2;
+    }
+    return count;
+}
+
+
+
+bool cr::video::deinterlaceBob(const Frame& src, Field field, Frame& dst)
+{
+    return processField(src, nullptr, field, 0, dst);
+}
+
+
+
+bool cr::video::deinterlaceWeave(const Frame& top, const Frame& bottom, Frame& dst)
+{
+    // Check params.
+    FramePlane topPlanes[3];
+    FramePlane bottomPlanes[3];
+    int count = getDeinterlacePlanes(top, topPlanes);
+    if (count == 0 || bottom.width != top.width || bottom.height != top.height ||
+        bottom.fourcc != top.fourcc || getPlanes(bottom, bottomPlanes) != count)
+        return false;
+
+    // Prepare output frame.
+    if (&dst != &top && &dst != &bottom)
+    {
+        if (!prepareFrame(dst, top.width, top.height, top.fourcc))
+            return false;
+    }
+    else
+    {
+        dst.invalidateCache();
+    }
+    dst.frameId = bottom.frameId;
+    dst.sourceId = bottom.sourceId;
+    FramePlane dstPlanes[3];
+    getPlanes(dst, dstPlanes);
+
+    // Copy rows which are not in output frame yet.
+    for (int p = 0; p < count; ++p)
+    {
+        const FramePlane& d = dstPlanes[p];
+        const int rowBytes = d.width * d.elementSize;
+        parallelFor(d.height, g_grainRows, [&](int begin, int end)
+        {
+            for (int y = begin; y < end; ++y)
+            {
+                const FramePlane& s = (y & 1) == 0 ? topPlanes[p] : bottomPlanes[p];
+                if (s.data != d.data)
+                    memcpy(&d.data[(size_t)y * d.stride], &s.data[(size_t)y * s.stride],
+                           rowBytes);
+            }
+        });
+    }
+
+    return true;
+}
+
+
+
+bool cr::video::deinterlaceAdaptive(const Frame& src, const Frame& previous, Field field,
+                                    int threshold, Frame& dst)
+{
+    return processField(src, &previous, field, threshold, dst);
+}
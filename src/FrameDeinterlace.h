@@ -0,0 +1,78 @@
+#pragma once
+#include "Frame.h"
+#include "FramePlane.h"
+
+
+
+namespace cr
+{
+namespace video
+{
+
+/**
+ * @brief Field of interlaced frame.
+ */
+enum class Field
+{
+    /// Even rows (0, 2, 4 ...).
+    TOP = 0,
+    /// Odd rows (1, 3, 5 ...).
+    BOTTOM = 1
+};
+
+
+
+/**
+ * @brief Get planes of one field of interlaced frame without copying data.
+ * Field planes point to frame data with doubled stride: plane data points to
+ * first row of field in plane and height is number of field rows. Rows of
+ * chroma planes of 4:2:0 formats are split in fields the same way.
+ * @param frame Interlaced frame (see getPlanes(...) in FramePlane.h for
+ * supported formats).
+ * @param field Field.
+ * @param planes Output planes (up to 3).
+ * @return Number of planes or 0 if pixel format is not supported, frame data
+ * size doesn't match frame size or frame has less than 2 rows.
+ */
+int getFieldPlanes(const Frame& frame, Field field, FramePlane planes[3]);
+
+/**
+ * @brief Bob deinterlacing: rows of field are kept and missing rows are
+ * interpolated from rows of field above and below.
+ * @param src Interlaced frame. Supported formats: raw formats with 8 bit
+ * samples except Bayer (GRAY, RGB24, BGR24, YUV24, YUYV, UYVY, NV12, NV21,
+ * YU12, YV12).
+ * @param field Field to keep.
+ * @param dst Output frame. Can be the same as src (in-place processing).
+ * @return TRUE if the frame is deinterlaced or FALSE if parameters not valid.
+ */
+bool deinterlaceBob(const Frame& src, Field field, Frame& dst);
+
+/**
+ * @brief Weave deinterlacing: top field rows are taken from first frame and
+ * bottom field rows from second frame (fields of two sequential frames).
+ * @param top Frame with top field.
+ * @param bottom Frame with bottom field. Size and pixel format must be the
+ * same as for top frame. Supported formats are the same as for bob.
+ * @param dst Output frame. Can be the same as top or bottom frame.
+ * @return TRUE if the frame is deinterlaced or FALSE if parameters not valid.
+ */
+bool deinterlaceWeave(const Frame& top, const Frame& bottom, Frame& dst);
+
+/**
+ * @brief Motion-adaptive deinterlacing: rows of field are kept, pixels of
+ * missing rows are kept if there is no motion (weave) or interpolated from
+ * rows of field above and below (bob). Pixel has motion if |current -
+ * previous| > threshold, where current and previous are values of pixel in
+ * current and previous frame.
+ * @param src Interlaced frame. Supported formats are the same as for bob.
+ * @param previous Previous frame with the same size and pixel format.
+ * @param field Field to keep.
+ * @param threshold Motion threshold [0, 255].
+ * @param dst Output frame. Can be the same as src (in-place processing).
+ * @return TRUE if the frame is deinterlaced or FALSE if parameters not valid.
+ */
+bool deinterlaceAdaptive(const Frame& src, const Frame& previous, Field field,
+                         int threshold, Frame& dst);
+}
+}
@@ -0,0 +1,212 @@
+#include <climits>
+#include <utility>
+#include "FrameDeserializer.h"
+#include "FrameCache.h"
+#include "FrameKernels.h"
+#include "FrameVersion.h"
+
+
+
+// Link namespaces.
+using namespace cr::video;
+
+
+
+void FrameDeserializer::setMaxFrameSize(int64_t size)
+{
+    m_maxFrameSize = size > 0 ? size : 0;
+}
+
+
+
+int FrameDeserializer::push(const uint8_t* data, int size)
+{
+    if (data == nullptr || size < 0)
+        return -1;
+
+    int consumed = 0;
+    while (consumed < size)
+    {
+        int bufferSize = 0;
+        uint8_t* buffer = getBuffer(bufferSize);
+        if (buffer == nullptr)
+            break;
+        int count = size - consumed < bufferSize ? size - consumed : bufferSize;
+        memcpy(buffer, data + consumed, count);
+        consumed += count;
+        if (!commit(count))
+            return -1;
+    }
+
+    return m_state == State::ERROR ? -1 : consumed;
+}
+
+
+
+uint8_t* FrameDeserializer::getBuffer(int& size)
+{
+    switch (m_state)
+    {
+    case State::HEADER:
+        size = m_headerSize - (int)m_received;
+        return &m_header[m_received];
+    case State::DATA:
+        size = m_frame.size - m_received > INT_MAX ? INT_MAX :
+               (int)(m_frame.size - m_received);
+        return &m_frame.data[m_received];
+    default:
+        size = 0;
+        return nullptr;
+    }
+}
+
+
+
+bool FrameDeserializer::commit(int size)
+{
+    // Check state.
+    int bufferSize = 0;
+    if (getBuffer(bufferSize) == nullptr || size < 0 || size > bufferSize)
+        return false;
+    m_received += size;
+
+    // Header is complete.
+    if (m_state == State::HEADER && m_received == m_headerSize)
+    {
+        // Header with 64-bit size (size field is -1) has 8 more bytes,
+        // header with content hash (size field is -2) has 16 more bytes.
+        int32_t size32 = 0;
+        memcpy(&size32, &m_header[14], 4);
+        if (m_headerSize == HEADER_SIZE && (size32 == -1 || size32 == -2))
+        {
+            m_headerSize = size32 == -1 ? LARGE_HEADER_SIZE : HASH_HEADER_SIZE;
+            return true;
+        }
+
+        if (!parseHeader())
+        {
+            m_state = State::ERROR;
+            return false;
+        }
+        m_received = 0;
+        if (m_frame.size > 0)
+            m_state = State::DATA;
+        else
+            setReady();
+    }
+    else if (m_state == State::DATA && m_received == m_frame.size)
+    {
+        setReady();
+    }
+
+    return true;
+}
+
+
+
+bool FrameDeserializer::isReady() const
+{
+    return m_state == State::READY;
+}
+
+
+
+bool FrameDeserializer::isError() const
+{
+    return m_state == State::ERROR;
+}
+
+
+
+Frame& FrameDeserializer::getFrame()
+{
+    return m_frame;
+}
+
+
+
+void FrameDeserializer::next()
+{
+    if (m_state == State::READY)
+    {
+        m_state = State::HEADER;
+        m_headerSize = HEADER_SIZE;
+        m_received = 0;
+    }
+}
+
+
+
+void FrameDeserializer::reset()
+{
+    m_state = State::HEADER;
+    m_headerSize = HEADER_SIZE;
+    m_received = 0;
+}
+
+
+
+bool FrameDeserializer::parseHeader()
+{
+    // Check frame class version.
+    if (m_header[0] != FRAME_MAJOR_VERSION || m_header[1] != FRAME_MINOR_VERSION)
+        return false;
+
+    // Get header fields.
+    int w = 0;
+    int h = 0;
+    uint32_t f = 0;
+    int32_t size32 = 0;
+    int fId = 0;
+    int sId = 0;
+    memcpy(&w, &m_header[2], 4);
+    memcpy(&h, &m_header[6], 4);
+    memcpy(&f, &m_header[10], 4);
+    memcpy(&size32, &m_header[14], 4);
+    memcpy(&fId, &m_header[18], 4);
+    memcpy(&sId, &m_header[22], 4);
+    int64_t s = size32;
+    if (m_headerSize != HEADER_SIZE)
+        memcpy(&s, &m_header[HEADER_SIZE], 8);
+    m_hasHash = m_headerSize == HASH_HEADER_SIZE;
+    if (m_hasHash)
+        memcpy(&m_hash, &m_header[LARGE_HEADER_SIZE], 8);
+
+    // Check size. Compressed frames have buffer for width * height * 4 bytes:
+    // limit is checked for allocated buffer, not only for data size. Empty
+    // frames (width or height is 0) are accepted as by Frame::deserialize(...).
+    Fourcc fourcc = (Fourcc)f;
+    int64_t capacity = kernels::getBufferSize(fourcc, w, h);
+    if (capacity < 0 || s < 0 || s > capacity ||
+        (m_maxFrameSize > 0 && capacity > m_maxFrameSize))
+        return false;
+
+    // Allocate frame memory if size or format is changed.
+    if (m_frame.width != w || m_frame.height != h || m_frame.fourcc != fourcc ||
+        (capacity > 0 && m_frame.data == nullptr))
+    {
+        m_frame.release();
+        Frame frame(w, h, fourcc);
+        if (capacity > 0 && frame.data == nullptr)
+            return false;
+        m_frame = std::move(frame);
+        m_frame.width = w;
+        m_frame.height = h;
+    }
+
+    m_frame.invalidateCache();
+    m_frame.size = s;
+    m_frame.frameId = fId;
+    m_frame.sourceId = sId;
+
+    return true;
+}
+
+
+
+void FrameDeserializer::setReady()
+{
+    m_state = State::READY;
+    if (m_hasHash)
+        m_frame.getCache()->setHash(m_frame, m_hash);
+}
@@ -0,0 +1,144 @@
+#pragma once
+#include <cstdint>
+#include "Frame.h"
+
+
+
+namespace cr
+{
+namespace video
+{
+
+/**
+ * @brief Incremental deserializer of frames from byte stream (TCP, pipe).
+ * Stream is sequence of frames serialized by Frame::serialize(...). Data
+ * can come by chunks of any size: header is parsed as soon as 26 bytes (34
+ * bytes for header with 64-bit size, 42 bytes for header with content hash)
+ * are received and frame data is received directly to frame buffer. Content
+ * hash from header is cached by frame when frame is ready. Frame
+ * memory is reused for next frames with the same size and pixel format.
+ */
+class FrameDeserializer
+{
+public:
+
+    /**
+     * @brief Serialization header size (bytes).
+     */
+    static const int HEADER_SIZE = 26;
+
+    /**
+     * @brief Size of serialization header with 64-bit frame data size
+     * (bytes).
+     */
+    static const int LARGE_HEADER_SIZE = 34;
+
+    /**
+     * @brief Size of serialization header with 64-bit frame data size and
+     * content hash (bytes).
+     */
+    static const int HASH_HEADER_SIZE = 42;
+
+    /**
+     * @brief Set maximum size of frame buffer. Frames which need bigger
+     * buffer are rejected to bound memory per stream. Buffer size is frame
+     * data size of raw formats and width * height * 4 bytes of compressed
+     * formats (JPEG, H264, HEVC) whatever data size of header is. Limit
+     * should be set for untrusted streams: without limit header with big
+     * width and height allocates big buffer.
+     * @param size Maximum size (bytes). 0 - not limited.
+     */
+    void setMaxFrameSize(int64_t size);
+
+    /**
+     * @brief Push chunk of stream. Method consumes bytes until frame is
+     * complete. If frame is ready remaining bytes are not consumed: process
+     * frame, call next() and push remaining bytes again.
+     * @param data Pointer to data.
+     * @param size Data size (bytes).
+     * @return Number of consumed bytes or -1 if stream is not valid (wrong
+     * header or frame size).
+     */
+    int push(const uint8_t* data, int size);
+
+    /**
+     * @brief Get buffer to receive next bytes of stream directly (for
+     * example by recv(...)). Buffer is header buffer or frame data buffer.
+     * @param size Maximum number of bytes to write to buffer (data of large
+     * frames is received by several buffers of up to INT_MAX bytes).
+     * @return Pointer to buffer or nullptr if frame is ready or stream is
+     * not valid.
+     */
+    uint8_t* getBuffer(int& size);
+
+    /**
+     * @brief Commit bytes written to buffer returned by getBuffer(...).
+     * @param size Number of written bytes.
+     * @return TRUE if bytes accepted or FALSE if stream is not valid.
+     */
+    bool commit(int size);
+
+    /**
+     * @brief Check if frame is ready.
+     * @return TRUE if frame is received completely.
+     */
+    bool isReady() const;
+
+    /**
+     * @brief Check if stream is not valid (wrong header or frame size).
+     * Deserializer must be reset after error.
+     * @return TRUE if stream is not valid.
+     */
+    bool isError() const;
+
+    /**
+     * @brief Get frame. Frame is valid if isReady() returns TRUE.
+     * @return Reference to frame.
+     */
+    Frame& getFrame();
+
+    /**
+     * @brief Start receiving next frame. Frame memory is kept.
+     */
+    void next();
+
+    /**
+     * @brief Drop partially received frame and error state.
+     */
+    void reset();
+
+private:
+
+    /// Receiving states.
+    enum class State
+    {
+        HEADER,
+        DATA,
+        READY,
+        ERROR
+    };
+
+    /// Parse received header and prepare frame.
+    bool parseHeader();
+    /// Set ready state.
+    void setReady();
+
+    /// Output frame.
+    Frame m_frame;
+    /// Header buffer.
+    uint8_t m_header[HASH_HEADER_SIZE]{};
+    /// Size of current header.
+    int m_headerSize{HEADER_SIZE};
+    /// Current state.
+    State m_state{State::HEADER};
+    /// Received bytes of header or frame data.
+    int64_t m_received{0};
+    /// Maximum frame data size.
+    int64_t m_maxFrameSize{0};
+    /// Content hash from header.
+    uint64_t m_hash{0};
+    /// Flag of content hash in header.
+    bool m_hasHash{false};
+};
+}
+}
@@ -0,0 +1,518 @@
+#include <atomic>
+#include <thread>
+#include "FrameGraph.h"
+
+
+
+// Link namespaces.
+using namespace std;
+using namespace cr::video;
+
+
+
+namespace cr
+{
+namespace video
+{
+
+/**
+ * @brief Work-stealing thread pool of frame graph. Each worker has own task
+ * queue: tasks submitted by worker go to its queue (processed last in first
+ * out for cache locality), idle workers steal the oldest tasks of others.
+ */
+class FrameWorkerPool
+{
+public:
+
+    explicit FrameWorkerPool(int count);
+
+    ~FrameWorkerPool();
+
+    void submit(function<void()> task);
+
+private:
+
+    /// Task queue of worker.
+    struct Queue
+    {
+        mutex queueMutex;
+        deque<function<void()>> tasks;
+    };
+
+    void run(int index);
+
+    bool pop(int index, function<void()>& task);
+
+    vector<unique_ptr<Queue>> m_queues;
+    vector<thread> m_threads;
+    /// Number of submitted tasks not taken by workers.
+    int m_pending{0};
+    bool m_stop{false};
+    mutex m_mutex;
+    condition_variable m_cond;
+    /// Next queue for tasks submitted by not worker threads.
+    atomic<unsigned> m_next{0};
+};
+}
+}
+
+
+
+namespace
+{
+
+/// Pool of worker thread.
+thread_local const FrameWorkerPool* t_pool = nullptr;
+/// Index of worker thread in pool.
+thread_local int t_workerIndex = -1;
+}
+
+
+
+FrameWorkerPool::FrameWorkerPool(int count)
+{
+    for (int i = 0; i < count; ++i)
+        m_queues.emplace_back(new Queue());
+    for (int i = 0; i < count; ++i)
+        m_threads.emplace_back(&FrameWorkerPool::run, this, i);
+}
+
+
+
+FrameWorkerPool::~FrameWorkerPool()
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cond.notify_all();
+    for (auto& worker : m_threads)
+        worker.join();
+}
+
+
+
+void FrameWorkerPool::submit(function<void()> task)
+{
+    int index = t_pool == this ? t_workerIndex :
+                (int)(m_next.fetch_add(1, memory_order_relaxed) % m_queues.size());
+    {
+        lock_guard<mutex> lock(m_queues[index]->queueMutex);
+        m_queues[index]->tasks.push_back(move(task));
+    }
+    {
+        lock_guard<mutex> lock(m_mutex);
+        ++m_pending;
+    }
+    m_cond.notify_one();
+}
+
+
+
+void FrameWorkerPool::run(int index)
+{
+    t_pool = this;
+    t_workerIndex = index;
+    while (true)
+    {
+        {
+            unique_lock<mutex> lock(m_mutex);
+            m_cond.wait(lock, [this]{ return m_stop || m_pending > 0; });
+            if (m_stop)
+                return;
+        }
+
+        function<void()> task;
+        if (!pop(index, task))
+        {
+            // Task is taken by other worker which didn't update counter yet.
+            this_thread::yield();
+            continue;
+        }
+        {
+            lock_guard<mutex> lock(m_mutex);
+            --m_pending;
+        }
+        task();
+    }
+}
+
+
+
+bool FrameWorkerPool::pop(int index, function<void()>& task)
+{
+    // Newest task of own queue.
+    {
+        Queue& own = *m_queues[index];
+        lock_guard<mutex> lock(own.queueMutex);
+        if (!own.tasks.empty())
+        {
+            task = move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // Steal oldest task of other worker.
+    const int count = (int)m_queues.size();
+    for (int i = 1; i < count; ++i)
+    {
+        Queue& other = *m_queues[(index + i) % count];
+        lock_guard<mutex> lock(other.queueMutex);
+        if (!other.tasks.empty())
+        {
+            task = move(other.tasks.front());
+            other.tasks.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+
+FrameGraph::FrameGraph()
+{
+
+}
+
+
+
+FrameGraph::~FrameGraph()
+{
+    stop(false);
+}
+
+
+
+int FrameGraph::addStage(const string& name, StageFunction function)
+{
+    lock_guard<mutex> lock(m_mutex);
+    if (m_isRunning || !function)
+        return -1;
+
+    // Input of frames pushed by user.
+    Edge input;
+    input.to = (int)m_stages.size();
+    m_edges.push_back(input);
+
+    Stage stage;
+    stage.name = name;
+    stage.function = move(function);
+    stage.inputs.push_back((int)m_edges.size() - 1);
+    m_stages.push_back(move(stage));
+
+    return (int)m_stages.size() - 1;
+}
+
+
+
+bool FrameGraph::setInput(int stage, int capacity, Backpressure mode)
+{
+    lock_guard<mutex> lock(m_mutex);
+    if (m_isRunning || stage < 0 || stage >= (int)m_stages.size() || capacity < 1)
+        return false;
+    Edge& input = m_edges[m_stages[stage].inputs[0]];
+    input.capacity = (size_t)capacity;
+    input.mode = mode;
+    return true;
+}
+
+
+
+bool FrameGraph::connect(int from, int to, int capacity, Backpressure mode)
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    // Check params.
+    const int count = (int)m_stages.size();
+    if (m_isRunning || from < 0 || from >= count || to < 0 || to >= count ||
+        from == to || capacity < 1 || hasPath(to, from))
+        return false;
+    for (int index : m_stages[from].outputs)
+        if (m_edges[index].to == to)
+            return false;
+
+    Edge edge;
+    edge.from = from;
+    edge.to = to;
+    edge.capacity = (size_t)capacity;
+    edge.mode = mode;
+    m_edges.push_back(edge);
+    m_stages[from].outputs.push_back((int)m_edges.size() - 1);
+    m_stages[to].inputs.push_back((int)m_edges.size() - 1);
+
+    return true;
+}
+
+
+
+bool FrameGraph::start(int threads)
+{
+    lock_guard<mutex> lock(m_mutex);
+    if (m_isRunning || m_stages.empty())
+        return false;
+
+    if (threads <= 0)
+        threads = (int)thread::hardware_concurrency();
+    m_pool.reset(new FrameWorkerPool(threads > 0 ? threads : 1));
+    m_isRunning = true;
+    m_startTime = chrono::steady_clock::now();
+    for (int i = 0; i < (int)m_stages.size(); ++i)
+        schedule(i);
+
+    return true;
+}
+
+
+
+bool FrameGraph::push(int stage, const Frame& frame)
+{
+    // Copy is made before lock.
+    shared_ptr<Frame> copy = make_shared<Frame>();
+    *copy = frame;
+    return push(stage, shared_ptr<const Frame>(move(copy)));
+}
+
+
+
+bool FrameGraph::push(int stage, shared_ptr<const Frame> frame)
+{
+    unique_lock<mutex> lock(m_mutex);
+    if (!m_isRunning || stage < 0 || stage >= (int)m_stages.size() || frame == nullptr)
+        return false;
+
+    // Wait for free space.
+    Edge& input = m_edges[m_stages[stage].inputs[0]];
+    if (input.mode == Backpressure::BLOCK)
+    {
+        m_spaceCond.wait(lock, [&]{ return !m_isRunning || input.queue.size() < input.capacity; });
+        if (!m_isRunning)
+            return false;
+    }
+
+    enqueue(input, frame);
+    schedule(stage);
+
+    return true;
+}
+
+
+
+void FrameGraph::flush()
+{
+    unique_lock<mutex> lock(m_mutex);
+    m_idleCond.wait(lock, [this]{ return !m_isRunning || (m_inFlight == 0 && m_scheduled == 0); });
+}
+
+
+
+void FrameGraph::stop(bool drain)
+{
+    {
+        unique_lock<mutex> lock(m_mutex);
+        if (!m_isRunning)
+            return;
+
+        if (drain)
+        {
+            m_idleCond.wait(lock, [this]{ return m_inFlight == 0 && m_scheduled == 0; });
+        }
+        else
+        {
+            for (Edge& edge : m_edges)
+            {
+                m_inFlight -= edge.queue.size();
+                edge.queue.clear();
+            }
+        }
+
+        // Wait for running stages.
+        m_isRunning = false;
+        m_spaceCond.notify_all();
+        m_idleCond.notify_all();
+        m_idleCond.wait(lock, [this]{ return m_scheduled == 0; });
+    }
+
+    // Stop worker threads.
+    m_pool.reset();
+}
+
+
+
+int FrameGraph::getStagesCount() const
+{
+    lock_guard<mutex> lock(m_mutex);
+    return (int)m_stages.size();
+}
+
+
+
+bool FrameGraph::getStats(int stage, FrameStageStats& stats) const
+{
+    lock_guard<mutex> lock(m_mutex);
+    if (stage < 0 || stage >= (int)m_stages.size())
+        return false;
+
+    const Stage& s = m_stages[stage];
+    stats.name = s.name;
+    stats.processed = s.processed;
+    stats.produced = s.produced;
+    stats.dropped = s.dropped;
+    stats.failed = s.failed;
+    stats.queued = 0;
+    for (int index : s.inputs)
+        stats.queued += (int)m_edges[index].queue.size();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - m_startTime).count();
+    stats.throughput = seconds > 0.0 ? (double)s.processed / seconds : 0.0;
+    stats.averageLatencyMs = s.processed > 0 ? s.totalLatencyMs / (double)s.processed : 0.0;
+    stats.maxLatencyMs = s.maxLatencyMs;
+
+    return true;
+}
+
+
+
+void FrameGraph::schedule(int stage)
+{
+    Stage& s = m_stages[stage];
+    if (!m_isRunning || s.isScheduled)
+        return;
+
+    // Check input.
+    bool hasInput = false;
+    for (int index : s.inputs)
+        hasInput = hasInput || !m_edges[index].queue.empty();
+    if (!hasInput)
+        return;
+
+    // Check space in BLOCK outputs: stage is the only producer of its output
+    // edges, so one free place is enough for one processed frame.
+    for (int index : s.outputs)
+    {
+        const Edge& edge = m_edges[index];
+        if (edge.mode == Backpressure::BLOCK && edge.queue.size() >= edge.capacity)
+            return;
+    }
+
+    s.isScheduled = true;
+    ++m_scheduled;
+    m_pool->submit([this, stage]{ process(stage); });
+}
+
+
+
+void FrameGraph::process(int stage)
+{
+    unique_lock<mutex> lock(m_mutex);
+    Stage& s = m_stages[stage];
+
+    // Take frame from next not empty input (round robin).
+    FramePtr input;
+    int from = -1;
+    const size_t count = s.inputs.size();
+    for (size_t i = 0; i < count && m_isRunning; ++i)
+    {
+        size_t position = (s.next + i) % count;
+        Edge& edge = m_edges[s.inputs[position]];
+        if (!edge.queue.empty())
+        {
+            input = move(edge.queue.front());
+            edge.queue.pop_front();
+            from = edge.from;
+            s.next = (position + 1) % count;
+            break;
+        }
+    }
+    if (input == nullptr)
+    {
+        s.isScheduled = false;
+        --m_scheduled;
+        m_idleCond.notify_all();
+        return;
+    }
+
+    // Producer can continue.
+    if (from < 0)
+        m_spaceCond.notify_all();
+    else
+        schedule(from);
+    lock.unlock();
+
+    // Process frame. Exception of stage function must not leave worker
+    // thread (std::terminate): frame is dropped and counted as failed.
+    shared_ptr<Frame> output;
+    bool isProduced = false;
+    bool isFailed = false;
+    chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+    try
+    {
+        output = make_shared<Frame>();
+        isProduced = s.function(*input, *output);
+    }
+    catch (...)
+    {
+        isProduced = false;
+        isFailed = true;
+    }
+    double time = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+    input.reset();
+
+    lock.lock();
+    ++s.processed;
+    if (isFailed)
+        ++s.failed;
+    s.totalLatencyMs += time;
+    if (time > s.maxLatencyMs)
+        s.maxLatencyMs = time;
+
+    // Pass output frame to consumers.
+    if (isProduced)
+    {
+        ++s.produced;
+        if (m_isRunning)
+        {
+            FramePtr frame(move(output));
+            for (int index : s.outputs)
+            {
+                enqueue(m_edges[index], frame);
+                schedule(m_edges[index].to);
+            }
+        }
+    }
+
+    --m_inFlight;
+    s.isScheduled = false;
+    --m_scheduled;
+    schedule(stage);
+    if ((m_inFlight == 0 && m_scheduled == 0) || !m_isRunning)
+        m_idleCond.notify_all();
+}
+
+
+
+void FrameGraph::enqueue(Edge& edge, const FramePtr& frame)
+{
+    // Full DROP_OLDEST queue.
+    if (edge.queue.size() >= edge.capacity)
+    {
+        edge.queue.pop_front();
+        ++m_stages[edge.to].dropped;
+        --m_inFlight;
+    }
+    edge.queue.push_back(frame);
+    ++m_inFlight;
+}
+
+
+
+bool FrameGraph::hasPath(int from, int to) const
+{
+    if (from == to)
+        return true;
+    for (int index : m_stages[from].outputs)
+        if (hasPath(m_edges[index].to, to))
+            return true;
+    return false;
+}
@@ -0,0 +1,258 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Frame.h"
+
+
+
+namespace cr
+{
+namespace video
+{
+
+/**
+ * @brief Backpressure modes of graph edges (queues).
+ */
+enum class Backpressure
+{
+    /// Producer waits for free space: stage is not run while queue of its
+    /// output edge is full, push(...) blocks caller.
+    BLOCK = 0,
+    /// Oldest frame of full queue is dropped.
+    DROP_OLDEST = 1
+};
+
+
+
+/**
+ * @brief Statistics of graph stage.
+ */
+struct FrameStageStats
+{
+    /// Stage name.
+    std::string name;
+    /// Number of processed frames.
+    uint64_t processed{0};
+    /// Number of output frames (stage function returned TRUE).
+    uint64_t produced{0};
+    /// Number of input frames dropped by DROP_OLDEST edges.
+    uint64_t dropped{0};
+    /// Number of frames dropped because stage function threw exception.
+    uint64_t failed{0};
+    /// Number of frames in input queues.
+    int queued{0};
+    /// Processed frames per second since start.
+    double throughput{0.0};
+    /// Average processing time (milliseconds).
+    double averageLatencyMs{0.0};
+    /// Maximum processing time (milliseconds).
+    double maxLatencyMs{0.0};
+};
+
+
+
+class FrameWorkerPool;
+
+
+
+/**
+ * @brief Asynchronous frame processing graph. Stages (functions Frame ->
+ * Frame) are connected into directed acyclic graph by edges with bounded
+ * queues. Stages are run by work-stealing thread pool of the graph: each
+ * stage processes one frame at a time (frames of stage keep order),
+ * different stages work in parallel. Frames are passed between stages by
+ * shared pointers without copying (one output frame is shared by all output
+ * edges). Methods are thread-safe. Graph has own pool because stages are
+ * long running tasks: on library pool (see FrameCompute.h) they would
+ * delay parts of parallel loops of other callers and nested parallelFor(...)
+ * calls of stages would run in one thread.
+ */
+class FrameGraph
+{
+public:
+
+    /**
+     * @brief Stage function. Returns TRUE if output frame is produced or
+     * FALSE if frame is filtered out. Output of stages without output
+     * edges is discarded. Exception thrown by function is caught by worker
+     * thread: frame is dropped and counted as failed in stage statistics,
+     * graph continues processing of next frames.
+     */
+    typedef std::function<bool(const Frame& src, Frame& dst)> StageFunction;
+
+    /**
+     * @brief Class constructor.
+     */
+    FrameGraph();
+
+    /**
+     * @brief Class destructor. Stops graph without processing queued frames.
+     */
+    ~FrameGraph();
+
+    /**
+     * @brief Add stage. Stage has input queue for frames pushed by
+     * push(...) (capacity 4, BLOCK mode, see setInput(...)).
+     * @param name Stage name.
+     * @param function Stage function.
+     * @return Stage index or -1 if graph is started or function is empty.
+     */
+    int addStage(const std::string& name, StageFunction function);
+
+    /**
+     * @brief Set queue of frames pushed to stage by push(...).
+     * @param stage Stage index.
+     * @param capacity Queue capacity (frames, >= 1).
+     * @param mode Backpressure mode.
+     * @return TRUE if the queue is set or FALSE if parameters not valid or
+     * graph is started.
+     */
+    bool setInput(int stage, int capacity, Backpressure mode);
+
+    /**
+     * @brief Connect output of one stage to input of other stage.
+     * @param from Producer stage index.
+     * @param to Consumer stage index.
+     * @param capacity Queue capacity (frames, >= 1).
+     * @param mode Backpressure mode.
+     * @return TRUE if the edge is added or FALSE if parameters not valid,
+     * edge already exists, edge makes cycle or graph is started.
+     */
+    bool connect(int from, int to, int capacity = 4,
+                 Backpressure mode = Backpressure::BLOCK);
+
+    /**
+     * @brief Start graph.
+     * @param threads Number of worker threads. 0 - number of hardware
+     * threads.
+     * @return TRUE if the graph is started or FALSE if already started or
+     * graph has no stages.
+     */
+    bool start(int threads = 0);
+
+    /**
+     * @brief Push frame to input queue of stage (frame is copied).
+     * @param stage Stage index.
+     * @param frame Frame.
+     * @return TRUE if the frame is queued or FALSE if graph is not started
+     * or stage index not valid.
+     */
+    bool push(int stage, const Frame& frame);
+
+    /**
+     * @brief Push frame to input queue of stage without copying.
+     * @param stage Stage index.
+     * @param frame Frame. Must not be changed after push.
+     * @return TRUE if the frame is queued or FALSE if graph is not started,
+     * stage index not valid or frame is nullptr.
+     */
+    bool push(int stage, std::shared_ptr<const Frame> frame);
+
+    /**
+     * @brief Wait until all queued frames are processed.
+     */
+    void flush();
+
+    /**
+     * @brief Stop graph and worker threads. Graph can be started again.
+     * @param drain TRUE - process queued frames before stop, FALSE - drop
+     * queued frames.
+     */
+    void stop(bool drain = true);
+
+    /**
+     * @brief Get number of stages.
+     * @return Number of stages.
+     */
+    int getStagesCount() const;
+
+    /**
+     * @brief Get stage statistics.
+     * @param stage Stage index.
+     * @param stats Output statistics.
+     * @return TRUE if statistics are ready or FALSE if stage index not valid.
+     */
+    bool getStats(int stage, FrameStageStats& stats) const;
+
+private:
+
+    /// Queued frame.
+    typedef std::shared_ptr<const Frame> FramePtr;
+
+    /// Edge with queue of frames.
+    struct Edge
+    {
+        /// Producer stage (-1 - frames pushed by user).
+        int from{-1};
+        /// Consumer stage.
+        int to{-1};
+        /// Queue capacity.
+        size_t capacity{4};
+        /// Backpressure mode.
+        Backpressure mode{Backpressure::BLOCK};
+        /// Queued frames.
+        std::deque<FramePtr> queue;
+    };
+
+    /// Stage.
+    struct Stage
+    {
+        std::string name;
+        StageFunction function;
+        /// Input edges (first - input of frames pushed by user).
+        std::vector<int> inputs;
+        /// Output edges.
+        std::vector<int> outputs;
+        /// Next input edge to read (round robin).
+        size_t next{0};
+        /// Flag of stage task scheduled or running.
+        bool isScheduled{false};
+        /// Statistics.
+        uint64_t processed{0};
+        uint64_t produced{0};
+        uint64_t dropped{0};
+        uint64_t failed{0};
+        double totalLatencyMs{0.0};
+        double maxLatencyMs{0.0};
+    };
+
+    /// Schedule stage task if stage has input and space in output queues
+    /// (mutex must be locked).
+    void schedule(int stage);
+    /// Process frames of stage.
+    void process(int stage);
+    /// Add frame to edge queue (mutex must be locked).
+    void enqueue(Edge& edge, const FramePtr& frame);
+    /// Check if path exists from one stage to other (mutex must be locked).
+    bool hasPath(int from, int to) const;
+
+    /// Stages.
+    std::vector<Stage> m_stages;
+    /// Edges.
+    std::vector<Edge> m_edges;
+    /// Worker threads.
+    std::unique_ptr<FrameWorkerPool> m_pool;
+    /// Number of frames in queues and in processing.
+    size_t m_inFlight{0};
+    /// Number of scheduled stages.
+    int m_scheduled{0};
+    /// Running flag.
+    bool m_isRunning{false};
+    /// Start time.
+    std::chrono::steady_clock::time_point m_startTime;
+    /// Mutex to protect graph state.
+    mutable std::mutex m_mutex;
+    /// Condition to wait for free space in input queues.
+    std::condition_variable m_spaceCond;
+    /// Condition to wait for idle graph.
+    std::condition_variable m_idleCond;
+};
+}
+}
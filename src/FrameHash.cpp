@@ -0,0 +1,164 @@
+#include <cstring>
+#include <vector>
+#include "FrameHash.h"
+#include "FrameCompute.h"
+
+
+
+// Link namespaces.
+using namespace std;
+using namespace cr::video;
+
+
+
+namespace
+{
+
+/// Size of band hashed by one task (bytes).
+const size_t g_bandBytes = (size_t)1 << 20;
+/// Minimum number of bands processed by one task.
+const int g_grainBands = 2;
+
+/// XXH64 primes.
+const uint64_t g_prime1 = 0x9E3779B185EBCA87ULL;
+const uint64_t g_prime2 = 0xC2B2AE3D27D4EB4FULL;
+const uint64_t g_prime3 = 0x165667B19E3779F9ULL;
+const uint64_t g_prime4 = 0x85EBCA77C2B2AE63ULL;
+const uint64_t g_prime5 = 0x27D4EB2F165667C5ULL;
+
+
+
+inline uint64_t rotateLeft(uint64_t value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+
+
+/// Read little-endian values (supported platforms are little-endian).
+inline uint64_t read64(const uint8_t* data)
+{
+    uint64_t value;
+    memcpy(&value, data, 8);
+    return value;
+}
+
+
+
+inline uint32_t read32(const uint8_t* data)
+{
+    uint32_t value;
+    memcpy(&value, data, 4);
+    return value;
+}
+
+
+
+inline uint64_t hashRound(uint64_t acc, uint64_t input)
+{
+    acc += input * g_prime2;
+    acc = rotateLeft(acc, 31);
+    return acc * g_prime1;
+}
+
+
+
+inline uint64_t mergeRound(uint64_t acc, uint64_t value)
+{
+    acc ^= hashRound(0, value);
+    return acc * g_prime1 + g_prime4;
+}
+
+
+
+/// XXH64 hash.
+uint64_t xxh64(const uint8_t* data, size_t size, uint64_t seed)
+{
+    const uint8_t* end = data + size;
+    uint64_t hash;
+
+    // Four independent lanes for 32 byte stripes.
+    if (size >= 32)
+    {
+        uint64_t v1 = seed + g_prime1 + g_prime2;
+        uint64_t v2 = seed + g_prime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - g_prime1;
+        const uint8_t* limit = end - 32;
+        do
+        {
+            v1 = hashRound(v1, read64(data));
+            v2 = hashRound(v2, read64(data + 8));
+            v3 = hashRound(v3, read64(data + 16));
+            v4 = hashRound(v4, read64(data + 24));
+            data += 32;
+        } while (data <= limit);
+
+        hash = rotateLeft(v1, 1) + rotateLeft(v2, 7) + rotateLeft(v3, 12) +
+               rotateLeft(v4, 18);
+        hash = mergeRound(hash, v1);
+        hash = mergeRound(hash, v2);
+        hash = mergeRound(hash, v3);
+        hash = mergeRound(hash, v4);
+    }
+    else
+    {
+        hash = seed + g_prime5;
+    }
+    hash += (uint64_t)size;
+
+    // Tail.
+    while (data + 8 <= end)
+    {
+        hash ^= hashRound(0, read64(data));
+        hash = rotateLeft(hash, 27) * g_prime1 + g_prime4;
+        data += 8;
+    }
+    if (data + 4 <= end)
+    {
+        hash ^= (uint64_t)read32(data) * g_prime1;
+        hash = rotateLeft(hash, 23) * g_prime2 + g_prime3;
+        data += 4;
+    }
+    while (data < end)
+    {
+        hash ^= (*data) * g_prime5;
+        hash = rotateLeft(hash, 11) * g_prime1;
+        ++data;
+    }
+
+    // Avalanche.
+    hash ^= hash >> 33;
+    hash *= g_prime2;
+    hash ^= hash >> 29;
+    hash *= g_prime3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+}
+
+
+
+uint64_t cr::video::getDataHash(const uint8_t* data, size_t size)
+{
+    if (data == nullptr || size <= g_bandBytes)
+        return xxh64(data, data == nullptr ? 0 : size, 0);
+
+    // Hashes of bands in parallel.
+    const int bands = (int)((size + g_bandBytes - 1) / g_bandBytes);
+    vector<uint64_t> hashes(bands);
+    parallelFor(bands, g_grainBands, [&](int begin, int end)
+    {
+        for (int i = begin; i < end; ++i)
+        {
+            size_t offset = (size_t)i * g_bandBytes;
+            size_t count = size - offset < g_bandBytes ? size - offset : g_bandBytes;
+            hashes[i] = xxh64(data + offset, count, 0);
+        }
+    });
+
+    // Hash of band hashes.
+    return xxh64((const uint8_t*)hashes.data(), hashes.size() * sizeof(uint64_t),
+                 (uint64_t)size);
+}
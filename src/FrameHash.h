@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+
+
+namespace cr
+{
+namespace video
+{
+
+/**
+ * @brief Get content hash of data. Data up to 1 MB is hashed by XXH64 (seed
+ * 0), bigger data is split into 1 MB bands hashed by XXH64 in parallel by
+ * library thread pool and hash is XXH64 of band hashes (seed is data size).
+ * Result doesn't depend on number of threads. Used by Frame::getHash().
+ * @param data Pointer to data.
+ * @param size Data size (bytes).
+ * @return 64-bit hash.
+ */
+uint64_t getDataHash(const uint8_t* data, size_t size);
+}
+}
@@ -0,0 +1,685 @@
+#include <cstdlib>
+#include <utility>
+#include "FrameKernels.h"
+
+
+
+// Link namespaces.
+using namespace std;
+using namespace cr::video;
+using namespace cr::video::kernels;
+
+
+
+namespace
+{
+
+/// Maximum frame data size (bytes): size must fit int64_t and size_t.
+const int64_t g_maxSize = (uint64_t)SIZE_MAX < (uint64_t)INT64_MAX ?
+                          (int64_t)SIZE_MAX : INT64_MAX;
+
+
+
+/// Clamp index of chroma sample to last sample: for odd width or height
+/// last pixel or row has no own chroma sample.
+inline int chromaIndex(int index, int count)
+{
+    return index < count ? index : count - 1;
+}
+
+
+
+/// Upsample horizontally subsampled chroma to pixels [x, x + width). Last
+/// pixel of odd width gets last sample, row without samples (count is 0)
+/// gets neutral chroma.
+void upsampleChroma(const uint8_t* samples, int step, int count, int x, int width,
+                    uint8_t* dst)
+{
+    // Pixels with own sample.
+    int inner = 2 * count - x;
+    inner = inner < 0 ? 0 : (inner > width ? width : inner);
+    for (int i = 0; i < inner; ++i)
+        dst[i] = samples[((x + i) >> 1) * step];
+
+    // Pixels after last sample.
+    const uint8_t last = count > 0 ? samples[(count - 1) * step] : 128;
+    for (int i = inner; i < width; ++i)
+        dst[i] = last;
+}
+
+
+
+/// Make kernels table for SIMD level.
+KernelTable makeTable(SimdLevel level)
+{
+    // Scalar kernels.
+    KernelTable table;
+    table.bayerBilinearRow = kernels::bayerBilinearRow;
+    table.bayerGreenRow = kernels::bayerGreenRow;
+    table.bayerColorRow = kernels::bayerColorRow;
+    table.tensorRow = kernels::tensorRow;
+    table.tensorRowHalf = kernels::tensorRowHalf;
+    table.resampleRow = kernels::resampleRow;
+    table.yuvToRgbRow = kernels::yuvToRgbRow;
+    table.transpose8 = kernels::transpose8;
+    table.transpose16 = kernels::transpose16;
+    table.reverse8 = kernels::reverse8;
+    table.reverse16 = kernels::reverse16;
+    table.rangeRow8 = kernels::rangeRow8;
+    table.rangeRow16 = kernels::rangeRow16;
+    table.blendRow = kernels::blendRow;
+    table.lerpRow = kernels::lerpRow;
+    table.downscaleRow = kernels::downscaleRow;
+    table.accumulateRow = kernels::accumulateRow;
+    table.differenceRow = kernels::differenceRow;
+    table.meanRow = kernels::meanRow;
+    table.medianRow = kernels::medianRow;
+    table.deinterlaceRow = kernels::deinterlaceRow;
+    table.streamCopy = kernels::streamCopy;
+
+    // Replace kernels which have SIMD implementation.
+#if defined(FRAME_SIMD)
+    if ((int)level >= (int)SimdLevel::SSE41)
+        initSse41(table);
+    if ((int)level >= (int)SimdLevel::AVX2)
+        initAvx2(table);
+#else
+    (void)level;
+#endif
+
+    return table;
+}
+}
+
+
+
+const KernelTable& kernels::getTable()
+{
+    return getTable(getSimdLevel());
+}
+
+
+
+const KernelTable& kernels::getTable(SimdLevel level)
+{
+    static const KernelTable tables[3] = {makeTable(SimdLevel::SCALAR),
+                                          makeTable(SimdLevel::SSE41),
+                                          makeTable(SimdLevel::AVX2)};
+    return tables[(int)level];
+}
+
+
+
+int64_t kernels::getBufferSize(Fourcc fourcc, int width, int height)
+{
+    // Check geometry.
+    if (width < 0 || height < 0)
+        return -1;
+
+    // Size is calculated in 64 bits: width * height fits 62 bits, bytes
+    // per pixel are checked against maximum size.
+    const int64_t pixels = (int64_t)width * height;
+    int64_t size = 0;
+    switch (fourcc)
+    {
+    case Fourcc::BGR24:
+    case Fourcc::RGB24:
+    case Fourcc::YUV24:
+        size = pixels > g_maxSize / 3 ? -1 : pixels * 3;
+        break;
+    case Fourcc::NV12:
+    case Fourcc::NV21:
+    case Fourcc::YU12:
+    case Fourcc::YV12:
+        size = pixels > g_maxSize / 3 * 2 ? -1 : pixels + (int64_t)width * (height / 2);
+        break;
+    case Fourcc::YUYV:
+    case Fourcc::UYVY:
+    case Fourcc::BGGR16:
+    case Fourcc::GBRG16:
+    case Fourcc::GRBG16:
+    case Fourcc::RGGB16:
+        size = pixels > g_maxSize / 2 ? -1 : pixels * 2;
+        break;
+    case Fourcc::JPEG:
+    case Fourcc::H264:
+    case Fourcc::HEVC:
+        size = pixels > g_maxSize / 4 ? -1 : pixels * 4;
+        break;
+    case Fourcc::GRAY:
+    case Fourcc::BGGR8:
+    case Fourcc::GBRG8:
+    case Fourcc::GRBG8:
+    case Fourcc::RGGB8:
+        size = pixels > g_maxSize ? -1 : pixels;
+        break;
+    default:
+        return -1;
+    }
+
+    return size;
+}
+
+
+
+int64_t kernels::getDataSize(Fourcc fourcc, int width, int height)
+{
+    switch (fourcc)
+    {
+    case Fourcc::JPEG:
+    case Fourcc::H264:
+    case Fourcc::HEVC:
+        return 0;
+    default:
+        break;
+    }
+    int64_t size = getBufferSize(fourcc, width, height);
+    return size > 0 ? size : 0;
+}
+
+
+
+bool kernels::prepareFrame(Frame& frame, int width, int height, Fourcc fourcc)
+{
+    int64_t size = getDataSize(fourcc, width, height);
+    if (size <= 0)
+        return false;
+
+    // Check current frame.
+    if (frame.data != nullptr &&
+        frame.width == width &&
+        frame.height == height &&
+        frame.fourcc == fourcc &&
+        frame.size == size)
+    {
+        frame.invalidateCache();
+        return true;
+    }
+
+    // Allocate new memory.
+    frame.release();
+    Frame tmp(width, height, fourcc);
+    frame = std::move(tmp);
+    return frame.data != nullptr;
+}
+
+
+
+bool kernels::readRgbRow(const Frame& frame, int y, int x, int width,
+                         uint8_t* r, uint8_t* g, uint8_t* b)
+{
+    const int w = frame.width;
+    const uint8_t* row = nullptr;
+    switch (frame.fourcc)
+    {
+    case Fourcc::RGB24:
+    case Fourcc::BGR24:
+    {
+        row = &frame.data[((size_t)y * w + x) * 3];
+        uint8_t* c0 = frame.fourcc == Fourcc::RGB24 ? r : b;
+        uint8_t* c2 = frame.fourcc == Fourcc::RGB24 ? b : r;
+        for (int i = 0; i < width; ++i)
+        {
+            c0[i] = row[3 * i];
+            g[i] = row[3 * i + 1];
+            c2[i] = row[3 * i + 2];
+        }
+        return true;
+    }
+    case Fourcc::GRAY:
+        row = &frame.data[(size_t)y * w + x];
+        memcpy(r, row, width);
+        memcpy(g, row, width);
+        memcpy(b, row, width);
+        return true;
+    case Fourcc::YUV24:
+    case Fourcc::YUYV:
+    case Fourcc::UYVY:
+    case Fourcc::NV12:
+    case Fourcc::NV21:
+    case Fourcc::YU12:
+    case Fourcc::YV12:
+        // Read YUV to output rows and convert in place by SIMD kernel.
+        readYuvRow(frame, y, x, width, r, g, b);
+        getTable().yuvToRgbRow(r, g, b, width, r, g, b);
+        return true;
+    default:
+        return false;
+    }
+}
+
+
+
+bool kernels::readYuvRow(const Frame& frame, int y, int x, int width,
+                         uint8_t* luma, uint8_t* u, uint8_t* v)
+{
+    const int w = frame.width;
+    const int h = frame.height;
+    const uint8_t* row = nullptr;
+    switch (frame.fourcc)
+    {
+    case Fourcc::YUV24:
+        row = &frame.data[((size_t)y * w + x) * 3];
+        for (int i = 0; i < width; ++i)
+        {
+            luma[i] = row[3 * i];
+            u[i] = row[3 * i + 1];
+            v[i] = row[3 * i + 2];
+        }
+        return true;
+    case Fourcc::YUYV:
+    case Fourcc::UYVY:
+    {
+        row = &frame.data[(size_t)y * w * 2];
+        int yPos = frame.fourcc == Fourcc::YUYV ? 0 : 1;
+        int uPos = frame.fourcc == Fourcc::YUYV ? 1 : 0;
+        for (int i = 0; i < width; ++i)
+            luma[i] = row[2 * (x + i) + yPos];
+        upsampleChroma(row + uPos, 4, w / 2, x, width, u);
+        upsampleChroma(row + uPos + 2, 4, w / 2, x, width, v);
+        return true;
+    }
+    case Fourcc::NV12:
+    case Fourcc::NV21:
+    {
+        row = &frame.data[(size_t)y * w];
+        memcpy(luma, &row[x], width);
+        const int pairs = h / 2 > 0 ? w / 2 : 0;
+        const uint8_t* uv = &frame.data[(size_t)w * h];
+        if (pairs > 0)
+            uv += (size_t)chromaIndex(y / 2, h / 2) * w;
+        int uPos = frame.fourcc == Fourcc::NV12 ? 0 : 1;
+        upsampleChroma(uv + uPos, 2, pairs, x, width, u);
+        upsampleChroma(uv + 1 - uPos, 2, pairs, x, width, v);
+        return true;
+    }
+    case Fourcc::YU12:
+    case Fourcc::YV12:
+    {
+        row = &frame.data[(size_t)y * w];
+        memcpy(luma, &row[x], width);
+        const int chromaWidth = h / 2 > 0 ? w / 2 : 0;
+        const uint8_t* uRow = nullptr;
+        const uint8_t* vRow = nullptr;
+        if (chromaWidth > 0)
+        {
+            size_t chromaSize = (size_t)chromaWidth * (h / 2);
+            const uint8_t* first = &frame.data[(size_t)w * h +
+                                               (size_t)chromaIndex(y / 2, h / 2) * chromaWidth];
+            const uint8_t* second = first + chromaSize;
+            uRow = frame.fourcc == Fourcc::YU12 ? first : second;
+            vRow = frame.fourcc == Fourcc::YU12 ? second : first;
+        }
+        upsampleChroma(uRow, 1, chromaWidth, x, width, u);
+        upsampleChroma(vRow, 1, chromaWidth, x, width, v);
+        return true;
+    }
+    default:
+        break;
+    }
+
+    // RGB formats: read RGB and convert in place.
+    if (!readRgbRow(frame, y, x, width, luma, u, v))
+        return false;
+    for (int i = 0; i < width; ++i)
+    {
+        int r = luma[i];
+        int g = u[i];
+        int b = v[i];
+        luma[i] = rgbToY(r, g, b);
+        u[i] = rgbToU(r, g, b);
+        v[i] = rgbToV(r, g, b);
+    }
+    return true;
+}
+
+
+
+bool kernels::isRgbReadable(Fourcc fourcc)
+{
+    switch (fourcc)
+    {
+    case Fourcc::RGB24:
+    case Fourcc::BGR24:
+    case Fourcc::YUV24:
+    case Fourcc::GRAY:
+    case Fourcc::YUYV:
+    case Fourcc::UYVY:
+    case Fourcc::NV12:
+    case Fourcc::NV21:
+    case Fourcc::YU12:
+    case Fourcc::YV12:
+        return true;
+    default:
+        return false;
+    }
+}
+
+
+
+void kernels::bayerBilinearRow(const uint8_t* const rows[3], int width,
+                               bool greenFirst, uint8_t* own, uint8_t* green,
+                               uint8_t* other)
+{
+    const uint8_t* u = rows[0];
+    const uint8_t* m = rows[1];
+    const uint8_t* d = rows[2];
+    for (int x = 0; x < width; ++x)
+    {
+        if (((x & 1) == 0) == greenFirst)
+        {
+            own[x] = (uint8_t)((m[x - 1] + m[x + 1] + 1) >> 1);
+            green[x] = m[x];
+            other[x] = (uint8_t)((u[x] + d[x] + 1) >> 1);
+        }
+        else
+        {
+            own[x] = m[x];
+            green[x] = (uint8_t)((m[x - 1] + m[x + 1] + u[x] + d[x] + 2) >> 2);
+            other[x] = (uint8_t)((u[x - 1] + u[x + 1] +
+                                  d[x - 1] + d[x + 1] + 2) >> 2);
+        }
+    }
+}
+
+
+
+void kernels::bayerGreenRow(const uint8_t* const rows[5], int width,
+                            bool greenFirst, uint8_t* green)
+{
+    const uint8_t* uu = rows[0];
+    const uint8_t* u = rows[1];
+    const uint8_t* m = rows[2];
+    const uint8_t* d = rows[3];
+    const uint8_t* dd = rows[4];
+    for (int x = 0; x < width; ++x)
+    {
+        if (((x & 1) == 0) == greenFirst)
+        {
+            green[x] = m[x];
+            continue;
+        }
+
+        // Second order derivatives and gradients.
+        int lh = 2 * m[x] - m[x - 2] - m[x + 2];
+        int lv = 2 * m[x] - uu[x] - dd[x];
+        int dh = abs(m[x - 1] - m[x + 1]) + abs(lh);
+        int dv = abs(u[x] - d[x]) + abs(lv);
+
+        // Interpolate along direction with lower gradient.
+        int gh = (2 * (m[x - 1] + m[x + 1]) + lh + 2) >> 2;
+        int gv = (2 * (u[x] + d[x]) + lv + 2) >> 2;
+        int g = dh < dv ? gh : (dv < dh ? gv : (gh + gv + 1) >> 1);
+        green[x] = clamp8(g);
+    }
+}
+
+
+
+void kernels::bayerColorRow(const uint8_t* const rows[3],
+                            const uint8_t* const greens[3], int width,
+                            bool greenFirst, uint8_t* own, uint8_t* other)
+{
+    const uint8_t* u = rows[0];
+    const uint8_t* m = rows[1];
+    const uint8_t* d = rows[2];
+    const uint8_t* gu = greens[0];
+    const uint8_t* gm = greens[1];
+    const uint8_t* gd = greens[2];
+    for (int x = 0; x < width; ++x)
+    {
+        if (((x & 1) == 0) == greenFirst)
+        {
+            own[x] = clamp8(gm[x] + ((m[x - 1] - gm[x - 1] +
+                                      m[x + 1] - gm[x + 1] + 1) >> 1));
+            other[x] = clamp8(gm[x] + ((u[x] - gu[x] + d[x] - gd[x] + 1) >> 1));
+        }
+        else
+        {
+            own[x] = m[x];
+            other[x] = clamp8(gm[x] + ((u[x - 1] - gu[x - 1] +
+                                        u[x + 1] - gu[x + 1] +
+                                        d[x - 1] - gd[x - 1] +
+                                        d[x + 1] - gd[x + 1] + 2) >> 2));
+        }
+    }
+}
+
+
+
+void kernels::tensorRow(const uint16_t* top, const uint16_t* bottom, int weight,
+                        int width, float scale, float offset, float* dst)
+{
+    for (int x = 0; x < width; ++x)
+    {
+        int value = (top[x] * (256 - weight) + bottom[x] * weight + 128) >> 8;
+        dst[x] = (float)value * scale + offset;
+    }
+}
+
+
+
+void kernels::tensorRowHalf(const uint16_t* top, const uint16_t* bottom,
+                            int weight, int width, float scale, float offset,
+                            uint16_t* dst)
+{
+    for (int x = 0; x < width; ++x)
+    {
+        int value = (top[x] * (256 - weight) + bottom[x] * weight + 128) >> 8;
+        dst[x] = floatToHalf((float)value * scale + offset);
+    }
+}
+
+
+
+void kernels::resampleRow(const uint8_t* src, const int* index, const int* weight,
+                          int width, uint16_t* dst)
+{
+    for (int x = 0; x < width; ++x)
+    {
+        const uint8_t* s = &src[index[x]];
+        dst[x] = (uint16_t)(s[0] * (256 - weight[x]) + s[1] * weight[x]);
+    }
+}
+
+
+
+void kernels::yuvToRgbRow(const uint8_t* luma, const uint8_t* u, const uint8_t* v,
+                          int width, uint8_t* r, uint8_t* g, uint8_t* b)
+{
+    for (int x = 0; x < width; ++x)
+        yuvToRgb(luma[x], u[x], v[x], r[x], g[x], b[x]);
+}
+
+
+
+void kernels::transpose8(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst,
+                         ptrdiff_t dstStride, int width, int height)
+{
+    for (int x = 0; x < width; ++x)
+    {
+        uint8_t* d = dst + x * dstStride;
+        for (int y = 0; y < height; ++y)
+            d[y] = src[y * srcStride + x];
+    }
+}
+
+
+
+void kernels::transpose16(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst,
+                          ptrdiff_t dstStride, int width, int height)
+{
+    for (int x = 0; x < width; ++x)
+    {
+        uint8_t* d = dst + x * dstStride;
+        for (int y = 0; y < height; ++y)
+            memcpy(&d[y * 2], &src[y * srcStride + x * 2], 2);
+    }
+}
+
+
+
+void kernels::reverse8(const uint8_t* src, uint8_t* dst, int width)
+{
+    for (int x = 0; x < width; ++x)
+        dst[x] = src[width - 1 - x];
+}
+
+
+
+void kernels::reverse16(const uint8_t* src, uint8_t* dst, int width)
+{
+    for (int x = 0; x < width; ++x)
+        memcpy(&dst[x * 2], &src[(width - 1 - x) * 2], 2);
+}
+
+
+
+void kernels::rangeRow8(const uint8_t* src, int width, int& min, int& max,
+                        uint64_t& sum)
+{
+    for (int x = 0; x < width; ++x)
+    {
+        int value = src[x];
+        min = value < min ? value : min;
+        max = value > max ? value : max;
+        sum += value;
+    }
+}
+
+
+
+void kernels::rangeRow16(const uint16_t* src, int width, int& min, int& max,
+                         uint64_t& sum)
+{
+    for (int x = 0; x < width; ++x)
+    {
+        int value = src[x];
+        min = value < min ? value : min;
+        max = value > max ? value : max;
+        sum += value;
+    }
+}
+
+
+
+void kernels::blendRow(uint8_t* dst, const uint8_t* alpha, const uint8_t* color,
+                       int width)
+{
+    for (int x = 0; x < width; ++x)
+        dst[x] = (uint8_t)div255(dst[x] * (255 - alpha[x]) + color[x] * alpha[x]);
+}
+
+
+
+void kernels::lerpRow(const uint8_t* top, const uint8_t* bottom, int weight,
+                      int width, uint16_t* dst)
+{
+    for (int x = 0; x < width; ++x)
+        dst[x] = (uint16_t)(top[x] * (256 - weight) + bottom[x] * weight);
+}
+
+
+
+void kernels::downscaleRow(const uint8_t* top, const uint8_t* bottom, int width,
+                           uint8_t* dst)
+{
+    for (int x = 0; x < width; ++x)
+        dst[x] = (uint8_t)((top[2 * x] + top[2 * x + 1] +
+                            bottom[2 * x] + bottom[2 * x + 1] + 2) >> 2);
+}
+
+
+
+void kernels::accumulateRow(const uint8_t* src, uint16_t* acc, int weight,
+                            int threshold, uint8_t* mask, int width)
+{
+    // Change of average (frame - average) * weight is rounded away from zero
+    // as difference - floor(difference * (1 - weight)): average reaches
+    // constant frame value for any weight.
+    const uint32_t accWeight = (uint32_t)(65536 - weight);
+    for (int x = 0; x < width; ++x)
+    {
+        if (mask != nullptr)
+            mask[x] = abs(src[x] - ((acc[x] + 128) >> 8)) > threshold ? 255 : 0;
+        const uint32_t value = (uint32_t)src[x] << 8;
+        if (value > acc[x])
+        {
+            uint32_t difference = value - acc[x];
+            acc[x] = (uint16_t)(acc[x] + difference - ((difference * accWeight) >> 16));
+        }
+        else
+        {
+            uint32_t difference = acc[x] - value;
+            acc[x] = (uint16_t)(acc[x] - difference + ((difference * accWeight) >> 16));
+        }
+    }
+}
+
+
+
+void kernels::differenceRow(const uint8_t* a, const uint8_t* b, int threshold,
+                            uint8_t* mask, int width)
+{
+    for (int x = 0; x < width; ++x)
+        mask[x] = abs(a[x] - b[x]) > threshold ? 255 : 0;
+}
+
+
+
+void kernels::meanRow(const uint8_t* const rows[], int count, int width, uint8_t* dst)
+{
+    const float scale = 1.0f / (float)count;
+    for (int x = 0; x < width; ++x)
+    {
+        int sum = 0;
+        for (int i = 0; i < count; ++i)
+            sum += rows[i][x];
+        dst[x] = (uint8_t)((float)sum * scale + 0.5f);
+    }
+}
+
+
+
+void kernels::medianRow(const uint8_t* const rows[], int count, int width, uint8_t* dst)
+{
+    uint8_t values[16];
+    for (int x = 0; x < width; ++x)
+    {
+        // Insertion sort.
+        for (int i = 0; i < count; ++i)
+        {
+            uint8_t value = rows[i][x];
+            int j = i;
+            for (; j > 0 && values[j - 1] > value; --j)
+                values[j] = values[j - 1];
+            values[j] = value;
+        }
+        dst[x] = count % 2 != 0 ? values[count / 2] :
+                 (uint8_t)((values[count / 2 - 1] + values[count / 2] + 1) >> 1);
+    }
+}
+
+
+
+void kernels::deinterlaceRow(const uint8_t* above, const uint8_t* below,
+                             const uint8_t* current, const uint8_t* previous,
+                             int threshold, int width, uint8_t* dst)
+{
+    if (previous == nullptr)
+    {
+        for (int x = 0; x < width; ++x)
+            dst[x] = (uint8_t)((above[x] + below[x] + 1) >> 1);
+        return;
+    }
+    for (int x = 0; x < width; ++x)
+        dst[x] = abs(current[x] - previous[x]) > threshold ?
+                 (uint8_t)((above[x] + below[x] + 1) >> 1) : current[x];
+}
+
+
+
+void kernels::streamCopy(uint8_t* dst, const uint8_t* src, size_t size)
+{
+    memcpy(dst, src, size);
+}
@@ -0,0 +1,501 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "Frame.h"
+#include "FrameCompute.h"
+
+
+
+/*
+ * Internal header. Declares table of row processing kernels used by frame
+ * processing functions. Each kernel has portable scalar implementation which
+ * is the reference for SIMD implementations: SIMD kernels must produce
+ * bit-exact results. Table for SIMD level contains SIMD kernels where they
+ * exist and scalar kernels for the rest.
+ */
+
+
+
+namespace cr
+{
+namespace video
+{
+namespace kernels
+{
+
+/**
+ * @brief Table of row processing kernels.
+ */
+struct KernelTable
+{
+    /**
+     * @brief Bilinear demosaic of one Bayer row.
+     * @param rows Pointers to rows y-1, y and y+1. Rows must be readable
+     * from index -1 to index width.
+     * @param width Row width (pixels).
+     * @param greenFirst TRUE if pixel with even index is green.
+     * @param own Output row of color presented in Bayer row (red or blue).
+     * @param green Output row of green color.
+     * @param other Output row of color not presented in Bayer row.
+     */
+    void (*bayerBilinearRow)(const uint8_t* const rows[3], int width,
+                             bool greenFirst, uint8_t* own, uint8_t* green,
+                             uint8_t* other);
+
+    /**
+     * @brief Edge-aware interpolation of green color for one Bayer row.
+     * Green is interpolated along direction with lower gradient with
+     * second order correction (Hamilton-Adams).
+     * @param rows Pointers to rows y-2 ... y+2. Rows must be readable
+     * from index -2 to index width + 1.
+     * @param width Row width (pixels).
+     * @param greenFirst TRUE if pixel with even index is green.
+     * @param green Output row of green color.
+     */
+    void (*bayerGreenRow)(const uint8_t* const rows[5], int width,
+                          bool greenFirst, uint8_t* green);
+
+    /**
+     * @brief Color difference interpolation of red and blue colors for one
+     * Bayer row with known green color.
+     * @param rows Pointers to Bayer rows y-1, y and y+1. Rows must be
+     * readable from index -1 to index width.
+     * @param greens Pointers to green rows y-1, y and y+1. Rows must be
+     * readable from index -1 to index width.
+     * @param width Row width (pixels).
+     * @param greenFirst TRUE if pixel with even index is green.
+     * @param own Output row of color presented in Bayer row (red or blue).
+     * @param other Output row of color not presented in Bayer row.
+     */
+    void (*bayerColorRow)(const uint8_t* const rows[3],
+                          const uint8_t* const greens[3], int width,
+                          bool greenFirst, uint8_t* own, uint8_t* other);
+
+    /**
+     * @brief Vertical interpolation of two rows and linear conversion to
+     * float: dst = ((top * (256 - weight) + bottom * weight + 128) >> 8)
+     * * scale + offset.
+     * @param top Top row (values in 8.8 fixed point format).
+     * @param bottom Bottom row (values in 8.8 fixed point format).
+     * @param weight Weight of bottom row [0, 256].
+     * @param width Row width.
+     * @param scale Scale.
+     * @param offset Offset.
+     * @param dst Output row.
+     */
+    void (*tensorRow)(const uint16_t* top, const uint16_t* bottom, int weight,
+                      int width, float scale, float offset, float* dst);
+
+    /**
+     * @brief The same as tensorRow but output values are half precision
+     * floats (round to nearest even).
+     */
+    void (*tensorRowHalf)(const uint16_t* top, const uint16_t* bottom,
+                          int weight, int width, float scale, float offset,
+                          uint16_t* dst);
+
+    /**
+     * @brief Horizontal linear interpolation of row to 8.8 fixed point
+     * format: dst = src[index] * (256 - weight) + src[index + 1] * weight.
+     * @param src Source row. Row must be readable to index max(index) + 3.
+     * @param index Source pixel index for every output pixel.
+     * @param weight Weight of next source pixel [0, 256] for every output
+     * pixel.
+     * @param width Output row width.
+     * @param dst Output row.
+     */
+    void (*resampleRow)(const uint8_t* src, const int* index, const int* weight,
+                        int width, uint16_t* dst);
+
+    /**
+     * @brief Convert row of YUV pixels (BT.601 limited range, chroma for
+     * every pixel) to planar RGB as yuvToRgb(...). Output rows can be the
+     * same as input rows (conversion in place).
+     * @param luma Y values.
+     * @param u U values.
+     * @param v V values.
+     * @param width Row width.
+     * @param r Output red values.
+     * @param g Output green values.
+     * @param b Output blue values.
+     */
+    void (*yuvToRgbRow)(const uint8_t* luma, const uint8_t* u, const uint8_t* v,
+                        int width, uint8_t* r, uint8_t* g, uint8_t* b);
+
+    /**
+     * @brief Transpose block of 8 bit elements: column i of source block is
+     * written to row i of destination block. Strides can be negative.
+     * @param src Pointer to first element of source block.
+     * @param srcStride Distance between source rows (bytes).
+     * @param dst Pointer to first element of destination block.
+     * @param dstStride Distance between destination rows (bytes).
+     * @param width Source block width (elements).
+     * @param height Source block height (rows).
+     */
+    void (*transpose8)(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst,
+                       ptrdiff_t dstStride, int width, int height);
+
+    /**
+     * @brief The same as transpose8 but for 16 bit elements.
+     */
+    void (*transpose16)(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst,
+                        ptrdiff_t dstStride, int width, int height);
+
+    /**
+     * @brief Copy row of 8 bit elements in reverse order. Source and
+     * destination must not overlap.
+     * @param src Source row.
+     * @param dst Destination row.
+     * @param width Row width (elements).
+     */
+    void (*reverse8)(const uint8_t* src, uint8_t* dst, int width);
+
+    /**
+     * @brief The same as reverse8 but for 16 bit elements.
+     */
+    void (*reverse16)(const uint8_t* src, uint8_t* dst, int width);
+
+    /**
+     * @brief Update minimum, maximum and sum of row of 8 bit samples.
+     * @param src Row.
+     * @param width Row width (samples).
+     * @param min Minimum value to update.
+     * @param max Maximum value to update.
+     * @param sum Sum of values to update.
+     */
+    void (*rangeRow8)(const uint8_t* src, int width, int& min, int& max,
+                      uint64_t& sum);
+
+    /**
+     * @brief The same as rangeRow8 but for 16 bit samples.
+     */
+    void (*rangeRow16)(const uint16_t* src, int width, int& min, int& max,
+                       uint64_t& sum);
+
+    /**
+     * @brief Alpha blending of row: dst = (dst * (255 - alpha) + color *
+     * alpha) / 255 rounded to nearest.
+     * @param dst Row to blend.
+     * @param alpha Alpha values.
+     * @param color Color values.
+     * @param width Row width.
+     */
+    void (*blendRow)(uint8_t* dst, const uint8_t* alpha, const uint8_t* color,
+                     int width);
+
+    /**
+     * @brief Vertical interpolation of two rows to 8.8 fixed point format:
+     * dst = top * (256 - weight) + bottom * weight.
+     * @param top Top row.
+     * @param bottom Bottom row.
+     * @param weight Weight of bottom row [0, 256].
+     * @param width Row width.
+     * @param dst Output row.
+     */
+    void (*lerpRow)(const uint8_t* top, const uint8_t* bottom, int weight,
+                    int width, uint16_t* dst);
+
+    /**
+     * @brief 2x downscaling of two rows (2x2 box filter): dst = (top[2x] +
+     * top[2x + 1] + bottom[2x] + bottom[2x + 1] + 2) >> 2.
+     * @param top Top row (2 * width pixels).
+     * @param bottom Bottom row (2 * width pixels).
+     * @param width Output row width.
+     * @param dst Output row.
+     */
+    void (*downscaleRow)(const uint8_t* top, const uint8_t* bottom, int width,
+                         uint8_t* dst);
+
+    /**
+     * @brief Exponential running average of row in 8.8 fixed point format
+     * with optional foreground mask: mask = |src - ((acc + 128) >> 8)| >
+     * threshold ? 255 : 0 (before update), acc = acc + sign(d) * (|d| -
+     * ((|d| * (65536 - weight)) >> 16)) where d = (src << 8) - acc (change
+     * is rounded away from zero, acc reaches constant src for any weight).
+     * @param src Source row.
+     * @param acc Accumulator row.
+     * @param weight Weight of source row [1, 65535] (alpha * 65536).
+     * @param threshold Mask threshold [0, 255].
+     * @param mask Output mask row or nullptr.
+     * @param width Row width.
+     */
+    void (*accumulateRow)(const uint8_t* src, uint16_t* acc, int weight,
+                          int threshold, uint8_t* mask, int width);
+
+    /**
+     * @brief Thresholded absolute difference of two rows: mask = |a - b| >
+     * threshold ? 255 : 0.
+     * @param a First row.
+     * @param b Second row.
+     * @param threshold Threshold [0, 255].
+     * @param mask Output mask row.
+     * @param width Row width.
+     */
+    void (*differenceRow)(const uint8_t* a, const uint8_t* b, int threshold,
+                          uint8_t* mask, int width);
+
+    /**
+     * @brief Mean of rows: dst = (uint8_t)((float)sum * (1.0f / count) +
+     * 0.5f).
+     * @param rows Pointers to rows.
+     * @param count Number of rows [1, 257].
+     * @param width Row width.
+     * @param dst Output row.
+     */
+    void (*meanRow)(const uint8_t* const rows[], int count, int width, uint8_t* dst);
+
+    /**
+     * @brief Median of rows. For even number of rows result is rounded up
+     * average of two middle values.
+     * @param rows Pointers to rows.
+     * @param count Number of rows [1, 16].
+     * @param width Row width.
+     * @param dst Output row.
+     */
+    void (*medianRow)(const uint8_t* const rows[], int count, int width, uint8_t* dst);
+
+    /**
+     * @brief Interpolate missing row of field: dst = (above + below + 1) >> 1.
+     * If previous row is set pixels without motion are kept: dst = |current -
+     * previous| > threshold ? (above + below + 1) >> 1 : current.
+     * @param above Row above (field row).
+     * @param below Row below (field row).
+     * @param current Missing row of current frame (can be equal to dst).
+     * @param previous Missing row of previous frame or nullptr.
+     * @param threshold Motion threshold [0, 255].
+     * @param width Row width (bytes).
+     * @param dst Output row.
+     */
+    void (*deinterlaceRow)(const uint8_t* above, const uint8_t* below,
+                           const uint8_t* current, const uint8_t* previous,
+                           int threshold, int width, uint8_t* dst);
+
+    /**
+     * @brief Copy data with non-temporal (streaming) stores which bypass
+     * cache. Scalar kernel is memcpy.
+     * @param dst Destination.
+     * @param src Source.
+     * @param size Size (bytes).
+     */
+    void (*streamCopy)(uint8_t* dst, const uint8_t* src, size_t size);
+};
+
+
+
+/**
+ * @brief Get kernels table for current SIMD level.
+ * @return Kernels table.
+ */
+const KernelTable& getTable();
+
+/**
+ * @brief Get kernels table for particular SIMD level.
+ * @param level SIMD level.
+ * @return Kernels table.
+ */
+const KernelTable& getTable(SimdLevel level);
+
+/// Initialize table by SSE4.1 kernels (FrameKernelsSse41.cpp).
+void initSse41(KernelTable& table);
+
+/// Initialize table by AVX2 kernels (FrameKernelsAvx2.cpp).
+void initAvx2(KernelTable& table);
+
+
+
+/// Scalar kernels. Description in KernelTable.
+void bayerBilinearRow(const uint8_t* const rows[3], int width, bool greenFirst,
+                      uint8_t* own, uint8_t* green, uint8_t* other);
+void bayerGreenRow(const uint8_t* const rows[5], int width, bool greenFirst,
+                   uint8_t* green);
+void bayerColorRow(const uint8_t* const rows[3], const uint8_t* const greens[3],
+                   int width, bool greenFirst, uint8_t* own, uint8_t* other);
+void tensorRow(const uint16_t* top, const uint16_t* bottom, int weight,
+               int width, float scale, float offset, float* dst);
+void tensorRowHalf(const uint16_t* top, const uint16_t* bottom, int weight,
+                   int width, float scale, float offset, uint16_t* dst);
+void resampleRow(const uint8_t* src, const int* index, const int* weight, int width,
+                 uint16_t* dst);
+void yuvToRgbRow(const uint8_t* luma, const uint8_t* u, const uint8_t* v, int width,
+                 uint8_t* r, uint8_t* g, uint8_t* b);
+void transpose8(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst,
+                ptrdiff_t dstStride, int width, int height);
+void transpose16(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst,
+                 ptrdiff_t dstStride, int width, int height);
+void reverse8(const uint8_t* src, uint8_t* dst, int width);
+void reverse16(const uint8_t* src, uint8_t* dst, int width);
+void rangeRow8(const uint8_t* src, int width, int& min, int& max, uint64_t& sum);
+void rangeRow16(const uint16_t* src, int width, int& min, int& max, uint64_t& sum);
+void blendRow(uint8_t* dst, const uint8_t* alpha, const uint8_t* color, int width);
+void lerpRow(const uint8_t* top, const uint8_t* bottom, int weight, int width,
+             uint16_t* dst);
+void downscaleRow(const uint8_t* top, const uint8_t* bottom, int width, uint8_t* dst);
+void accumulateRow(const uint8_t* src, uint16_t* acc, int weight, int threshold,
+                   uint8_t* mask, int width);
+void differenceRow(const uint8_t* a, const uint8_t* b, int threshold, uint8_t* mask,
+                   int width);
+void meanRow(const uint8_t* const rows[], int count, int width, uint8_t* dst);
+void medianRow(const uint8_t* const rows[], int count, int width, uint8_t* dst);
+void deinterlaceRow(const uint8_t* above, const uint8_t* below, const uint8_t* current,
+                    const uint8_t* previous, int threshold, int width, uint8_t* dst);
+void streamCopy(uint8_t* dst, const uint8_t* src, size_t size);
+
+
+
+/**
+ * @brief Get size of frame data buffer allocated by Frame class: data size
+ * of raw frame or width * height * 4 bytes for compressed formats. Size is
+ * calculated in 64 bits with overflow check.
+ * @param fourcc Pixel format.
+ * @param width Frame width.
+ * @param height Frame height.
+ * @return Size (bytes), 0 if width or height is 0 or -1 if format is not
+ * supported, width or height is negative or size is too big.
+ */
+int64_t getBufferSize(Fourcc fourcc, int width, int height);
+
+/**
+ * @brief Get data size of raw (not compressed) frame.
+ * @param fourcc Pixel format.
+ * @param width Frame width.
+ * @param height Frame height.
+ * @return Data size (bytes) or 0 if format is not supported or size is too
+ * big.
+ */
+int64_t getDataSize(Fourcc fourcc, int width, int height);
+
+/**
+ * @brief Prepare output frame. Method reallocates memory if frame has
+ * another size or pixel format and invalidates frame cache.
+ * @param frame Output frame.
+ * @param width Frame width.
+ * @param height Frame height.
+ * @param fourcc Pixel format.
+ * @return TRUE if the frame is ready or FALSE if format is not supported.
+ */
+bool prepareFrame(Frame& frame, int width, int height, Fourcc fourcc);
+
+/**
+ * @brief Read part of frame row as planar RGB. Supports RGB24, BGR24, YUV24,
+ * GRAY, YUYV, UYVY, NV12, NV21, YU12 and YV12 formats. YUV formats are
+ * converted according to BT.601 (limited range).
+ * @param frame Source frame.
+ * @param y Row index.
+ * @param x Index of first pixel.
+ * @param width Number of pixels.
+ * @param r Output red values.
+ * @param g Output green values.
+ * @param b Output blue values.
+ * @return TRUE if the row is read or FALSE if format is not supported.
+ */
+bool readRgbRow(const Frame& frame, int y, int x, int width,
+                uint8_t* r, uint8_t* g, uint8_t* b);
+
+/**
+ * @brief Read part of frame row as planar YUV (BT.601 limited range, chroma
+ * for every pixel). Supports the same formats as readRgbRow(...). YUV
+ * formats are read without color conversion.
+ * @param frame Source frame.
+ * @param y Row index.
+ * @param x Index of first pixel.
+ * @param width Number of pixels.
+ * @param luma Output Y values.
+ * @param u Output U values.
+ * @param v Output V values.
+ * @return TRUE if the row is read or FALSE if format is not supported.
+ */
+bool readYuvRow(const Frame& frame, int y, int x, int width,
+                uint8_t* luma, uint8_t* u, uint8_t* v);
+
+/**
+ * @brief Check if readRgbRow(...) supports pixel format.
+ * @param fourcc Pixel format.
+ * @return TRUE if the format is supported or FALSE if not.
+ */
+bool isRgbReadable(Fourcc fourcc);
+
+
+
+/// Saturate value to [0, 255].
+static inline uint8_t clamp8(int value)
+{
+    return (uint8_t)(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+/// Divide value [0, 65025] by 255 with rounding to nearest.
+static inline int div255(int value)
+{
+    value += 128;
+    return (value + (value >> 8)) >> 8;
+}
+
+/// Y component (BT.601 limited range) of RGB color.
+static inline uint8_t rgbToY(int r, int g, int b)
+{
+    return (uint8_t)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+}
+
+/// U component (BT.601 limited range) of RGB color.
+static inline uint8_t rgbToU(int r, int g, int b)
+{
+    return (uint8_t)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+}
+
+/// V component (BT.601 limited range) of RGB color.
+static inline uint8_t rgbToV(int r, int g, int b)
+{
+    return (uint8_t)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+}
+
+/// Convert YUV (BT.601 limited range) color to RGB.
+static inline void yuvToRgb(int y, int u, int v, uint8_t& r, uint8_t& g, uint8_t& b)
+{
+    int c = 298 * (y - 16) + 128;
+    int d = u - 128;
+    int e = v - 128;
+    r = clamp8((c + 409 * e) >> 8);
+    g = clamp8((c - 100 * d - 208 * e) >> 8);
+    b = clamp8((c + 516 * d) >> 8);
+}
+
+/// Convert float to half precision float (round to nearest even).
+static inline uint16_t floatToHalf(float value)
+{
+    uint32_t f;
+    memcpy(&f, &value, 4);
+    uint32_t sign = (f >> 16) & 0x8000;
+    uint32_t magnitude = f & 0x7FFFFFFF;
+
+    // Infinity and NaN (quiet).
+    if (magnitude >= 0x7F800000)
+        return (uint16_t)(sign | 0x7C00 |
+                          (magnitude > 0x7F800000 ? 0x200 | ((magnitude >> 13) & 0x3FF) : 0));
+
+    // Overflow.
+    if (magnitude >= 0x477FF000)
+        return (uint16_t)(sign | 0x7C00);
+
+    // Normal numbers.
+    if (magnitude >= 0x38800000)
+    {
+        uint32_t h = (magnitude - 0x38000000) >> 13;
+        uint32_t rest = magnitude & 0x1FFF;
+        h += (rest > 0x1000 || (rest == 0x1000 && (h & 1))) ? 1 : 0;
+        return (uint16_t)(sign | h);
+    }
+
+    // Subnormal numbers and zero.
+    if (magnitude < 0x33000000)
+        return (uint16_t)sign;
+    uint32_t shift = 126 - (magnitude >> 23);
+    uint32_t mantissa = (magnitude & 0x7FFFFF) | 0x800000;
+    uint32_t h = mantissa >> shift;
+    uint32_t rest = mantissa & ((1u << shift) - 1);
+    uint32_t half = 1u << (shift - 1);
+    h += (rest > half || (rest == half && (h & 1))) ? 1 : 0;
+    return (uint16_t)(sign | h);
+}
+}
+}
+}
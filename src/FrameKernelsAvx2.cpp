@@ -0,0 +1,155 @@
+#include "FrameKernels.h"
+#if defined(FRAME_SIMD)
+#include <immintrin.h>
+
+
+
+namespace
+{
+
+/// 16 lanes of 16-bit integers.
+typedef __m256i VI;
+const int VI_LANES = 16;
+
+inline VI vSet(int value) { return _mm256_set1_epi16((short)value); }
+inline VI vEvenMask() { return _mm256_set1_epi32(0x0000FFFF); }
+inline VI vAdd(VI a, VI b) { return _mm256_add_epi16(a, b); }
+inline VI vSub(VI a, VI b) { return _mm256_sub_epi16(a, b); }
+inline VI vMul(VI a, VI b) { return _mm256_mullo_epi16(a, b); }
+inline VI vAbs(VI a) { return _mm256_abs_epi16(a); }
+inline VI vAndNot(VI a, VI b) { return _mm256_andnot_si256(a, b); }
+inline VI vMulHi(VI a, VI b) { return _mm256_mulhi_epu16(a, b); }
+inline VI vShiftLeft(VI a, int n) { return _mm256_slli_epi16(a, n); }
+inline VI vShiftRight(VI a, int n) { return _mm256_srli_epi16(a, n); }
+inline VI vShiftRightSigned(VI a, int n) { return _mm256_srai_epi16(a, n); }
+inline VI vLess(VI a, VI b) { return _mm256_cmpgt_epi16(b, a); }
+inline VI vBlend(VI mask, VI a, VI b) { return _mm256_blendv_epi8(b, a, mask); }
+
+/// Load 16 bytes and extend to 16-bit lanes.
+inline VI vLoadU8(const uint8_t* p)
+{
+    return _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)p));
+}
+
+/// Store 16 lanes as bytes with saturation.
+inline void vStoreU8(uint8_t* p, VI a)
+{
+    __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, a), 0xD8);
+    _mm_storeu_si128((__m128i*)p, _mm256_castsi256_si128(packed));
+}
+
+/// Load and store lanes as 16-bit values.
+inline VI vLoadU16(const uint16_t* p) { return _mm256_loadu_si256((const __m256i*)p); }
+inline void vStoreU16(uint16_t* p, VI a) { _mm256_storeu_si256((__m256i*)p, a); }
+
+
+/// 8 lanes of 32-bit integers and floats.
+typedef __m256i VW;
+typedef __m256 VF;
+const int VF_LANES = 8;
+
+inline VW vSetW(int value) { return _mm256_set1_epi32(value); }
+inline VW vAddW(VW a, VW b) { return _mm256_add_epi32(a, b); }
+inline VW vMulW(VW a, VW b) { return _mm256_mullo_epi32(a, b); }
+inline VW vShiftRightW(VW a, int n) { return _mm256_srli_epi32(a, n); }
+inline VW vShiftRightSignedW(VW a, int n) { return _mm256_srai_epi32(a, n); }
+inline VW vAndW(VW a, VW b) { return _mm256_and_si256(a, b); }
+inline VW vLoadW(const int* p) { return _mm256_loadu_si256((const __m256i*)p); }
+inline VF vToFloat(VW a) { return _mm256_cvtepi32_ps(a); }
+inline VF vSetF(float value) { return _mm256_set1_ps(value); }
+inline VF vAddF(VF a, VF b) { return _mm256_add_ps(a, b); }
+inline VF vMulF(VF a, VF b) { return _mm256_mul_ps(a, b); }
+inline void vStoreF(float* p, VF a) { _mm256_storeu_ps(p, a); }
+inline VW vTruncW(VF a) { return _mm256_cvttps_epi32(a); }
+
+/// Store 8 lanes as bytes with saturation.
+inline void vStoreU8W(uint8_t* p, VW a)
+{
+    __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(a, a), a);
+    __m128i low = _mm256_castsi256_si128(packed);
+    __m128i high = _mm256_extracti128_si256(packed, 1);
+    _mm_storel_epi64((__m128i*)p, _mm_unpacklo_epi32(low, high));
+}
+
+/// Load 8 16-bit values and extend to 32-bit lanes.
+inline VW vLoadU16W(const uint16_t* p)
+{
+    return _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)p));
+}
+
+/// Load 8 bytes and extend to 32-bit lanes.
+inline VW vLoadU8W(const uint8_t* p)
+{
+    return _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)p));
+}
+
+/// Store 8 lanes as 16-bit values with saturation.
+inline void vStoreU16W(uint16_t* p, VW a)
+{
+    __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(a, a), 0xD8);
+    _mm_storeu_si128((__m128i*)p, _mm256_castsi256_si128(packed));
+}
+
+/// Gather 8 pairs of bytes (src[index], src[index + 1]) to low 16 bits of
+/// lanes. Gather reads 4 bytes from every index.
+inline VW vGatherU16W(const uint8_t* src, const int* index)
+{
+    return _mm256_i32gather_epi32((const int*)src, vLoadW(index), 1);
+}
+
+/// Store 8 lanes as half precision floats.
+inline void vStoreHalf(uint16_t* p, VF a)
+{
+    _mm_storeu_si128((__m128i*)p, _mm256_cvtps_ph(a, _MM_FROUND_TO_NEAREST_INT));
+}
+
+
+/// 32 bytes.
+typedef __m256i VB;
+const int VB_LANES = 32;
+
+inline VB vLoadB(const uint8_t* p) { return _mm256_loadu_si256((const __m256i*)p); }
+inline void vStoreB(uint8_t* p, VB a) { _mm256_storeu_si256((__m256i*)p, a); }
+inline void vStreamB(uint8_t* p, VB a) { _mm256_stream_si256((__m256i*)p, a); }
+inline void vStreamFence() { _mm_sfence(); }
+inline VB vZeroB() { return _mm256_setzero_si256(); }
+inline VB vMinU8(VB a, VB b) { return _mm256_min_epu8(a, b); }
+inline VB vMaxU8(VB a, VB b) { return _mm256_max_epu8(a, b); }
+inline VB vAvgU8(VB a, VB b) { return _mm256_avg_epu8(a, b); }
+inline VB vMinU16(VB a, VB b) { return _mm256_min_epu16(a, b); }
+inline VB vMaxU16(VB a, VB b) { return _mm256_max_epu16(a, b); }
+inline VB vAdd64(VB a, VB b) { return _mm256_add_epi64(a, b); }
+inline VB vLowBytes(VB a) { return _mm256_and_si256(a, _mm256_set1_epi16(0x00FF)); }
+inline VB vHighBytes(VB a) { return _mm256_srli_epi16(a, 8); }
+
+/// Sums of 8 bytes groups in 64-bit lanes.
+inline VB vSumU8(VB a) { return _mm256_sad_epu8(a, _mm256_setzero_si256()); }
+
+/// Load 32 bytes and store them in reverse order.
+inline void vReverseU8(const uint8_t* src, uint8_t* dst)
+{
+    const __m256i order = _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8,
+                                           7, 6, 5, 4, 3, 2, 1, 0,
+                                           15, 14, 13, 12, 11, 10, 9, 8,
+                                           7, 6, 5, 4, 3, 2, 1, 0);
+    __m256i a = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)src), order);
+    _mm256_storeu_si256((__m256i*)dst, _mm256_permute4x64_epi64(a, 0x4E));
+}
+
+/// Load 16 16-bit values and store them in reverse order.
+inline void vReverseU16(const uint8_t* src, uint8_t* dst)
+{
+    const __m256i order = _mm256_setr_epi8(14, 15, 12, 13, 10, 11, 8, 9,
+                                           6, 7, 4, 5, 2, 3, 0, 1,
+                                           14, 15, 12, 13, 10, 11, 8, 9,
+                                           6, 7, 4, 5, 2, 3, 0, 1);
+    __m256i a = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)src), order);
+    _mm256_storeu_si256((__m256i*)dst, _mm256_permute4x64_epi64(a, 0x4E));
+}
+}
+
+
+
+#define FRAME_KERNELS_INIT initAvx2
+#include "FrameKernelsSimd.h"
+#endif
@@ -0,0 +1,766 @@
+/*
+ * Internal file. SIMD kernels written once for SSE4.1 and AVX2. The file is
+ * included by FrameKernelsSse41.cpp and FrameKernelsAvx2.cpp after definition
+ * of vector types VI (16-bit integer lanes), VW (32-bit integer lanes) and
+ * VF (float lanes), VB (bytes), constants VI_LANES, VF_LANES and VB_LANES,
+ * v* helper functions for particular instruction set and
+ * FRAME_KERNELS_INIT macro with name of table initialization function.
+ * Kernels process VI_LANES or VF_LANES pixels per iteration and call scalar
+ * kernels for row tail. Transpose kernels use 128-bit operations (8x8 blocks)
+ * for both instruction sets.
+ */
+
+
+
+namespace
+{
+
+using namespace cr::video;
+using namespace cr::video::kernels;
+
+
+
+/// Mask of lanes with green pixels in Bayer row.
+inline VI bayerGreenMask(bool greenFirst)
+{
+    VI even = vEvenMask();
+    return greenFirst ? even : vAndNot(even, vSet(-1));
+}
+
+
+
+void simdBayerBilinearRow(const uint8_t* const rows[3], int width,
+                          bool greenFirst, uint8_t* own, uint8_t* green,
+                          uint8_t* other)
+{
+    const uint8_t* u = rows[0];
+    const uint8_t* m = rows[1];
+    const uint8_t* d = rows[2];
+    const VI greenMask = bayerGreenMask(greenFirst);
+    const VI one = vSet(1);
+    const VI two = vSet(2);
+
+    int x = 0;
+    for (; x + VI_LANES <= width; x += VI_LANES)
+    {
+        VI c = vLoadU8(m + x);
+        VI h = vAdd(vLoadU8(m + x - 1), vLoadU8(m + x + 1));
+        VI v = vAdd(vLoadU8(u + x), vLoadU8(d + x));
+        VI diag = vAdd(vAdd(vLoadU8(u + x - 1), vLoadU8(u + x + 1)),
+                       vAdd(vLoadU8(d + x - 1), vLoadU8(d + x + 1)));
+
+        VI h2 = vShiftRight(vAdd(h, one), 1);
+        VI v2 = vShiftRight(vAdd(v, one), 1);
+        VI cross = vShiftRight(vAdd(vAdd(h, v), two), 2);
+        VI diag4 = vShiftRight(vAdd(diag, two), 2);
+
+        vStoreU8(own + x, vBlend(greenMask, h2, c));
+        vStoreU8(green + x, vBlend(greenMask, c, cross));
+        vStoreU8(other + x, vBlend(greenMask, v2, diag4));
+    }
+
+    // Row tail. Offset is even so pixels order is the same.
+    if (x < width)
+    {
+        const uint8_t* tail[3] = {u + x, m + x, d + x};
+        bayerBilinearRow(tail, width - x, greenFirst, own + x, green + x, other + x);
+    }
+}
+
+
+
+void simdBayerGreenRow(const uint8_t* const rows[5], int width,
+                       bool greenFirst, uint8_t* green)
+{
+    const uint8_t* uu = rows[0];
+    const uint8_t* u = rows[1];
+    const uint8_t* m = rows[2];
+    const uint8_t* d = rows[3];
+    const uint8_t* dd = rows[4];
+    const VI greenMask = bayerGreenMask(greenFirst);
+    const VI one = vSet(1);
+    const VI two = vSet(2);
+
+    int x = 0;
+    for (; x + VI_LANES <= width; x += VI_LANES)
+    {
+        VI c = vLoadU8(m + x);
+        VI l = vLoadU8(m + x - 1);
+        VI r = vLoadU8(m + x + 1);
+        VI up = vLoadU8(u + x);
+        VI dn = vLoadU8(d + x);
+        VI c2 = vAdd(c, c);
+
+        // Second order derivatives and gradients.
+        VI lh = vSub(vSub(c2, vLoadU8(m + x - 2)), vLoadU8(m + x + 2));
+        VI lv = vSub(vSub(c2, vLoadU8(uu + x)), vLoadU8(dd + x));
+        VI dh = vAdd(vAbs(vSub(l, r)), vAbs(lh));
+        VI dv = vAdd(vAbs(vSub(up, dn)), vAbs(lv));
+
+        // Interpolate along direction with lower gradient.
+        VI h = vAdd(l, r);
+        VI v = vAdd(up, dn);
+        VI gh = vShiftRightSigned(vAdd(vAdd(vAdd(h, h), lh), two), 2);
+        VI gv = vShiftRightSigned(vAdd(vAdd(vAdd(v, v), lv), two), 2);
+        VI avg = vShiftRightSigned(vAdd(vAdd(gh, gv), one), 1);
+        VI g = vBlend(vLess(dh, dv), gh, vBlend(vLess(dv, dh), gv, avg));
+
+        vStoreU8(green + x, vBlend(greenMask, c, g));
+    }
+
+    // Row tail.
+    if (x < width)
+    {
+        const uint8_t* tail[5] = {uu + x, u + x, m + x, d + x, dd + x};
+        bayerGreenRow(tail, width - x, greenFirst, green + x);
+    }
+}
+
+
+
+void simdBayerColorRow(const uint8_t* const rows[3],
+                       const uint8_t* const greens[3], int width,
+                       bool greenFirst, uint8_t* own, uint8_t* other)
+{
+    const uint8_t* u = rows[0];
+    const uint8_t* m = rows[1];
+    const uint8_t* d = rows[2];
+    const uint8_t* gu = greens[0];
+    const uint8_t* gm = greens[1];
+    const uint8_t* gd = greens[2];
+    const VI greenMask = bayerGreenMask(greenFirst);
+    const VI one = vSet(1);
+    const VI two = vSet(2);
+
+    int x = 0;
+    for (; x + VI_LANES <= width; x += VI_LANES)
+    {
+        VI c = vLoadU8(m + x);
+        VI g = vLoadU8(gm + x);
+
+        // Color differences of neighbours.
+        VI dl = vSub(vLoadU8(m + x - 1), vLoadU8(gm + x - 1));
+        VI dr = vSub(vLoadU8(m + x + 1), vLoadU8(gm + x + 1));
+        VI du = vSub(vLoadU8(u + x), vLoadU8(gu + x));
+        VI dd = vSub(vLoadU8(d + x), vLoadU8(gd + x));
+        VI diag = vAdd(vAdd(vSub(vLoadU8(u + x - 1), vLoadU8(gu + x - 1)),
+                            vSub(vLoadU8(u + x + 1), vLoadU8(gu + x + 1))),
+                       vAdd(vSub(vLoadU8(d + x - 1), vLoadU8(gd + x - 1)),
+                            vSub(vLoadU8(d + x + 1), vLoadU8(gd + x + 1))));
+
+        VI ownGreen = vAdd(g, vShiftRightSigned(vAdd(vAdd(dl, dr), one), 1));
+        VI otherGreen = vAdd(g, vShiftRightSigned(vAdd(vAdd(du, dd), one), 1));
+        VI otherColor = vAdd(g, vShiftRightSigned(vAdd(diag, two), 2));
+
+        vStoreU8(own + x, vBlend(greenMask, ownGreen, c));
+        vStoreU8(other + x, vBlend(greenMask, otherGreen, otherColor));
+    }
+
+    // Row tail.
+    if (x < width)
+    {
+        const uint8_t* tail[3] = {u + x, m + x, d + x};
+        const uint8_t* tailGreens[3] = {gu + x, gm + x, gd + x};
+        bayerColorRow(tail, tailGreens, width - x, greenFirst, own + x, other + x);
+    }
+}
+
+
+
+void simdTensorRow(const uint16_t* top, const uint16_t* bottom, int weight,
+                   int width, float scale, float offset, float* dst)
+{
+    const VW topWeight = vSetW(256 - weight);
+    const VW bottomWeight = vSetW(weight);
+    const VW round = vSetW(128);
+    const VF scaleF = vSetF(scale);
+    const VF offsetF = vSetF(offset);
+
+    int x = 0;
+    for (; x + VF_LANES <= width; x += VF_LANES)
+    {
+        VW value = vAddW(vMulW(vLoadU16W(top + x), topWeight),
+                         vMulW(vLoadU16W(bottom + x), bottomWeight));
+        value = vShiftRightW(vAddW(value, round), 8);
+        vStoreF(dst + x, vAddF(vMulF(vToFloat(value), scaleF), offsetF));
+    }
+
+    // Row tail.
+    if (x < width)
+        tensorRow(top + x, bottom + x, weight, width - x, scale, offset, dst + x);
+}
+
+
+
+void simdTensorRowHalf(const uint16_t* top, const uint16_t* bottom, int weight,
+                       int width, float scale, float offset, uint16_t* dst)
+{
+    const VW topWeight = vSetW(256 - weight);
+    const VW bottomWeight = vSetW(weight);
+    const VW round = vSetW(128);
+    const VF scaleF = vSetF(scale);
+    const VF offsetF = vSetF(offset);
+
+    int x = 0;
+    for (; x + VF_LANES <= width; x += VF_LANES)
+    {
+        VW value = vAddW(vMulW(vLoadU16W(top + x), topWeight),
+                         vMulW(vLoadU16W(bottom + x), bottomWeight));
+        value = vShiftRightW(vAddW(value, round), 8);
+        vStoreHalf(dst + x, vAddF(vMulF(vToFloat(value), scaleF), offsetF));
+    }
+
+    // Row tail.
+    if (x < width)
+        tensorRowHalf(top + x, bottom + x, weight, width - x, scale, offset, dst + x);
+}
+
+
+
+void simdResampleRow(const uint8_t* src, const int* index, const int* weight,
+                     int width, uint16_t* dst)
+{
+    const VW byteMask = vSetW(255);
+    const VW full = vSetW(256);
+
+    // src[index] * (256 - weight) + src[index + 1] * weight = src[index] *
+    // 256 + (src[index + 1] - src[index]) * weight.
+    int x = 0;
+    for (; x + VF_LANES <= width; x += VF_LANES)
+    {
+        VW pairs = vGatherU16W(src, index + x);
+        VW first = vAndW(pairs, byteMask);
+        VW second = vAndW(vShiftRightW(pairs, 8), byteMask);
+        VW w = vLoadW(weight + x);
+        vStoreU16W(dst + x, vAddW(vMulW(first, vAddW(full, vMulW(w, vSetW(-1)))),
+                                  vMulW(second, w)));
+    }
+
+    // Row tail.
+    if (x < width)
+        resampleRow(src, index + x, weight + x, width - x, dst + x);
+}
+
+
+
+void simdYuvToRgbRow(const uint8_t* luma, const uint8_t* u, const uint8_t* v,
+                     int width, uint8_t* r, uint8_t* g, uint8_t* b)
+{
+    // yuvToRgb(...) with constant terms folded: r = (298 * y + 409 * v -
+    // 56992) >> 8, g = (298 * y - 100 * u - 208 * v + 34784) >> 8, b = (298
+    // * y + 516 * u - 70688) >> 8. Stores saturate results to [0, 255].
+    const VW ky = vSetW(298);
+    const VW krv = vSetW(409);
+    const VW kgu = vSetW(-100);
+    const VW kgv = vSetW(-208);
+    const VW kbu = vSetW(516);
+    const VW cr = vSetW(-56992);
+    const VW cg = vSetW(34784);
+    const VW cb = vSetW(-70688);
+
+    // All inputs of lanes are loaded before outputs are stored, so outputs
+    // can be the same rows as inputs.
+    int x = 0;
+    for (; x + VF_LANES <= width; x += VF_LANES)
+    {
+        VW yy = vMulW(vLoadU8W(luma + x), ky);
+        VW uu = vLoadU8W(u + x);
+        VW vv = vLoadU8W(v + x);
+        VW red = vAddW(vAddW(yy, vMulW(vv, krv)), cr);
+        VW green = vAddW(vAddW(yy, vAddW(vMulW(uu, kgu), vMulW(vv, kgv))), cg);
+        VW blue = vAddW(vAddW(yy, vMulW(uu, kbu)), cb);
+        vStoreU8W(r + x, vShiftRightSignedW(red, 8));
+        vStoreU8W(g + x, vShiftRightSignedW(green, 8));
+        vStoreU8W(b + x, vShiftRightSignedW(blue, 8));
+    }
+
+    // Row tail.
+    if (x < width)
+        yuvToRgbRow(luma + x, u + x, v + x, width - x, r + x, g + x, b + x);
+}
+
+
+
+void simdTranspose8(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst,
+                    ptrdiff_t dstStride, int width, int height)
+{
+    int bx = width & ~7;
+    int by = height & ~7;
+    for (int y = 0; y < by; y += 8)
+    {
+        for (int x = 0; x < bx; x += 8)
+        {
+            const uint8_t* s = src + y * srcStride + x;
+            __m128i r[8];
+            for (int i = 0; i < 8; ++i)
+                r[i] = _mm_loadl_epi64((const __m128i*)(s + i * srcStride));
+
+            // Interleave bytes, words and double words of row pairs.
+            __m128i a0 = _mm_unpacklo_epi8(r[0], r[1]);
+            __m128i a1 = _mm_unpacklo_epi8(r[2], r[3]);
+            __m128i a2 = _mm_unpacklo_epi8(r[4], r[5]);
+            __m128i a3 = _mm_unpacklo_epi8(r[6], r[7]);
+            __m128i b0 = _mm_unpacklo_epi16(a0, a1);
+            __m128i b1 = _mm_unpackhi_epi16(a0, a1);
+            __m128i b2 = _mm_unpacklo_epi16(a2, a3);
+            __m128i b3 = _mm_unpackhi_epi16(a2, a3);
+            __m128i c[4] = {_mm_unpacklo_epi32(b0, b2), _mm_unpackhi_epi32(b0, b2),
+                            _mm_unpacklo_epi32(b1, b3), _mm_unpackhi_epi32(b1, b3)};
+
+            // Each register contains two columns.
+            uint8_t* d = dst + x * dstStride + y;
+            for (int i = 0; i < 4; ++i)
+            {
+                _mm_storel_epi64((__m128i*)(d + (2 * i) * dstStride), c[i]);
+                _mm_storel_epi64((__m128i*)(d + (2 * i + 1) * dstStride),
+                                 _mm_srli_si128(c[i], 8));
+            }
+        }
+    }
+
+    // Right and bottom parts.
+    if (bx < width)
+        transpose8(src + bx, srcStride, dst + bx * dstStride, dstStride, width - bx, height);
+    if (by < height)
+        transpose8(src + by * srcStride, srcStride, dst + by, dstStride, bx, height - by);
+}
+
+
+
+void simdTranspose16(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst,
+                     ptrdiff_t dstStride, int width, int height)
+{
+    int bx = width & ~7;
+    int by = height & ~7;
+    for (int y = 0; y < by; y += 8)
+    {
+        for (int x = 0; x < bx; x += 8)
+        {
+            const uint8_t* s = src + y * srcStride + x * 2;
+            __m128i r[8];
+            for (int i = 0; i < 8; ++i)
+                r[i] = _mm_loadu_si128((const __m128i*)(s + i * srcStride));
+
+            // Interleave words, double words and quad words of row pairs.
+            __m128i a[8];
+            for (int i = 0; i < 4; ++i)
+            {
+                a[2 * i] = _mm_unpacklo_epi16(r[2 * i], r[2 * i + 1]);
+                a[2 * i + 1] = _mm_unpackhi_epi16(r[2 * i], r[2 * i + 1]);
+            }
+            __m128i b[8];
+            for (int i = 0; i < 2; ++i)
+            {
+                b[4 * i] = _mm_unpacklo_epi32(a[4 * i], a[4 * i + 2]);
+                b[4 * i + 1] = _mm_unpackhi_epi32(a[4 * i], a[4 * i + 2]);
+                b[4 * i + 2] = _mm_unpacklo_epi32(a[4 * i + 1], a[4 * i + 3]);
+                b[4 * i + 3] = _mm_unpackhi_epi32(a[4 * i + 1], a[4 * i + 3]);
+            }
+            uint8_t* d = dst + x * dstStride + y * 2;
+            for (int i = 0; i < 4; ++i)
+            {
+                _mm_storeu_si128((__m128i*)(d + (2 * i) * dstStride),
+                                 _mm_unpacklo_epi64(b[i], b[i + 4]));
+                _mm_storeu_si128((__m128i*)(d + (2 * i + 1) * dstStride),
+                                 _mm_unpackhi_epi64(b[i], b[i + 4]));
+            }
+        }
+    }
+
+    // Right and bottom parts.
+    if (bx < width)
+        transpose16(src + bx * 2, srcStride, dst + bx * dstStride, dstStride, width - bx, height);
+    if (by < height)
+        transpose16(src + by * srcStride, srcStride, dst + by * 2, dstStride, bx, height - by);
+}
+
+
+
+void simdReverse8(const uint8_t* src, uint8_t* dst, int width)
+{
+    int x = 0;
+    for (; x + VB_LANES <= width; x += VB_LANES)
+        vReverseU8(src + width - x - VB_LANES, dst + x);
+
+    // Row tail: first elements of source.
+    if (x < width)
+        reverse8(src, dst + x, width - x);
+}
+
+
+
+void simdReverse16(const uint8_t* src, uint8_t* dst, int width)
+{
+    const int lanes = VB_LANES / 2;
+    int x = 0;
+    for (; x + lanes <= width; x += lanes)
+        vReverseU16(src + (width - x - lanes) * 2, dst + x * 2);
+
+    // Row tail: first elements of source.
+    if (x < width)
+        reverse16(src, dst + x * 2, width - x);
+}
+
+
+
+void simdRangeRow8(const uint8_t* src, int width, int& min, int& max,
+                   uint64_t& sum)
+{
+    int x = 0;
+    if (width >= VB_LANES)
+    {
+        VB minV = vLoadB(src);
+        VB maxV = minV;
+        VB sumV = vZeroB();
+        for (; x + VB_LANES <= width; x += VB_LANES)
+        {
+            VB a = vLoadB(src + x);
+            minV = vMinU8(minV, a);
+            maxV = vMaxU8(maxV, a);
+            sumV = vAdd64(sumV, vSumU8(a));
+        }
+
+        // Reduce lanes.
+        uint8_t mins[VB_LANES];
+        uint8_t maxs[VB_LANES];
+        uint64_t sums[VB_LANES / 8];
+        vStoreB(mins, minV);
+        vStoreB(maxs, maxV);
+        vStoreB((uint8_t*)sums, sumV);
+        for (int i = 0; i < VB_LANES; ++i)
+        {
+            min = mins[i] < min ? mins[i] : min;
+            max = maxs[i] > max ? maxs[i] : max;
+        }
+        for (int i = 0; i < VB_LANES / 8; ++i)
+            sum += sums[i];
+    }
+
+    // Row tail.
+    if (x < width)
+        rangeRow8(src + x, width - x, min, max, sum);
+}
+
+
+
+void simdRangeRow16(const uint16_t* src, int width, int& min, int& max,
+                    uint64_t& sum)
+{
+    const int lanes = VB_LANES / 2;
+    int x = 0;
+    if (width >= lanes)
+    {
+        VB minV = vLoadB((const uint8_t*)src);
+        VB maxV = minV;
+        VB lowV = vZeroB();
+        VB highV = vZeroB();
+        for (; x + lanes <= width; x += lanes)
+        {
+            VB a = vLoadB((const uint8_t*)(src + x));
+            minV = vMinU16(minV, a);
+            maxV = vMaxU16(maxV, a);
+
+            // Sum of low and high bytes separately.
+            lowV = vAdd64(lowV, vSumU8(vLowBytes(a)));
+            highV = vAdd64(highV, vSumU8(vHighBytes(a)));
+        }
+
+        // Reduce lanes.
+        uint16_t mins[VB_LANES / 2];
+        uint16_t maxs[VB_LANES / 2];
+        uint64_t lows[VB_LANES / 8];
+        uint64_t highs[VB_LANES / 8];
+        vStoreB((uint8_t*)mins, minV);
+        vStoreB((uint8_t*)maxs, maxV);
+        vStoreB((uint8_t*)lows, lowV);
+        vStoreB((uint8_t*)highs, highV);
+        for (int i = 0; i < lanes; ++i)
+        {
+            min = mins[i] < min ? mins[i] : min;
+            max = maxs[i] > max ? maxs[i] : max;
+        }
+        for (int i = 0; i < VB_LANES / 8; ++i)
+            sum += lows[i] + (highs[i] << 8);
+    }
+
+    // Row tail.
+    if (x < width)
+        rangeRow16(src + x, width - x, min, max, sum);
+}
+
+
+
+void simdBlendRow(uint8_t* dst, const uint8_t* alpha, const uint8_t* color,
+                  int width)
+{
+    const VI full = vSet(255);
+    const VI half = vSet(128);
+
+    // Values up to 255 * 255 + 128 + 254 fit 16-bit lanes (unsigned).
+    int x = 0;
+    for (; x + VI_LANES <= width; x += VI_LANES)
+    {
+        VI a = vLoadU8(alpha + x);
+        VI t = vAdd(vAdd(vMul(vLoadU8(dst + x), vSub(full, a)),
+                         vMul(vLoadU8(color + x), a)), half);
+        vStoreU8(dst + x, vShiftRight(vAdd(t, vShiftRight(t, 8)), 8));
+    }
+
+    // Row tail.
+    if (x < width)
+        blendRow(dst + x, alpha + x, color + x, width - x);
+}
+
+
+
+void simdLerpRow(const uint8_t* top, const uint8_t* bottom, int weight,
+                 int width, uint16_t* dst)
+{
+    const VI topWeight = vSet(256 - weight);
+    const VI bottomWeight = vSet(weight);
+
+    // Values up to 255 * 256 fit 16-bit lanes (unsigned).
+    int x = 0;
+    for (; x + VI_LANES <= width; x += VI_LANES)
+        vStoreU16(dst + x, vAdd(vMul(vLoadU8(top + x), topWeight),
+                                vMul(vLoadU8(bottom + x), bottomWeight)));
+
+    // Row tail.
+    if (x < width)
+        lerpRow(top + x, bottom + x, weight, width - x, dst + x);
+}
+
+
+
+void simdDownscaleRow(const uint8_t* top, const uint8_t* bottom, int width,
+                      uint8_t* dst)
+{
+    const VI two = vSet(2);
+
+    // Sums of pixel pairs in 16-bit lanes (VB_LANES bytes give VI_LANES
+    // output pixels).
+    int x = 0;
+    for (; x + VI_LANES <= width; x += VI_LANES)
+    {
+        VB t = vLoadB(top + 2 * x);
+        VB b = vLoadB(bottom + 2 * x);
+        VI sum = vAdd(vAdd(vLowBytes(t), vHighBytes(t)), vAdd(vLowBytes(b), vHighBytes(b)));
+        vStoreU8(dst + x, vShiftRight(vAdd(sum, two), 2));
+    }
+
+    // Row tail.
+    if (x < width)
+        downscaleRow(top + 2 * x, bottom + 2 * x, width - x, dst + x);
+}
+
+
+
+void simdAccumulateRow(const uint8_t* src, uint16_t* acc, int weight,
+                       int threshold, uint8_t* mask, int width)
+{
+    const VI accWeight = vSet(65536 - weight);
+    const VI half = vSet(128);
+    const VI limit = vSet(threshold);
+
+    // Accumulator values up to 65280 fit 16-bit lanes (unsigned). Positive
+    // and negative differences are separated by unsigned min / max, products
+    // are computed as high halves of 32-bit results.
+    int x = 0;
+    for (; x + VI_LANES <= width; x += VI_LANES)
+    {
+        VI value = vLoadU8(src + x);
+        VI a = vLoadU16(acc + x);
+        if (mask != nullptr)
+        {
+            VI difference = vAbs(vSub(value, vShiftRight(vAdd(a, half), 8)));
+            vStoreU8(mask + x, vShiftRight(vLess(limit, difference), 8));
+        }
+        VI target = vShiftLeft(value, 8);
+        VI up = vSub(vMaxU16(target, a), a);
+        VI down = vSub(a, vMinU16(target, a));
+        up = vSub(up, vMulHi(up, accWeight));
+        down = vSub(down, vMulHi(down, accWeight));
+        vStoreU16(acc + x, vSub(vAdd(a, up), down));
+    }
+
+    // Row tail.
+    if (x < width)
+        accumulateRow(src + x, acc + x, weight, threshold,
+                      mask != nullptr ? mask + x : nullptr, width - x);
+}
+
+
+
+void simdDifferenceRow(const uint8_t* a, const uint8_t* b, int threshold,
+                       uint8_t* mask, int width)
+{
+    const VI limit = vSet(threshold);
+    int x = 0;
+    for (; x + VI_LANES <= width; x += VI_LANES)
+    {
+        VI difference = vAbs(vSub(vLoadU8(a + x), vLoadU8(b + x)));
+        vStoreU8(mask + x, vShiftRight(vLess(limit, difference), 8));
+    }
+
+    // Row tail.
+    if (x < width)
+        differenceRow(a + x, b + x, threshold, mask + x, width - x);
+}
+
+
+
+void simdMeanRow(const uint8_t* const rows[], int count, int width, uint8_t* dst)
+{
+    const VF scale = vSetF(1.0f / (float)count);
+    const VF half = vSetF(0.5f);
+
+    // Sums up to 257 * 255 fit 16-bit lanes (unsigned).
+    uint16_t sums[VI_LANES];
+    int x = 0;
+    for (; x + VI_LANES <= width; x += VI_LANES)
+    {
+        VI sum = vLoadU8(rows[0] + x);
+        for (int i = 1; i < count; ++i)
+            sum = vAdd(sum, vLoadU8(rows[i] + x));
+        vStoreU16(sums, sum);
+        for (int i = 0; i < VI_LANES; i += VF_LANES)
+            vStoreU8W(dst + x + i, vTruncW(vAddF(vMulF(vToFloat(vLoadU16W(sums + i)), scale),
+                                                 half)));
+    }
+
+    // Row tail.
+    if (x < width)
+    {
+        const uint8_t* tails[257];
+        for (int i = 0; i < count; ++i)
+            tails[i] = rows[i] + x;
+        meanRow(tails, count, width - x, dst + x);
+    }
+}
+
+
+
+void simdMedianRow(const uint8_t* const rows[], int count, int width, uint8_t* dst)
+{
+    // Odd-even transposition sort of rows.
+    VB values[16];
+    int x = 0;
+    for (; x + VB_LANES <= width; x += VB_LANES)
+    {
+        for (int i = 0; i < count; ++i)
+            values[i] = vLoadB(rows[i] + x);
+        for (int pass = 0; pass < count; ++pass)
+        {
+            for (int i = pass & 1; i + 1 < count; i += 2)
+            {
+                VB low = vMinU8(values[i], values[i + 1]);
+                values[i + 1] = vMaxU8(values[i], values[i + 1]);
+                values[i] = low;
+            }
+        }
+        vStoreB(dst + x, count % 2 != 0 ? values[count / 2] :
+                         vAvgU8(values[count / 2 - 1], values[count / 2]));
+    }
+
+    // Row tail.
+    if (x < width)
+    {
+        const uint8_t* tails[16];
+        for (int i = 0; i < count; ++i)
+            tails[i] = rows[i] + x;
+        medianRow(tails, count, width - x, dst + x);
+    }
+}
+
+
+
+void simdDeinterlaceRow(const uint8_t* above, const uint8_t* below,
+                        const uint8_t* current, const uint8_t* previous,
+                        int threshold, int width, uint8_t* dst)
+{
+    int x = 0;
+    if (previous == nullptr)
+    {
+        for (; x + VB_LANES <= width; x += VB_LANES)
+            vStoreB(dst + x, vAvgU8(vLoadB(above + x), vLoadB(below + x)));
+    }
+    else
+    {
+        const VI limit = vSet(threshold);
+        const VI one = vSet(1);
+        for (; x + VI_LANES <= width; x += VI_LANES)
+        {
+            VI value = vLoadU8(current + x);
+            VI motion = vLess(limit, vAbs(vSub(value, vLoadU8(previous + x))));
+            VI average = vShiftRight(vAdd(vAdd(vLoadU8(above + x), vLoadU8(below + x)), one), 1);
+            vStoreU8(dst + x, vBlend(motion, average, value));
+        }
+    }
+
+    // Row tail.
+    if (x < width)
+        deinterlaceRow(above + x, below + x, current + x,
+                       previous != nullptr ? previous + x : nullptr, threshold,
+                       width - x, dst + x);
+}
+
+
+
+void simdStreamCopy(uint8_t* dst, const uint8_t* src, size_t size)
+{
+    // Copy head to align destination for streaming stores.
+    size_t head = (size_t)(VB_LANES - (int)((uintptr_t)dst & (VB_LANES - 1))) & (VB_LANES - 1);
+    if (head > size)
+        head = size;
+    memcpy(dst, src, head);
+
+    size_t x = head;
+    for (; x + 4 * VB_LANES <= size; x += 4 * VB_LANES)
+    {
+        VB a = vLoadB(src + x);
+        VB b = vLoadB(src + x + VB_LANES);
+        VB c = vLoadB(src + x + 2 * VB_LANES);
+        VB d = vLoadB(src + x + 3 * VB_LANES);
+        vStreamB(dst + x, a);
+        vStreamB(dst + x + VB_LANES, b);
+        vStreamB(dst + x + 2 * VB_LANES, c);
+        vStreamB(dst + x + 3 * VB_LANES, d);
+    }
+    for (; x + VB_LANES <= size; x += VB_LANES)
+        vStreamB(dst + x, vLoadB(src + x));
+
+    // Streaming stores are weakly ordered.
+    vStreamFence();
+
+    // Tail.
+    memcpy(dst + x, src + x, size - x);
+}
+}
+
+
+
+void cr::video::kernels::FRAME_KERNELS_INIT(KernelTable& table)
+{
+    table.bayerBilinearRow = simdBayerBilinearRow;
+    table.bayerGreenRow = simdBayerGreenRow;
+    table.bayerColorRow = simdBayerColorRow;
+    table.tensorRow = simdTensorRow;
+    table.tensorRowHalf = simdTensorRowHalf;
+    table.resampleRow = simdResampleRow;
+    table.yuvToRgbRow = simdYuvToRgbRow;
+    table.transpose8 = simdTranspose8;
+    table.transpose16 = simdTranspose16;
+    table.reverse8 = simdReverse8;
+    table.reverse16 = simdReverse16;
+    table.rangeRow8 = simdRangeRow8;
+    table.rangeRow16 = simdRangeRow16;
+    table.blendRow = simdBlendRow;
+    table.lerpRow = simdLerpRow;
+    table.downscaleRow = simdDownscaleRow;
+    table.accumulateRow = simdAccumulateRow;
+    table.differenceRow = simdDifferenceRow;
+    table.meanRow = simdMeanRow;
+    table.medianRow = simdMedianRow;
+    table.deinterlaceRow = simdDeinterlaceRow;
+    table.streamCopy = simdStreamCopy;
+}
@@ -0,0 +1,155 @@
+#include "FrameKernels.h"
+#if defined(FRAME_SIMD)
+#include <immintrin.h>
+
+
+
+namespace
+{
+
+/// 8 lanes of 16-bit integers.
+typedef __m128i VI;
+const int VI_LANES = 8;
+
+inline VI vSet(int value) { return _mm_set1_epi16((short)value); }
+inline VI vEvenMask() { return _mm_set1_epi32(0x0000FFFF); }
+inline VI vAdd(VI a, VI b) { return _mm_add_epi16(a, b); }
+inline VI vSub(VI a, VI b) { return _mm_sub_epi16(a, b); }
+inline VI vMul(VI a, VI b) { return _mm_mullo_epi16(a, b); }
+inline VI vAbs(VI a) { return _mm_abs_epi16(a); }
+inline VI vAndNot(VI a, VI b) { return _mm_andnot_si128(a, b); }
+inline VI vMulHi(VI a, VI b) { return _mm_mulhi_epu16(a, b); }
+inline VI vShiftLeft(VI a, int n) { return _mm_slli_epi16(a, n); }
+inline VI vShiftRight(VI a, int n) { return _mm_srli_epi16(a, n); }
+inline VI vShiftRightSigned(VI a, int n) { return _mm_srai_epi16(a, n); }
+inline VI vLess(VI a, VI b) { return _mm_cmplt_epi16(a, b); }
+inline VI vBlend(VI mask, VI a, VI b) { return _mm_blendv_epi8(b, a, mask); }
+
+/// Load 8 bytes and extend to 16-bit lanes.
+inline VI vLoadU8(const uint8_t* p)
+{
+    return _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)p));
+}
+
+/// Store 8 lanes as bytes with saturation.
+inline void vStoreU8(uint8_t* p, VI a)
+{
+    _mm_storel_epi64((__m128i*)p, _mm_packus_epi16(a, a));
+}
+
+/// Load and store lanes as 16-bit values.
+inline VI vLoadU16(const uint16_t* p) { return _mm_loadu_si128((const __m128i*)p); }
+inline void vStoreU16(uint16_t* p, VI a) { _mm_storeu_si128((__m128i*)p, a); }
+
+
+/// 4 lanes of 32-bit integers and floats.
+typedef __m128i VW;
+typedef __m128 VF;
+const int VF_LANES = 4;
+
+inline VW vSetW(int value) { return _mm_set1_epi32(value); }
+inline VW vAddW(VW a, VW b) { return _mm_add_epi32(a, b); }
+inline VW vMulW(VW a, VW b) { return _mm_mullo_epi32(a, b); }
+inline VW vShiftRightW(VW a, int n) { return _mm_srli_epi32(a, n); }
+inline VW vShiftRightSignedW(VW a, int n) { return _mm_srai_epi32(a, n); }
+inline VW vAndW(VW a, VW b) { return _mm_and_si128(a, b); }
+inline VW vLoadW(const int* p) { return _mm_loadu_si128((const __m128i*)p); }
+inline VF vToFloat(VW a) { return _mm_cvtepi32_ps(a); }
+inline VF vSetF(float value) { return _mm_set1_ps(value); }
+inline VF vAddF(VF a, VF b) { return _mm_add_ps(a, b); }
+inline VF vMulF(VF a, VF b) { return _mm_mul_ps(a, b); }
+inline void vStoreF(float* p, VF a) { _mm_storeu_ps(p, a); }
+inline VW vTruncW(VF a) { return _mm_cvttps_epi32(a); }
+
+/// Store 4 lanes as bytes with saturation.
+inline void vStoreU8W(uint8_t* p, VW a)
+{
+    int value = _mm_cvtsi128_si32(_mm_packus_epi16(_mm_packs_epi32(a, a), a));
+    memcpy(p, &value, 4);
+}
+
+/// Load 4 16-bit values and extend to 32-bit lanes.
+inline VW vLoadU16W(const uint16_t* p)
+{
+    return _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i*)p));
+}
+
+/// Load 4 bytes and extend to 32-bit lanes.
+inline VW vLoadU8W(const uint8_t* p)
+{
+    int value;
+    memcpy(&value, p, 4);
+    return _mm_cvtepu8_epi32(_mm_cvtsi32_si128(value));
+}
+
+/// Store 4 lanes as 16-bit values with saturation.
+inline void vStoreU16W(uint16_t* p, VW a)
+{
+    _mm_storel_epi64((__m128i*)p, _mm_packus_epi32(a, a));
+}
+
+/// Gather 4 pairs of bytes (src[index], src[index + 1]) to low 16 bits of
+/// lanes (SSE4.1 has no gather instruction).
+inline VW vGatherU16W(const uint8_t* src, const int* index)
+{
+    uint16_t pairs[4];
+    for (int i = 0; i < 4; ++i)
+        memcpy(&pairs[i], &src[index[i]], 2);
+    return _mm_setr_epi32(pairs[0], pairs[1], pairs[2], pairs[3]);
+}
+
+/// Store 4 lanes as half precision floats (F16C is not part of SSE4.1).
+inline void vStoreHalf(uint16_t* p, VF a)
+{
+    float values[4];
+    _mm_storeu_ps(values, a);
+    for (int i = 0; i < 4; ++i)
+        p[i] = cr::video::kernels::floatToHalf(values[i]);
+}
+
+
+/// 16 bytes.
+typedef __m128i VB;
+const int VB_LANES = 16;
+
+inline VB vLoadB(const uint8_t* p) { return _mm_loadu_si128((const __m128i*)p); }
+inline void vStoreB(uint8_t* p, VB a) { _mm_storeu_si128((__m128i*)p, a); }
+inline void vStreamB(uint8_t* p, VB a) { _mm_stream_si128((__m128i*)p, a); }
+inline void vStreamFence() { _mm_sfence(); }
+inline VB vZeroB() { return _mm_setzero_si128(); }
+inline VB vMinU8(VB a, VB b) { return _mm_min_epu8(a, b); }
+inline VB vMaxU8(VB a, VB b) { return _mm_max_epu8(a, b); }
+inline VB vAvgU8(VB a, VB b) { return _mm_avg_epu8(a, b); }
+inline VB vMinU16(VB a, VB b) { return _mm_min_epu16(a, b); }
+inline VB vMaxU16(VB a, VB b) { return _mm_max_epu16(a, b); }
+inline VB vAdd64(VB a, VB b) { return _mm_add_epi64(a, b); }
+inline VB vLowBytes(VB a) { return _mm_and_si128(a, _mm_set1_epi16(0x00FF)); }
+inline VB vHighBytes(VB a) { return _mm_srli_epi16(a, 8); }
+
+/// Sums of 8 bytes groups in 64-bit lanes.
+inline VB vSumU8(VB a) { return _mm_sad_epu8(a, _mm_setzero_si128()); }
+
+/// Load 16 bytes and store them in reverse order.
+inline void vReverseU8(const uint8_t* src, uint8_t* dst)
+{
+    const __m128i order = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8,
+                                        7, 6, 5, 4, 3, 2, 1, 0);
+    __m128i a = _mm_loadu_si128((const __m128i*)src);
+    _mm_storeu_si128((__m128i*)dst, _mm_shuffle_epi8(a, order));
+}
+
+/// Load 8 16-bit values and store them in reverse order.
+inline void vReverseU16(const uint8_t* src, uint8_t* dst)
+{
+    const __m128i order = _mm_setr_epi8(14, 15, 12, 13, 10, 11, 8, 9,
+                                        6, 7, 4, 5, 2, 3, 0, 1);
+    __m128i a = _mm_loadu_si128((const __m128i*)src);
+    _mm_storeu_si128((__m128i*)dst, _mm_shuffle_epi8(a, order));
+}
+}
+
+
+
+#define FRAME_KERNELS_INIT initSse41
+#include "FrameKernelsSimd.h"
+#endif
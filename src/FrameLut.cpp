@@ -0,0 +1,403 @@
+#include <cmath>
+#include <mutex>
+#include "FrameLut.h"
+#include "FrameCompute.h"
+#include "FrameCopy.h"
+#include "FrameKernels.h"
+#include "FramePlane.h"
+
+
+
+// Link namespaces.
+using namespace std;
+using namespace cr::video;
+using namespace cr::video::kernels;
+
+
+
+namespace
+{
+
+/// Minimum number of rows processed by one task.
+const int g_grain = 64;
+
+
+
+/// Samples of plane to process.
+struct PlaneSamples
+{
+    /// Plane.
+    FramePlane plane;
+    /// Sample size (bytes).
+    int sampleSize{1};
+    /// Number of samples in row.
+    int count{0};
+    /// Offset of first sample in row (bytes).
+    int offset{0};
+    /// Distance between samples (samples). 1 - contiguous samples.
+    int step{1};
+};
+
+
+
+/// Accumulated statistics.
+struct Accumulator
+{
+    /// Histogram or empty.
+    vector<uint32_t> histogram;
+    /// Minimum value.
+    int min{INT32_MAX};
+    /// Maximum value.
+    int max{-1};
+    /// Sum of values.
+    uint64_t sum{0};
+};
+
+
+
+/// Get samples of plane.
+bool getSamples(const Frame& frame, int plane, int channel, PlaneSamples& samples)
+{
+    FramePlane planes[3];
+    int bits = getSampleBits(frame.fourcc);
+    int count = getPlanes(frame, planes);
+    if (bits == 0 || plane < 0 || plane >= count)
+        return false;
+
+    samples.plane = planes[plane];
+    samples.sampleSize = bits / 8;
+    int perElement = samples.plane.elementSize / samples.sampleSize;
+    if (channel < -1 || channel >= perElement)
+        return false;
+
+    if (channel < 0)
+    {
+        samples.count = samples.plane.width * perElement;
+        samples.offset = 0;
+        samples.step = 1;
+    }
+    else
+    {
+        samples.count = samples.plane.width;
+        samples.offset = channel * samples.sampleSize;
+        samples.step = perElement;
+    }
+    return true;
+}
+
+
+
+/// Add histogram of 8 bit row. Four histograms are used in turn to avoid
+/// dependency between increments of the same bin.
+void histogramRow8(const uint8_t* src, int count, int step, uint32_t* histograms)
+{
+    uint32_t* h0 = histograms;
+    uint32_t* h1 = histograms + 256;
+    uint32_t* h2 = histograms + 512;
+    uint32_t* h3 = histograms + 768;
+    int i = 0;
+
+    // Contiguous samples are loaded by 8 bytes.
+    if (step == 1)
+    {
+        for (; i + 8 <= count; i += 8)
+        {
+            uint64_t v;
+            memcpy(&v, &src[i], 8);
+            ++h0[v & 0xFF];
+            ++h1[(v >> 8) & 0xFF];
+            ++h2[(v >> 16) & 0xFF];
+            ++h3[(v >> 24) & 0xFF];
+            ++h0[(v >> 32) & 0xFF];
+            ++h1[(v >> 40) & 0xFF];
+            ++h2[(v >> 48) & 0xFF];
+            ++h3[v >> 56];
+        }
+    }
+
+    for (; i + 4 <= count; i += 4)
+    {
+        ++h0[src[i * step]];
+        ++h1[src[(i + 1) * step]];
+        ++h2[src[(i + 2) * step]];
+        ++h3[src[(i + 3) * step]];
+    }
+    for (; i < count; ++i)
+        ++h0[src[i * step]];
+}
+
+
+
+/// Add histogram of 16 bit row.
+void histogramRow16(const uint16_t* src, int count, int step, uint32_t* histogram)
+{
+    for (int i = 0; i < count; ++i)
+        ++histogram[src[i * step]];
+}
+
+
+
+/// Prepare accumulator of task. 8 bit histogram consists of four partial
+/// histograms.
+void initAccumulator(const PlaneSamples& samples, bool withHistogram, Accumulator& acc)
+{
+    if (withHistogram)
+        acc.histogram.assign(samples.sampleSize == 2 ? 65536 : 4 * 256, 0);
+}
+
+
+
+/// Accumulate statistics of rows [begin, end).
+void accumulateRows(const PlaneSamples& samples, int begin, int end, Accumulator& acc)
+{
+    const KernelTable& table = getTable();
+    const FramePlane& plane = samples.plane;
+    const bool is16bit = samples.sampleSize == 2;
+    const bool withHistogram = !acc.histogram.empty();
+
+    for (int y = begin; y < end; ++y)
+    {
+        const uint8_t* row = plane.data + (size_t)y * plane.stride + samples.offset;
+        if (withHistogram && is16bit)
+            histogramRow16((const uint16_t*)row, samples.count, samples.step, acc.histogram.data());
+        else if (withHistogram)
+            histogramRow8(row, samples.count, samples.step, acc.histogram.data());
+        else if (samples.step == 1 && is16bit)
+            table.rangeRow16((const uint16_t*)row, samples.count, acc.min, acc.max, acc.sum);
+        else if (samples.step == 1)
+            table.rangeRow8(row, samples.count, acc.min, acc.max, acc.sum);
+        else
+        {
+            for (int i = 0; i < samples.count; ++i)
+            {
+                int value = is16bit ? ((const uint16_t*)row)[i * samples.step] :
+                                      row[i * samples.step];
+                acc.min = value < acc.min ? value : acc.min;
+                acc.max = value > acc.max ? value : acc.max;
+                acc.sum += value;
+            }
+        }
+    }
+}
+
+
+
+/// Merge statistics of task to total statistics.
+void merge(const Accumulator& acc, Accumulator& total)
+{
+    if (!acc.histogram.empty())
+    {
+        // Partial 8 bit histograms are merged to one.
+        size_t bins = acc.histogram.size() == 4 * 256 ? 256 : acc.histogram.size();
+        if (total.histogram.empty())
+            total.histogram.assign(bins, 0);
+        for (size_t i = 0; i < acc.histogram.size(); ++i)
+            total.histogram[i % bins] += acc.histogram[i];
+    }
+    total.min = acc.min < total.min ? acc.min : total.min;
+    total.max = acc.max > total.max ? acc.max : total.max;
+    total.sum += acc.sum;
+}
+
+
+
+/// Fill output statistics.
+void finish(const PlaneSamples& samples, Accumulator& total, PlaneStatistics& stats)
+{
+    // Min, max and sum from histogram.
+    if (!total.histogram.empty())
+    {
+        for (int i = 0; i < (int)total.histogram.size(); ++i)
+        {
+            if (total.histogram[i] == 0)
+                continue;
+            total.min = i < total.min ? i : total.min;
+            total.max = i;
+            total.sum += (uint64_t)total.histogram[i] * i;
+        }
+    }
+
+    stats.histogram.swap(total.histogram);
+    stats.count = (int64_t)samples.count * samples.plane.height;
+    stats.min = total.min;
+    stats.max = total.max;
+    stats.mean = (double)total.sum / stats.count;
+}
+
+
+
+/// Apply lookup table to plane samples.
+template <typename T>
+void applyTable(const PlaneSamples& samples, const T* lut)
+{
+    const FramePlane& plane = samples.plane;
+    parallelFor(plane.height, g_grain, [&](int begin, int end)
+    {
+        for (int y = begin; y < end; ++y)
+        {
+            T* row = (T*)(plane.data + (size_t)y * plane.stride + samples.offset);
+            const int step = samples.step;
+            int i = 0;
+            for (; i + 4 <= samples.count; i += 4)
+            {
+                T v0 = lut[row[i * step]];
+                T v1 = lut[row[(i + 1) * step]];
+                T v2 = lut[row[(i + 2) * step]];
+                T v3 = lut[row[(i + 3) * step]];
+                row[i * step] = v0;
+                row[(i + 1) * step] = v1;
+                row[(i + 2) * step] = v2;
+                row[(i + 3) * step] = v3;
+            }
+            for (; i < samples.count; ++i)
+                row[i * step] = lut[row[i * step]];
+        }
+    });
+}
+}
+
+
+
+int cr::video::getSampleBits(Fourcc fourcc)
+{
+    switch (fourcc)
+    {
+    case Fourcc::BGGR16:
+    case Fourcc::GBRG16:
+    case Fourcc::GRBG16:
+    case Fourcc::RGGB16:
+        return 16;
+    default:
+        return getDataSize(fourcc, 2, 2) > 0 ? 8 : 0;
+    }
+}
+
+
+
+bool cr::video::getPlaneStatistics(const Frame& frame, int plane,
+                                   PlaneStatistics& stats, int channel,
+                                   bool histogram)
+{
+    PlaneSamples samples;
+    if (!getSamples(frame, plane, channel, samples))
+        return false;
+
+    Accumulator total;
+    mutex totalMutex;
+    parallelFor(samples.plane.height, g_grain, [&](int begin, int end)
+    {
+        Accumulator acc;
+        initAccumulator(samples, histogram, acc);
+        accumulateRows(samples, begin, end, acc);
+        lock_guard<mutex> lock(totalMutex);
+        merge(acc, total);
+    });
+    finish(samples, total, stats);
+
+    return true;
+}
+
+
+
+bool cr::video::copyWithStatistics(const Frame& src, Frame& dst, int plane,
+                                   PlaneStatistics& stats, int channel)
+{
+    // Same frame.
+    if (&src == &dst)
+        return getPlaneStatistics(src, plane, stats, channel);
+
+    // Check source frame and prepare output frame.
+    PlaneSamples samples;
+    if (!getSamples(src, plane, channel, samples) ||
+        !prepareFrame(dst, src.width, src.height, src.fourcc))
+        return false;
+    dst.frameId = src.frameId;
+    dst.sourceId = src.sourceId;
+
+    // Copy other planes.
+    const FramePlane& p = samples.plane;
+    const size_t planeBegin = p.data - src.data;
+    const size_t planeEnd = planeBegin + (size_t)p.stride * p.height;
+    copyData(dst.data, src.data, planeBegin);
+    copyData(dst.data + planeEnd, src.data + planeEnd, (size_t)dst.size - planeEnd);
+
+    // Copy plane rows and accumulate statistics of copied rows.
+    Accumulator total;
+    mutex totalMutex;
+    parallelFor(p.height, g_grain, [&](int begin, int end)
+    {
+        Accumulator acc;
+        initAccumulator(samples, true, acc);
+        for (int y = begin; y < end; ++y)
+        {
+            size_t offset = planeBegin + (size_t)y * p.stride;
+            memcpy(dst.data + offset, src.data + offset, p.stride);
+            accumulateRows(samples, y, y + 1, acc);
+        }
+        lock_guard<mutex> lock(totalMutex);
+        merge(acc, total);
+    });
+    finish(samples, total, stats);
+
+    return true;
+}
+
+
+
+bool cr::video::applyLut(Frame& frame, int plane, const uint8_t lut[256], int channel)
+{
+    PlaneSamples samples;
+    if (lut == nullptr || !getSamples(frame, plane, channel, samples) ||
+        samples.sampleSize != 1)
+        return false;
+    frame.invalidateCache();
+    applyTable(samples, lut);
+    return true;
+}
+
+
+
+bool cr::video::applyLut(Frame& frame, int plane, const uint16_t lut[65536], int channel)
+{
+    PlaneSamples samples;
+    if (lut == nullptr || !getSamples(frame, plane, channel, samples) ||
+        samples.sampleSize != 2)
+        return false;
+    frame.invalidateCache();
+    applyTable(samples, lut);
+    return true;
+}
+
+
+
+bool cr::video::applyGainOffset(Frame& frame, int plane, float gain, float offset,
+                                int channel)
+{
+    PlaneSamples samples;
+    if (!getSamples(frame, plane, channel, samples))
+        return false;
+    frame.invalidateCache();
+
+    // Build lookup table.
+    const int maxValue = samples.sampleSize == 2 ? 65535 : 255;
+    vector<uint16_t> lut(maxValue + 1);
+    for (int i = 0; i <= maxValue; ++i)
+    {
+        double value = floor((double)i * gain + offset + 0.5);
+        lut[i] = (uint16_t)(value < 0.0 ? 0 : (value > maxValue ? maxValue : value));
+    }
+
+    if (samples.sampleSize == 2)
+    {
+        applyTable(samples, lut.data());
+    }
+    else
+    {
+        uint8_t lut8[256];
+        for (int i = 0; i < 256; ++i)
+            lut8[i] = (uint8_t)lut[i];
+        applyTable(samples, lut8);
+    }
+
+    return true;
+}
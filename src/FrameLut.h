@@ -0,0 +1,106 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Frame.h"
+
+
+
+namespace cr
+{
+namespace video
+{
+
+/**
+ * @brief Statistics of frame plane.
+ */
+struct PlaneStatistics
+{
+    /// Histogram: 256 bins for 8 bit samples or 65536 bins for 16 bit
+    /// samples. Empty if histogram is not requested.
+    std::vector<uint32_t> histogram;
+    /// Number of samples.
+    int64_t count{0};
+    /// Minimum sample value.
+    int min{0};
+    /// Maximum sample value.
+    int max{0};
+    /// Mean sample value.
+    double mean{0.0};
+};
+
+
+
+/**
+ * @brief Get bits per sample of pixel format.
+ * @param fourcc Pixel format.
+ * @return 16 for 16 bit Bayer formats, 8 for other raw formats or 0 if
+ * pixel format is not supported (compressed formats).
+ */
+int getSampleBits(Fourcc fourcc);
+
+/**
+ * @brief Get statistics of frame plane. Plane is processed by library
+ * thread pool (see FrameCompute.h), min, max and sum of samples without
+ * histogram are calculated by SIMD kernels.
+ * @param frame Frame. Planes are described in FramePlane.h.
+ * @param plane Plane index.
+ * @param stats Output statistics.
+ * @param channel Sample index within plane element (for example 0 - luma
+ * of YUYV, 1 - V of NV21 chroma plane or 2 - blue of RGB24) or -1 for all
+ * samples of plane.
+ * @param histogram Calculate histogram.
+ * @return TRUE if statistics calculated or FALSE if not.
+ */
+bool getPlaneStatistics(const Frame& frame, int plane, PlaneStatistics& stats,
+                        int channel = -1, bool histogram = true);
+
+/**
+ * @brief Copy frame and get statistics of its plane in one memory pass:
+ * histogram of each row is calculated while row is in cache after copy.
+ * @param src Source frame. Planes are described in FramePlane.h.
+ * @param dst Output frame. Memory will be reallocated if output frame has
+ * another size or pixel format. Function copies frame ID and source ID.
+ * @param plane Plane index.
+ * @param stats Output statistics (with histogram).
+ * @param channel Sample index within plane element or -1 for all samples.
+ * @return TRUE if the frame copied or FALSE if not.
+ */
+bool copyWithStatistics(const Frame& src, Frame& dst, int plane,
+                        PlaneStatistics& stats, int channel = -1);
+
+/**
+ * @brief Apply lookup table to samples of 8 bit frame plane in place.
+ * @param frame Frame. Planes are described in FramePlane.h.
+ * @param plane Plane index.
+ * @param lut Lookup table (256 values).
+ * @param channel Sample index within plane element or -1 for all samples.
+ * @return TRUE if lookup table applied or FALSE if not.
+ */
+bool applyLut(Frame& frame, int plane, const uint8_t lut[256], int channel = -1);
+
+/**
+ * @brief Apply lookup table to samples of 16 bit frame plane (16 bit Bayer
+ * formats) in place.
+ * @param frame Frame. Planes are described in FramePlane.h.
+ * @param plane Plane index.
+ * @param lut Lookup table (65536 values).
+ * @param channel Sample index within plane element or -1 for all samples.
+ * @return TRUE if lookup table applied or FALSE if not.
+ */
+bool applyLut(Frame& frame, int plane, const uint16_t lut[65536], int channel = -1);
+
+/**
+ * @brief Apply gain and offset to samples of frame plane in place:
+ * sample = sample * gain + offset, rounded and saturated to sample range.
+ * Function builds lookup table and applies it.
+ * @param frame Frame. Planes are described in FramePlane.h.
+ * @param plane Plane index.
+ * @param gain Gain.
+ * @param offset Offset.
+ * @param channel Sample index within plane element or -1 for all samples.
+ * @return TRUE if gain and offset applied or FALSE if not.
+ */
+bool applyGainOffset(Frame& frame, int plane, float gain, float offset,
+                     int channel = -1);
+}
+}
@@ -0,0 +1,429 @@
+#include <vector>
+#include "FrameMosaic.h"
+#include "FrameCompute.h"
+#include "FrameKernels.h"
+#include "FramePlane.h"
+
+
+
+// Link namespaces.
+using namespace std;
+using namespace cr::video;
+using namespace cr::video::kernels;
+
+
+
+namespace
+{
+
+/// Number of rows in band processed by one task (must be even).
+const int g_bandRows = 32;
+
+
+
+/// Position of color components in output frame.
+struct Layout
+{
+    /// Components: Y, U, V for YUV formats and R, G, B for RGB formats.
+    uint8_t* planes[3]{nullptr, nullptr, nullptr};
+    ptrdiff_t strides[3]{0, 0, 0};
+    int steps[3]{1, 1, 1};
+    /// Number of components (1 for GRAY).
+    int count{3};
+    /// Subsampling of second and third components.
+    int subX{1};
+    int subY{1};
+    /// Output in YUV color space.
+    bool isYuv{true};
+};
+
+
+
+/// Scaling job for one cell.
+struct CellJob
+{
+    /// Source frame (nullptr for black cell).
+    const Frame* frame{nullptr};
+    /// Cell.
+    MosaicCell cell;
+    /// Source pixel index and weight (8 bit) for every cell column.
+    vector<int> xIndex;
+    vector<int> xWeight;
+};
+
+
+
+/// Get layout of output frame.
+bool getOutputLayout(const Frame& frame, Layout& layout)
+{
+    FramePlane planes[3];
+    int planesCount = getPlanes(frame, planes);
+    if (planesCount == 0 || frame.size < getDataSize(frame.fourcc, frame.width, frame.height))
+        return false;
+    const bool isEven = frame.width % 2 == 0 && frame.height % 2 == 0;
+    switch (frame.fourcc)
+    {
+    case Fourcc::RGB24:
+    case Fourcc::BGR24:
+    {
+        int rPos = frame.fourcc == Fourcc::RGB24 ? 0 : 2;
+        for (int c = 0; c < 3; ++c)
+        {
+            layout.planes[c] = planes[0].data + (c == 1 ? 1 : (c == 0 ? rPos : 2 - rPos));
+            layout.strides[c] = planes[0].stride;
+            layout.steps[c] = 3;
+        }
+        layout.isYuv = false;
+        return true;
+    }
+    case Fourcc::GRAY:
+        layout.planes[0] = planes[0].data;
+        layout.strides[0] = planes[0].stride;
+        layout.count = 1;
+        return true;
+    case Fourcc::NV12:
+    case Fourcc::NV21:
+    {
+        int uPos = frame.fourcc == Fourcc::NV12 ? 0 : 1;
+        layout.planes[0] = planes[0].data;
+        layout.planes[1] = planes[1].data + uPos;
+        layout.planes[2] = planes[1].data + 1 - uPos;
+        layout.strides[0] = planes[0].stride;
+        layout.strides[1] = layout.strides[2] = planes[1].stride;
+        layout.steps[1] = layout.steps[2] = 2;
+        layout.subX = layout.subY = 2;
+        return isEven;
+    }
+    case Fourcc::YU12:
+    case Fourcc::YV12:
+    {
+        int uPlane = frame.fourcc == Fourcc::YU12 ? 1 : 2;
+        layout.planes[0] = planes[0].data;
+        layout.planes[1] = planes[uPlane].data;
+        layout.planes[2] = planes[3 - uPlane].data;
+        layout.strides[0] = planes[0].stride;
+        layout.strides[1] = layout.strides[2] = planes[1].stride;
+        layout.subX = layout.subY = 2;
+        return isEven;
+    }
+    case Fourcc::YUYV:
+    case Fourcc::UYVY:
+    {
+        int yPos = frame.fourcc == Fourcc::YUYV ? 0 : 1;
+        layout.planes[0] = planes[0].data + yPos;
+        layout.planes[1] = planes[0].data + 1 - yPos;
+        layout.planes[2] = layout.planes[1] + 2;
+        layout.strides[0] = layout.strides[1] = layout.strides[2] = planes[0].stride;
+        layout.steps[0] = 2;
+        layout.steps[1] = layout.steps[2] = 4;
+        layout.subX = 2;
+        return frame.width % 2 == 0;
+    }
+    default:
+        return false;
+    }
+}
+
+
+
+/// Source position (8.8 fixed point) of destination pixel center.
+inline int sourcePosition(int dst, int srcSize, int dstSize)
+{
+    int64_t pos = (int64_t)(2 * dst + 1) * srcSize * 128 / dstSize - 128;
+    if (pos < 0)
+        pos = 0;
+    if (pos > (int64_t)(srcSize - 1) * 256)
+        pos = (int64_t)(srcSize - 1) * 256;
+    return (int)pos;
+}
+
+
+
+/// Check source frame.
+bool isValidSource(const Frame& frame)
+{
+    return frame.data != nullptr && isRgbReadable(frame.fourcc) &&
+           frame.width > 0 && frame.height > 0 &&
+           frame.size >= getDataSize(frame.fourcc, frame.width, frame.height);
+}
+
+
+
+/// Scale and convert cell rows [begin, end). Range is aligned to vertical
+/// subsampling of output frame.
+void processRows(const CellJob& job, const Layout& layout, int begin, int end)
+{
+    const KernelTable& table = getTable();
+    const MosaicCell& cell = job.cell;
+    const int w = cell.width;
+    const int srcWidth = job.frame != nullptr ? job.frame->width : 0;
+
+    // Buffers: two source rows, vertically interpolated row (+1 pixel for
+    // horizontal interpolation) and output rows (3 components each).
+    const int srcStride = srcWidth + 1;
+    vector<uint8_t> src(2 * 3 * srcStride, 0);
+    vector<uint16_t> blended(3 * srcStride, 0);
+    vector<uint8_t> out(layout.subY * 3 * w);
+    int srcY[2] = {-1, -1};
+
+    // Function to read source row.
+    auto getSource = [&](int y) -> const uint8_t*
+    {
+        uint8_t* dst = &src[(y & 1) * 3 * srcStride];
+        if (srcY[y & 1] == y)
+            return dst;
+        if (layout.isYuv)
+            readYuvRow(*job.frame, y, 0, srcWidth, dst, dst + srcStride, dst + 2 * srcStride);
+        else
+            readRgbRow(*job.frame, y, 0, srcWidth, dst, dst + srcStride, dst + 2 * srcStride);
+        srcY[y & 1] = y;
+        return dst;
+    };
+
+    for (int y = begin; y < end; y += layout.subY)
+    {
+        // Components of output rows: vertical interpolation of source rows
+        // and then horizontal interpolation (8.8 fixed point).
+        for (int k = 0; k < layout.subY; ++k)
+        {
+            uint8_t* o = &out[k * 3 * w];
+            if (job.frame == nullptr)
+            {
+                memset(o, layout.isYuv ? 16 : 0, w);
+                memset(o + w, layout.isYuv ? 128 : 0, 2 * w);
+                continue;
+            }
+
+            int pos = sourcePosition(y + k, job.frame->height, cell.height);
+            int y0 = pos >> 8;
+            int weight = pos & 255;
+            int y1 = y0 + 1 < job.frame->height ? y0 + 1 : y0;
+            const uint8_t* top = getSource(y0);
+            const uint8_t* bottom = getSource(y1);
+            table.lerpRow(top, bottom, weight, 3 * srcStride, blended.data());
+            for (int c = 0; c < 3; ++c)
+            {
+                const uint16_t* b = &blended[c * srcStride];
+                uint8_t* d = &o[c * w];
+                for (int x = 0; x < w; ++x)
+                {
+                    int i = job.xIndex[x];
+                    int wx = job.xWeight[x];
+                    d[x] = (uint8_t)((b[i] * (256 - wx) + b[i + 1] * wx + 32768) >> 16);
+                }
+            }
+        }
+
+        // Write components.
+        for (int c = 0; c < layout.count; ++c)
+        {
+            const int subX = c == 0 ? 1 : layout.subX;
+            const int subY = c == 0 ? 1 : layout.subY;
+            const int step = layout.steps[c];
+            for (int k = 0; k < layout.subY; k += subY)
+            {
+                const uint8_t* o = &out[k * 3 * w + c * w];
+                uint8_t* d = layout.planes[c] +
+                             (size_t)((cell.y + y + k) / subY) * layout.strides[c] +
+                             (size_t)(cell.x / subX) * step;
+                if (subX == 1 && subY == 1)
+                {
+                    if (step == 1)
+                    {
+                        memcpy(d, o, w);
+                    }
+                    else
+                    {
+                        for (int x = 0; x < w; ++x)
+                            d[x * step] = o[x];
+                    }
+                    continue;
+                }
+
+                // Average of subsampled block.
+                const int n = subX * subY;
+                for (int x = 0; x < w; x += subX)
+                {
+                    int sum = 0;
+                    for (int j = 0; j < subY; ++j)
+                        for (int i = 0; i < subX; ++i)
+                            sum += o[j * 3 * w + x + i];
+                    d[(x / subX) * step] = (uint8_t)((sum + n / 2) / n);
+                }
+            }
+        }
+    }
+}
+}
+
+
+
+bool FrameMosaic::setLayout(const vector<MosaicCell>& cells)
+{
+    // Check cells.
+    for (size_t i = 0; i < cells.size(); ++i)
+    {
+        const MosaicCell& a = cells[i];
+        if (a.x < 0 || a.y < 0 || a.width <= 0 || a.height <= 0)
+            return false;
+        for (size_t j = 0; j < i; ++j)
+        {
+            const MosaicCell& b = cells[j];
+            if (a.x < (int64_t)b.x + b.width && b.x < (int64_t)a.x + a.width &&
+                a.y < (int64_t)b.y + b.height && b.y < (int64_t)a.y + a.height)
+                return false;
+        }
+    }
+
+    m_cells = cells;
+    m_states.assign(cells.size(), CellState());
+    return true;
+}
+
+
+
+bool FrameMosaic::setGrid(int columns, int rows, int width, int height)
+{
+    if (columns <= 0 || rows <= 0)
+        return false;
+    int cellWidth = (width / columns) & ~1;
+    int cellHeight = (height / rows) & ~1;
+    if (cellWidth <= 0 || cellHeight <= 0)
+        return false;
+
+    vector<MosaicCell> cells(columns * rows);
+    for (int i = 0; i < columns * rows; ++i)
+    {
+        cells[i].x = (i % columns) * cellWidth;
+        cells[i].y = (i / columns) * cellHeight;
+        cells[i].width = cellWidth;
+        cells[i].height = cellHeight;
+    }
+
+    return setLayout(cells);
+}
+
+
+
+const vector<MosaicCell>& FrameMosaic::getLayout() const
+{
+    return m_cells;
+}
+
+
+
+void FrameMosaic::setSkipUnchanged(bool skip)
+{
+    m_skipUnchanged = skip;
+}
+
+
+
+void FrameMosaic::invalidate()
+{
+    m_states.assign(m_cells.size(), CellState());
+}
+
+
+
+bool FrameMosaic::compose(const Frame* const frames[], int count, Frame& dst)
+{
+    // Check output frame and cells.
+    Layout layout;
+    if ((frames == nullptr && count > 0) || count < 0 || !getOutputLayout(dst, layout))
+        return false;
+    const int alignX = layout.isYuv ? layout.subX : 1;
+    const int alignY = layout.isYuv ? layout.subY : 1;
+    for (const MosaicCell& cell : m_cells)
+    {
+        if ((int64_t)cell.x + cell.width > dst.width ||
+            (int64_t)cell.y + cell.height > dst.height ||
+            cell.x % alignX != 0 || cell.width % alignX != 0 ||
+            cell.y % alignY != 0 || cell.height % alignY != 0)
+            return false;
+    }
+
+    // Check source frames.
+    for (int i = 0; i < count && i < (int)m_cells.size(); ++i)
+        if (frames[i] != nullptr && !isValidSource(*frames[i]))
+            return false;
+    dst.invalidateCache();
+
+    // Redraw all cells if output frame is changed.
+    if (dst.data != m_dstData || dst.width != m_dstWidth ||
+        dst.height != m_dstHeight || dst.fourcc != m_dstFourcc)
+    {
+        invalidate();
+        m_dstData = dst.data;
+        m_dstWidth = dst.width;
+        m_dstHeight = dst.height;
+        m_dstFourcc = dst.fourcc;
+    }
+
+    // Prepare jobs for changed cells.
+    vector<CellJob> jobs;
+    for (size_t i = 0; i < m_cells.size(); ++i)
+    {
+        const Frame* frame = (int)i < count ? frames[i] : nullptr;
+        CellState& state = m_states[i];
+        if (m_skipUnchanged && state.isDrawn &&
+            (frame == nullptr ? state.isEmpty :
+             (!state.isEmpty && state.frameId == frame->frameId &&
+              state.width == frame->width && state.height == frame->height &&
+              state.fourcc == frame->fourcc)))
+            continue;
+
+        state.isDrawn = true;
+        state.isEmpty = frame == nullptr;
+        if (frame != nullptr)
+        {
+            state.frameId = frame->frameId;
+            state.width = frame->width;
+            state.height = frame->height;
+            state.fourcc = frame->fourcc;
+        }
+
+        CellJob job;
+        job.frame = frame;
+        job.cell = m_cells[i];
+        if (frame != nullptr)
+        {
+            job.xIndex.resize(job.cell.width);
+            job.xWeight.resize(job.cell.width);
+            for (int x = 0; x < job.cell.width; ++x)
+            {
+                int pos = sourcePosition(x, frame->width, job.cell.width);
+                job.xIndex[x] = pos >> 8;
+                job.xWeight[x] = pos & 255;
+            }
+        }
+        jobs.push_back(job);
+    }
+    m_updatedCount = (int)jobs.size();
+
+    // Bands of rows of all cells.
+    vector<pair<int, int>> bands;
+    for (int i = 0; i < (int)jobs.size(); ++i)
+        for (int y = 0; y < jobs[i].cell.height; y += g_bandRows)
+            bands.push_back(make_pair(i, y));
+
+    parallelFor((int)bands.size(), 1, [&](int begin, int end)
+    {
+        for (int i = begin; i < end; ++i)
+        {
+            const CellJob& job = jobs[bands[i].first];
+            int y = bands[i].second;
+            int last = y + g_bandRows < job.cell.height ? y + g_bandRows : job.cell.height;
+            processRows(job, layout, y, last);
+        }
+    });
+
+    return true;
+}
+
+
+
+int FrameMosaic::getUpdatedCellsCount() const
+{
+    return m_updatedCount;
+}
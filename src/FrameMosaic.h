@@ -0,0 +1,131 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Frame.h"
+
+
+
+namespace cr
+{
+namespace video
+{
+
+/**
+ * @brief Mosaic cell: area of output frame for one source frame.
+ */
+struct MosaicCell
+{
+    /// Top-left corner horizontal position (pixels).
+    int x{0};
+    /// Top-left corner vertical position (pixels).
+    int y{0};
+    /// Cell width (pixels).
+    int width{0};
+    /// Cell height (pixels).
+    int height{0};
+};
+
+
+
+/**
+ * @brief Mosaic compositor. Tiles many source frames of different size and
+ * pixel format into one output frame. Each source frame is scaled
+ * (bilinear) and converted directly into its cell in one pass, cells are
+ * processed in parallel by library thread pool (see FrameCompute.h).
+ * Cells whose source frame ID is not changed since last compose are not
+ * redrawn.
+ */
+class FrameMosaic
+{
+public:
+
+    /**
+     * @brief Set layout. Cells must not overlap.
+     * @param cells Cells. Cell with index i is used for source frame i.
+     * @return TRUE if the layout is set or FALSE if cells are not valid.
+     */
+    bool setLayout(const std::vector<MosaicCell>& cells);
+
+    /**
+     * @brief Set grid layout: columns * rows cells of equal size (even
+     * width and height) row by row.
+     * @param columns Number of columns.
+     * @param rows Number of rows.
+     * @param width Output frame width.
+     * @param height Output frame height.
+     * @return TRUE if the layout is set or FALSE if parameters not valid.
+     */
+    bool setGrid(int columns, int rows, int width, int height);
+
+    /**
+     * @brief Get layout.
+     * @return Cells.
+     */
+    const std::vector<MosaicCell>& getLayout() const;
+
+    /**
+     * @brief Enable or disable skipping of cells with unchanged source
+     * frame (the same frame ID, size and pixel format). Enabled by default.
+     * @param skip TRUE to skip unchanged cells.
+     */
+    void setSkipUnchanged(bool skip);
+
+    /**
+     * @brief Force redraw of all cells on next compose.
+     */
+    void invalidate();
+
+    /**
+     * @brief Compose mosaic.
+     * @param frames Pointers to source frames. Supported pixel formats:
+     * RGB24, BGR24, YUV24, GRAY, YUYV, UYVY, NV12, NV21, YU12 and YV12.
+     * Cells of nullptr frames and cells without frame (index >= count) are
+     * filled by black color.
+     * @param count Number of frames.
+     * @param dst Output frame. Frame must be allocated. Supported pixel
+     * formats: RGB24, BGR24, GRAY, YUYV, UYVY, NV12, NV21, YU12 and YV12.
+     * Cells must be inside frame and have even position and size for
+     * formats with chroma subsampling.
+     * @return TRUE if mosaic is composed or FALSE if parameters are not
+     * valid. Function doesn't draw any cell if parameters are not valid.
+     */
+    bool compose(const Frame* const frames[], int count, Frame& dst);
+
+    /**
+     * @brief Get number of cells redrawn by last compose.
+     * @return Number of cells.
+     */
+    int getUpdatedCellsCount() const;
+
+private:
+
+    /// State of cell after last compose.
+    struct CellState
+    {
+        /// Cell is drawn.
+        bool isDrawn{false};
+        /// Cell is filled by black color (no source frame).
+        bool isEmpty{false};
+        /// Source frame parameters.
+        int frameId{0};
+        int width{0};
+        int height{0};
+        Fourcc fourcc{Fourcc::RGB24};
+    };
+
+    /// Cells.
+    std::vector<MosaicCell> m_cells;
+    /// Cells states.
+    std::vector<CellState> m_states;
+    /// Output frame of last compose.
+    uint8_t* m_dstData{nullptr};
+    int m_dstWidth{0};
+    int m_dstHeight{0};
+    Fourcc m_dstFourcc{Fourcc::RGB24};
+    /// Skip unchanged cells.
+    bool m_skipUnchanged{true};
+    /// Number of cells redrawn by last compose.
+    int m_updatedCount{0};
+};
+}
+}
@@ -0,0 +1,290 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "FrameNuma.h"
+#include "FrameKernels.h"
+#if defined(__linux__)
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+
+
+// Link namespaces.
+using namespace std;
+using namespace cr::video;
+
+
+
+namespace
+{
+
+#if defined(__linux__)
+/// Memory policy constants (linux/mempolicy.h).
+const int g_mpolBind = 2;
+const int g_mpolFNode = 1;
+const int g_mpolFAddr = 2;
+const unsigned g_mpolMfMove = 2;
+/// Maximum number of nodes in node mask.
+const int g_maxNodes = 1024;
+/// Maximum index (node or CPU) in sysfs lists.
+const long g_maxIndex = 65536;
+
+
+
+/// Read first line of sysfs file.
+bool readLine(const string& path, string& line)
+{
+    FILE* file = fopen(path.c_str(), "r");
+    if (file == nullptr)
+        return false;
+    char buffer[4096];
+    bool isRead = fgets(buffer, sizeof(buffer), file) != nullptr;
+    fclose(file);
+    if (isRead)
+        line = buffer;
+    return isRead;
+}
+
+
+
+/// Parse list of ranges ("0-3,8-11"). Function is called for each index.
+template <typename Func>
+void parseList(const string& list, Func func)
+{
+    const char* p = list.c_str();
+    while (*p != 0)
+    {
+        char* end = nullptr;
+        long first = strtol(p, &end, 10);
+        if (end == p)
+            return;
+        long last = first;
+        p = end;
+        if (*p == '-')
+        {
+            last = strtol(p + 1, &end, 10);
+            p = end;
+        }
+        for (long i = first; i <= last && i < g_maxIndex; ++i)
+            func((int)i);
+        if (*p != ',')
+            return;
+        ++p;
+    }
+}
+
+
+
+/// Detect number of NUMA nodes.
+int detectNodesCount()
+{
+    string line;
+    if (!readLine("/sys/devices/system/node/online", line))
+        return 1;
+    int count = 1;
+    parseList(line, [&count](int node)
+    {
+        if (node < g_maxNodes && node + 1 > count)
+            count = node + 1;
+    });
+    return count;
+}
+#endif
+}
+
+
+
+int cr::video::getNumaNodesCount()
+{
+#if defined(__linux__)
+    static const int count = detectNodesCount();
+    return count;
+#else
+    return 1;
+#endif
+}
+
+
+
+int cr::video::getCurrentNumaNode()
+{
+#if defined(__linux__)
+    if (getNumaNodesCount() == 1)
+        return 0;
+    unsigned cpu = 0;
+    unsigned node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0 || (int)node >= getNumaNodesCount())
+        return 0;
+    return (int)node;
+#else
+    return 0;
+#endif
+}
+
+
+
+bool cr::video::setThreadNumaNode(int node)
+{
+    if (node < 0 || node >= getNumaNodesCount())
+        return false;
+    if (getNumaNodesCount() == 1)
+        return true;
+#if defined(__linux__)
+    // CPUs of node.
+    string line;
+    if (!readLine("/sys/devices/system/node/node" + to_string(node) + "/cpulist", line))
+        return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    int count = 0;
+    parseList(line, [&](int cpu)
+    {
+        if (cpu < CPU_SETSIZE)
+        {
+            CPU_SET(cpu, &set);
+            ++count;
+        }
+    });
+    return count > 0 && sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+
+
+bool cr::video::allocateOnNumaNode(Frame& frame, int width, int height, Fourcc fourcc,
+                                   int node)
+{
+    // Check params.
+    if (node < 0)
+        node = getCurrentNumaNode();
+    if (node >= getNumaNodesCount() || !kernels::prepareFrame(frame, width, height, fourcc))
+        return false;
+    if (getNumaNodesCount() == 1)
+        return true;
+
+#if defined(__linux__)
+    // Bind whole pages of frame data.
+    const uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t begin = ((uintptr_t)frame.data + page - 1) & ~(page - 1);
+    uintptr_t end = ((uintptr_t)frame.data + (uintptr_t)frame.size) & ~(page - 1);
+    if (end > begin)
+    {
+        unsigned long mask[g_maxNodes / (8 * sizeof(unsigned long))] = {};
+        mask[node / (8 * sizeof(unsigned long))] |= 1ul << (node % (8 * sizeof(unsigned long)));
+        syscall(SYS_mbind, (void*)begin, (unsigned long)(end - begin), g_mpolBind, mask,
+                (unsigned long)g_maxNodes + 1, g_mpolMfMove);
+    }
+#endif
+
+    return true;
+}
+
+
+
+int cr::video::getFrameNumaNode(const Frame& frame)
+{
+    if (frame.data == nullptr || frame.size <= 0)
+        return -1;
+    if (getNumaNodesCount() == 1)
+        return 0;
+
+#if defined(__linux__)
+    int node = -1;
+    void* address = frame.data + frame.size / 2;
+    if (syscall(SYS_get_mempolicy, &node, nullptr, 0ul, address,
+                (unsigned long)(g_mpolFNode | g_mpolFAddr)) != 0)
+        return -1;
+    return node;
+#else
+    return -1;
+#endif
+}
+
+
+
+FrameNodePool::State::~State()
+{
+    for (auto& frames : nodes)
+        for (Frame* frame : frames)
+            delete frame;
+}
+
+
+
+FrameNodePool::FrameNodePool(int width, int height, Fourcc fourcc, int maxFreeFrames) :
+    m_width(width),
+    m_height(height),
+    m_fourcc(fourcc),
+    m_state(make_shared<State>())
+{
+    m_state->nodes.resize((size_t)getNumaNodesCount());
+    m_state->maxFreeFrames = maxFreeFrames < 0 ? 0 : maxFreeFrames;
+}
+
+
+
+shared_ptr<Frame> FrameNodePool::acquire(int node)
+{
+    if (node < 0)
+        node = getCurrentNumaNode();
+    if (node >= getNumaNodesCount())
+        return nullptr;
+
+    // Take free frame of node.
+    Frame* frame = nullptr;
+    {
+        lock_guard<mutex> lock(m_state->mutex);
+        vector<Frame*>& frames = m_state->nodes[(size_t)node];
+        if (!frames.empty())
+        {
+            frame = frames.back();
+            frames.pop_back();
+        }
+    }
+
+    // Allocate new frame or restore frame changed by user.
+    if (frame == nullptr)
+        frame = new Frame();
+    if (frame->data == nullptr || frame->width != m_width || frame->height != m_height ||
+        frame->fourcc != m_fourcc)
+    {
+        if (!allocateOnNumaNode(*frame, m_width, m_height, m_fourcc, node))
+        {
+            delete frame;
+            return nullptr;
+        }
+    }
+
+    // Frame returns to node list when released.
+    weak_ptr<State> weakState = m_state;
+    return shared_ptr<Frame>(frame, [weakState, node](Frame* released)
+    {
+        shared_ptr<State> state = weakState.lock();
+        if (state != nullptr)
+        {
+            lock_guard<mutex> lock(state->mutex);
+            vector<Frame*>& frames = state->nodes[(size_t)node];
+            if ((int)frames.size() < state->maxFreeFrames)
+            {
+                frames.push_back(released);
+                return;
+            }
+        }
+        delete released;
+    });
+}
+
+
+
+int FrameNodePool::getFreeCount(int node) const
+{
+    if (node < 0 || node >= getNumaNodesCount())
+        return 0;
+    lock_guard<mutex> lock(m_state->mutex);
+    return (int)m_state->nodes[(size_t)node].size();
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "Frame.h"
+
+
+
+namespace cr
+{
+namespace video
+{
+
+/**
+ * @brief Get number of NUMA nodes. Valid node indexes are [0, count).
+ * @return Number of nodes. 1 on single-node machines and on systems without
+ * NUMA support (all functions work with node 0 in this case).
+ */
+int getNumaNodesCount();
+
+/**
+ * @brief Get NUMA node of CPU which runs calling thread.
+ * @return Node index (0 on systems without NUMA support).
+ */
+int getCurrentNumaNode();
+
+/**
+ * @brief Pin calling thread to CPUs of NUMA node.
+ * @param node Node index.
+ * @return TRUE if the thread is pinned (or system has one node) or FALSE if
+ * node is not valid or affinity can't be set.
+ */
+bool setThreadNumaNode(int node);
+
+/**
+ * @brief Allocate frame data on NUMA node. Existing frame memory is reused
+ * if frame has the same size and pixel format. Pages of frame data are bound
+ * (and moved) to node.
+ * @param frame Frame.
+ * @param width Frame width (pixels).
+ * @param height Frame height (pixels).
+ * @param fourcc Pixel format (raw formats only).
+ * @param node Node index or -1 for node of calling thread.
+ * @return TRUE if the frame is allocated or FALSE if parameters not valid.
+ * Binding of pages is best effort: use getFrameNumaNode(...) to check it.
+ */
+bool allocateOnNumaNode(Frame& frame, int width, int height, Fourcc fourcc,
+                        int node = -1);
+
+/**
+ * @brief Get home NUMA node of frame data (node of memory page in middle of
+ * frame data).
+ * @param frame Frame.
+ * @return Node index, 0 on systems without NUMA support or -1 if frame has
+ * no data or node can't be detected.
+ */
+int getFrameNumaNode(const Frame& frame);
+
+
+
+/**
+ * @brief Pool of frames with one pixel format and size allocated on NUMA
+ * nodes. Each node has own list of free frames. Frames are returned to the
+ * pool of their node when last shared pointer is released (frames are
+ * deleted if pool is destroyed or node list is full). Methods are
+ * thread-safe.
+ */
+class FrameNodePool
+{
+public:
+
+    /**
+     * @brief Class constructor.
+     * @param width Frame width (pixels).
+     * @param height Frame height (pixels).
+     * @param fourcc Pixel format.
+     * @param maxFreeFrames Maximum number of free frames kept for each node.
+     */
+    FrameNodePool(int width, int height, Fourcc fourcc, int maxFreeFrames = 8);
+
+    /**
+     * @brief Get frame allocated on node. Frame from node list is reused or
+     * new frame is allocated. Frame data is not cleared.
+     * @param node Node index or -1 for node of calling thread.
+     * @return Frame or nullptr if node or pool parameters not valid.
+     */
+    std::shared_ptr<Frame> acquire(int node = -1);
+
+    /**
+     * @brief Get number of free frames of node.
+     * @param node Node index.
+     * @return Number of frames.
+     */
+    int getFreeCount(int node) const;
+
+private:
+
+    /// Pool state shared with frames deleters.
+    struct State
+    {
+        /// Free frames of nodes.
+        std::vector<std::vector<Frame*>> nodes;
+        /// Maximum number of free frames of node.
+        int maxFreeFrames{0};
+        /// Mutex to protect free lists.
+        std::mutex mutex;
+
+        ~State();
+    };
+
+    /// Frame parameters.
+    int m_width{0};
+    int m_height{0};
+    Fourcc m_fourcc{Fourcc::YUV24};
+    /// Pool state.
+    std::shared_ptr<State> m_state;
+};
+}
+}
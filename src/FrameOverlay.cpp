@@ -0,0 +1,561 @@
+#include <algorithm>
+#include <climits>
+#include <vector>
+#include "FrameOverlay.h"
+#include "FrameCompute.h"
+#include "FrameKernels.h"
+#include "FramePlane.h"
+
+
+
+// Link namespaces.
+using namespace std;
+using namespace cr::video;
+using namespace cr::video::kernels;
+
+
+
+namespace
+{
+
+/// Number of rows in band processed by one task (must be even).
+const int g_bandRows = 32;
+
+
+
+/// Position of luma and chroma samples in frame.
+struct Layout
+{
+    /// Luma samples.
+    uint8_t* y{nullptr};
+    ptrdiff_t yStride{0};
+    int yStep{1};
+    /// Chroma samples (nullptr for GRAY).
+    uint8_t* u{nullptr};
+    uint8_t* v{nullptr};
+    ptrdiff_t cStride{0};
+    int cStep{1};
+    /// Chroma is subsampled vertically (4:2:0).
+    bool is420{false};
+};
+
+
+
+/// YUV color of item.
+struct YuvColor
+{
+    uint8_t y{0};
+    uint8_t u{0};
+    uint8_t v{0};
+};
+
+
+
+/// Get layout of frame.
+bool getLayout(const Frame& frame, Layout& layout)
+{
+    FramePlane planes[3];
+    if (getPlanes(frame, planes) == 0)
+        return false;
+    const bool isEven = frame.width % 2 == 0 && frame.height % 2 == 0;
+
+    layout.y = planes[0].data;
+    layout.yStride = planes[0].stride;
+    switch (frame.fourcc)
+    {
+    case Fourcc::GRAY:
+        return true;
+    case Fourcc::NV12:
+    case Fourcc::NV21:
+    {
+        int uPos = frame.fourcc == Fourcc::NV12 ? 0 : 1;
+        layout.u = planes[1].data + uPos;
+        layout.v = planes[1].data + 1 - uPos;
+        layout.cStride = planes[1].stride;
+        layout.cStep = 2;
+        layout.is420 = true;
+        return isEven;
+    }
+    case Fourcc::YU12:
+    case Fourcc::YV12:
+    {
+        int uPlane = frame.fourcc == Fourcc::YU12 ? 1 : 2;
+        layout.u = planes[uPlane].data;
+        layout.v = planes[3 - uPlane].data;
+        layout.cStride = planes[1].stride;
+        layout.cStep = 1;
+        layout.is420 = true;
+        return isEven;
+    }
+    case Fourcc::YUYV:
+    case Fourcc::UYVY:
+    {
+        int yPos = frame.fourcc == Fourcc::YUYV ? 0 : 1;
+        layout.y = planes[0].data + yPos;
+        layout.yStep = 2;
+        layout.u = planes[0].data + 1 - yPos;
+        layout.v = layout.u + 2;
+        layout.cStride = planes[0].stride;
+        layout.cStep = 4;
+        return isEven;
+    }
+    default:
+        return false;
+    }
+}
+
+
+
+/// Area of frame (clipped item).
+struct Area
+{
+    int x0{0};
+    int x1{0};
+    int y0{0};
+    int y1{0};
+};
+
+
+
+/// Sprite of item.
+struct Sprite
+{
+    const uint8_t* data{nullptr};
+    int stride{0};
+    /// Position in frame.
+    int x{0};
+    int y{0};
+    bool isAlphaOnly{true};
+    /// Alpha of item color.
+    int alpha{255};
+};
+
+
+
+/// Buffers of sprite drawing: alpha and colors of two rows (pair of rows
+/// sharing chroma samples in 4:2:0 formats).
+struct SpriteBuffers
+{
+    explicit SpriteBuffers(int width) : data(8 * (size_t)width)
+    {
+        for (int r = 0; r < 2; ++r)
+        {
+            alpha[r] = &data[r * (size_t)width];
+            y[r] = &data[(2 + r) * (size_t)width];
+            u[r] = &data[(4 + r) * (size_t)width];
+            v[r] = &data[(6 + r) * (size_t)width];
+        }
+    }
+
+    vector<uint8_t> data;
+    uint8_t* alpha[2];
+    uint8_t* y[2];
+    uint8_t* u[2];
+    uint8_t* v[2];
+    /// Color which fills color rows (-1 - rows contain RGBA sprite colors).
+    int color{-1};
+};
+
+
+
+/// Blend chroma sample with colors of n (2 or 4) pixels: sums of alpha and
+/// alpha multiplied by color. Division by 255 * n is replaced by
+/// multiplication by reciprocal (exact for values < 2^22).
+inline void blendChroma(uint8_t& sample, int alphaSum, int colorSum, int n)
+{
+    const int full = 255 * n;
+    const uint64_t reciprocal = n == 4 ? 4210753 : 8421505;
+    uint32_t value = (uint32_t)(sample * (full - alphaSum) + colorSum + full / 2);
+    sample = (uint8_t)((value * reciprocal) >> 32);
+}
+
+
+
+/// Blend luma samples [x0, x1) of row with constant color and alpha.
+inline void blendLuma(uint8_t* row, int step, int x0, int x1, int color, int alpha)
+{
+    if (alpha == 255 && step == 1)
+    {
+        memset(row + x0, color, x1 - x0);
+        return;
+    }
+    const int colorPart = color * alpha;
+    const int inverse = 255 - alpha;
+    for (int x = x0; x < x1; ++x)
+        row[x * step] = (uint8_t)div255(row[x * step] * inverse + colorPart);
+}
+
+
+
+/// Draw area filled by constant color and alpha.
+void drawFill(const Layout& layout, const YuvColor& color, int alpha, const Area& area)
+{
+    // Luma.
+    for (int y = area.y0; y < area.y1; ++y)
+        blendLuma(layout.y + (size_t)y * layout.yStride, layout.yStep,
+                  area.x0, area.x1, color.y, alpha);
+    if (layout.u == nullptr)
+        return;
+
+    // Chroma with alpha multiplied by number of covered pixels of sample.
+    const int n = layout.is420 ? 4 : 2;
+    const int cy0 = layout.is420 ? area.y0 / 2 : area.y0;
+    const int cy1 = layout.is420 ? (area.y1 + 1) / 2 : area.y1;
+    const int cx0 = area.x0 / 2;
+    const int cx1 = (area.x1 + 1) / 2;
+    for (int cy = cy0; cy < cy1; ++cy)
+    {
+        int rows = 1;
+        if (layout.is420)
+            rows = (2 * cy >= area.y0 ? 1 : 0) + (2 * cy + 1 < area.y1 ? 1 : 0);
+        uint8_t* uRow = layout.u + (size_t)cy * layout.cStride;
+        uint8_t* vRow = layout.v + (size_t)cy * layout.cStride;
+        for (int cx = cx0; cx < cx1; ++cx)
+        {
+            int columns = (2 * cx >= area.x0 ? 1 : 0) + (2 * cx + 1 < area.x1 ? 1 : 0);
+            int alphaSum = alpha * rows * columns;
+            int c = cx * layout.cStep;
+            blendChroma(uRow[c], alphaSum, alphaSum * color.u, n);
+            blendChroma(vRow[c], alphaSum, alphaSum * color.v, n);
+        }
+    }
+}
+
+
+
+/// Draw area of sprite.
+void drawSprite(const Layout& layout, const YuvColor& color, const Sprite& sprite,
+                const Area& area, int width, SpriteBuffers& buffers)
+{
+    const KernelTable& table = getTable();
+
+    // Processed range is aligned to chroma samples.
+    const int ex0 = area.x0 & ~1;
+    const int ex1 = min((area.x1 + 1) & ~1, width);
+    const int n = ex1 - ex0;
+
+    // Color rows of A8 sprite are filled once for color.
+    const int packedColor = (color.y << 16) | (color.u << 8) | color.v;
+    if (sprite.isAlphaOnly && buffers.color != packedColor)
+    {
+        for (int r = 0; r < 2; ++r)
+        {
+            memset(buffers.y[r], color.y, width);
+            memset(buffers.u[r], color.u, width);
+            memset(buffers.v[r], color.v, width);
+        }
+        buffers.color = packedColor;
+    }
+    else if (!sprite.isAlphaOnly)
+    {
+        buffers.color = -1;
+    }
+
+    for (int py = area.y0 & ~1; py < area.y1; py += 2)
+    {
+        const bool inside[2] = {py >= area.y0, py + 1 < area.y1};
+        for (int r = 0; r < 2; ++r)
+        {
+            // Alpha (and color) of pixels, 0 for pixels out of area.
+            uint8_t* a = buffers.alpha[r] + ex0;
+            if (!inside[r])
+            {
+                memset(a, 0, n);
+                continue;
+            }
+            const int ry = py + r;
+            a[0] = 0;
+            a[n - 1] = 0;
+            const uint8_t* src = sprite.data + (size_t)(ry - sprite.y) * sprite.stride;
+            if (sprite.isAlphaOnly)
+            {
+                for (int x = area.x0; x < area.x1; ++x)
+                    a[x - ex0] = (uint8_t)div255(src[x - sprite.x] * sprite.alpha);
+            }
+            else
+            {
+                for (int x = area.x0; x < area.x1; ++x)
+                {
+                    const uint8_t* p = &src[(x - sprite.x) * 4];
+                    a[x - ex0] = (uint8_t)div255(p[3] * sprite.alpha);
+                    buffers.y[r][x] = rgbToY(p[0], p[1], p[2]);
+                    buffers.u[r][x] = rgbToU(p[0], p[1], p[2]);
+                    buffers.v[r][x] = rgbToV(p[0], p[1], p[2]);
+                }
+            }
+
+            // Blend luma.
+            uint8_t* yRow = layout.y + (size_t)ry * layout.yStride;
+            const uint8_t* cy = buffers.y[r] + ex0;
+            if (layout.yStep == 1)
+            {
+                table.blendRow(yRow + ex0, a, cy, n);
+            }
+            else
+            {
+                for (int j = 0; j < n; ++j)
+                {
+                    uint8_t& s = yRow[(ex0 + j) * layout.yStep];
+                    s = (uint8_t)div255(s * (255 - a[j]) + cy[j] * a[j]);
+                }
+            }
+        }
+        if (layout.u == nullptr)
+            continue;
+
+        // Blend chroma with alpha and color averaged over pixels of sample.
+        const int pixels = layout.is420 ? 4 : 2;
+        for (int r = 0; r < (layout.is420 ? 1 : 2); ++r)
+        {
+            if (!layout.is420 && !inside[r])
+                continue;
+            const int cyIndex = layout.is420 ? py / 2 : py + r;
+            const int lastRow = layout.is420 ? 1 : r;
+            uint8_t* uRow = layout.u + (size_t)cyIndex * layout.cStride;
+            uint8_t* vRow = layout.v + (size_t)cyIndex * layout.cStride;
+            for (int x = ex0; x < ex1; x += 2)
+            {
+                int alphaSum = 0;
+                int uSum = 0;
+                int vSum = 0;
+                for (int k = r; k <= lastRow; ++k)
+                {
+                    const uint8_t* a = buffers.alpha[k];
+                    alphaSum += a[x] + a[x + 1];
+                    uSum += a[x] * buffers.u[k][x] + a[x + 1] * buffers.u[k][x + 1];
+                    vSum += a[x] * buffers.v[k][x] + a[x + 1] * buffers.v[k][x + 1];
+                }
+                if (alphaSum == 0)
+                    continue;
+                int c = (x / 2) * layout.cStep;
+                blendChroma(uRow[c], alphaSum, uSum, pixels);
+                blendChroma(vRow[c], alphaSum, vSum, pixels);
+            }
+        }
+    }
+}
+}
+
+
+
+bool GlyphAtlas::setImage(const uint8_t* data, int width, int height, int stride)
+{
+    if (data == nullptr || width <= 0 || height <= 0 || stride < width)
+        return false;
+
+    m_image.resize((size_t)width * height);
+    for (int y = 0; y < height; ++y)
+        memcpy(&m_image[(size_t)y * width], data + (size_t)y * stride, width);
+    m_width = width;
+    m_height = height;
+    m_glyphs.assign(256, Glyph());
+
+    return true;
+}
+
+
+
+bool GlyphAtlas::addGlyph(uint8_t code, int x, int y, int width, int height,
+                          int offsetX, int offsetY, int advance)
+{
+    if (x < 0 || y < 0 || width < 0 || height < 0 ||
+        x + width > m_width || y + height > m_height)
+        return false;
+
+    Glyph& glyph = m_glyphs[code];
+    glyph.x = x;
+    glyph.y = y;
+    glyph.width = width;
+    glyph.height = height;
+    glyph.offsetX = offsetX;
+    glyph.offsetY = offsetY;
+    glyph.advance = advance;
+
+    return true;
+}
+
+
+
+int GlyphAtlas::getTextWidth(const std::string& text) const
+{
+    int width = 0;
+    for (unsigned char c : text)
+        width += m_glyphs[c].advance;
+    return width;
+}
+
+
+
+void FrameOverlay::clear()
+{
+    m_items.clear();
+}
+
+
+
+void FrameOverlay::addRect(int x, int y, int width, int height,
+                           OverlayColor color, int thickness)
+{
+    if (width <= 0 || height <= 0 || color.a == 0)
+        return;
+
+    Item item;
+    item.color = color;
+
+    // Filled rectangle.
+    const int64_t t = thickness;
+    if (t <= 0 || 2 * t >= width || 2 * t >= height)
+    {
+        item.x = x;
+        item.y = y;
+        item.width = width;
+        item.height = height;
+        m_items.push_back(item);
+        return;
+    }
+
+    // Borders without overlapping (pixels are blended once). Borders which
+    // begin after INT_MAX are out of any frame.
+    const int64_t borders[4][4] = {{x, y, width, t},
+                                   {x, (int64_t)y + height - t, width, t},
+                                   {x, y + t, t, height - 2 * t},
+                                   {(int64_t)x + width - t, y + t, t, height - 2 * t}};
+    for (int i = 0; i < 4; ++i)
+    {
+        if (borders[i][0] > INT_MAX || borders[i][1] > INT_MAX)
+            continue;
+        item.x = (int)borders[i][0];
+        item.y = (int)borders[i][1];
+        item.width = (int)borders[i][2];
+        item.height = (int)borders[i][3];
+        m_items.push_back(item);
+    }
+}
+
+
+
+void FrameOverlay::addSprite(int x, int y, const OverlaySprite& sprite,
+                             OverlayColor color)
+{
+    if (sprite.data == nullptr || sprite.width <= 0 || sprite.height <= 0 ||
+        color.a == 0)
+        return;
+
+    Item item;
+    item.x = x;
+    item.y = y;
+    item.width = sprite.width;
+    item.height = sprite.height;
+    item.color = color;
+    item.data = sprite.data;
+    item.stride = sprite.stride;
+    item.isAlphaOnly = sprite.isAlphaOnly;
+    m_items.push_back(item);
+}
+
+
+
+void FrameOverlay::addText(int x, int y, const std::string& text,
+                           const GlyphAtlas& atlas, OverlayColor color)
+{
+    if (color.a == 0 || atlas.m_image.empty())
+        return;
+
+    // Each glyph is A8 sprite in atlas image. Glyphs out of int range are
+    // out of any frame.
+    int64_t pen = x;
+    for (unsigned char c : text)
+    {
+        const GlyphAtlas::Glyph& glyph = atlas.m_glyphs[c];
+        const int64_t glyphX = pen + glyph.offsetX;
+        const int64_t glyphY = (int64_t)y + glyph.offsetY;
+        if (glyph.width > 0 && glyph.height > 0 && glyphX >= INT_MIN && glyphX <= INT_MAX &&
+            glyphY >= INT_MIN && glyphY <= INT_MAX)
+        {
+            Item item;
+            item.x = (int)glyphX;
+            item.y = (int)glyphY;
+            item.width = glyph.width;
+            item.height = glyph.height;
+            item.color = color;
+            item.data = &atlas.m_image[(size_t)glyph.y * atlas.m_width + glyph.x];
+            item.stride = atlas.m_width;
+            item.isAlphaOnly = true;
+            m_items.push_back(item);
+        }
+        pen += glyph.advance;
+    }
+}
+
+
+
+int FrameOverlay::getItemsCount() const
+{
+    return (int)m_items.size();
+}
+
+
+
+bool FrameOverlay::draw(Frame& frame) const
+{
+    // Check frame.
+    Layout layout;
+    if (!getLayout(frame, layout))
+        return false;
+    if (m_items.empty())
+        return true;
+    frame.invalidateCache();
+
+    // Colors of items in YUV.
+    vector<YuvColor> colors(m_items.size());
+    for (size_t i = 0; i < m_items.size(); ++i)
+    {
+        const OverlayColor& c = m_items[i].color;
+        colors[i].y = rgbToY(c.r, c.g, c.b);
+        colors[i].u = rgbToU(c.r, c.g, c.b);
+        colors[i].v = rgbToV(c.r, c.g, c.b);
+    }
+
+    const int w = frame.width;
+    const int h = frame.height;
+    const int bands = (h + g_bandRows - 1) / g_bandRows;
+    parallelFor(bands, 1, [&](int begin, int end)
+    {
+        SpriteBuffers buffers(w);
+        for (int band = begin; band < end; ++band)
+        {
+            const int bandBegin = band * g_bandRows;
+            const int bandEnd = min(bandBegin + g_bandRows, h);
+            for (size_t i = 0; i < m_items.size(); ++i)
+            {
+                // Clip item by band and frame (item end may not fit int).
+                const Item& item = m_items[i];
+                Area area;
+                area.x0 = max(item.x, 0);
+                area.x1 = (int)min((int64_t)item.x + item.width, (int64_t)w);
+                area.y0 = max(item.y, bandBegin);
+                area.y1 = (int)min((int64_t)item.y + item.height, (int64_t)bandEnd);
+                if (area.y0 >= area.y1 || area.x0 >= area.x1)
+                    continue;
+
+                if (item.data == nullptr)
+                {
+                    drawFill(layout, colors[i], item.color.a, area);
+                }
+                else
+                {
+                    Sprite sprite;
+                    sprite.data = item.data;
+                    sprite.stride = item.stride;
+                    sprite.x = item.x;
+                    sprite.y = item.y;
+                    sprite.isAlphaOnly = item.isAlphaOnly;
+                    sprite.alpha = item.color.a;
+                    drawSprite(layout, colors[i], sprite, area, w, buffers);
+                }
+            }
+        }
+    });
+
+    return true;
+}
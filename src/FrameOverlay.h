@@ -0,0 +1,206 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Frame.h"
+
+
+
+namespace cr
+{
+namespace video
+{
+
+/**
+ * @brief Overlay color.
+ */
+struct OverlayColor
+{
+    /// Red.
+    uint8_t r{0};
+    /// Green.
+    uint8_t g{0};
+    /// Blue.
+    uint8_t b{0};
+    /// Opacity: 0 - transparent, 255 - opaque.
+    uint8_t a{255};
+};
+
+
+
+/**
+ * @brief Sprite image. Memory is not copied and must be valid until
+ * overlay is drawn.
+ */
+struct OverlaySprite
+{
+    /// Pointer to first pixel.
+    const uint8_t* data{nullptr};
+    /// Sprite width (pixels).
+    int width{0};
+    /// Sprite height (pixels).
+    int height{0};
+    /// Distance between rows (bytes).
+    int stride{0};
+    /// TRUE - A8 sprite (1 byte alpha per pixel, color is set by overlay
+    /// item), FALSE - RGBA sprite (4 bytes per pixel, not premultiplied).
+    bool isAlphaOnly{false};
+};
+
+
+
+/**
+ * @brief Glyph atlas: A8 image with glyphs of characters. Atlas is filled
+ * once (for example by font rasterizer) and used to draw text labels
+ * without per frame rasterization.
+ */
+class GlyphAtlas
+{
+public:
+
+    /**
+     * @brief Set atlas image. Image data is copied. Glyphs are removed.
+     * @param data Pointer to A8 image (1 byte alpha per pixel).
+     * @param width Image width.
+     * @param height Image height.
+     * @param stride Distance between image rows (bytes).
+     * @return TRUE if the image set or FALSE if parameters are not valid.
+     */
+    bool setImage(const uint8_t* data, int width, int height, int stride);
+
+    /**
+     * @brief Add glyph of character.
+     * @param code Character code (byte of string).
+     * @param x Glyph rectangle horizontal position in atlas image.
+     * @param y Glyph rectangle vertical position in atlas image.
+     * @param width Glyph rectangle width.
+     * @param height Glyph rectangle height.
+     * @param offsetX Horizontal offset of glyph rectangle from pen position.
+     * @param offsetY Vertical offset of glyph rectangle from top of line.
+     * @param advance Pen movement after glyph (pixels).
+     * @return TRUE if the glyph added or FALSE if rectangle is out of image.
+     */
+    bool addGlyph(uint8_t code, int x, int y, int width, int height,
+                  int offsetX, int offsetY, int advance);
+
+    /**
+     * @brief Get width of text line.
+     * @param text Text.
+     * @return Width of text (pixels).
+     */
+    int getTextWidth(const std::string& text) const;
+
+private:
+
+    /// Glyph description.
+    struct Glyph
+    {
+        int x{0};
+        int y{0};
+        int width{0};
+        int height{0};
+        int offsetX{0};
+        int offsetY{0};
+        int advance{0};
+    };
+
+    /// Atlas image.
+    std::vector<uint8_t> m_image;
+    /// Atlas image width.
+    int m_width{0};
+    /// Atlas image height.
+    int m_height{0};
+    /// Glyphs of all character codes.
+    std::vector<Glyph> m_glyphs{std::vector<Glyph>(256)};
+
+    friend class FrameOverlay;
+};
+
+
+
+/**
+ * @brief Batch of overlay items (rectangles, sprites and text) drawn
+ * directly into YUV frames. Items are drawn in order of adding. Colors are
+ * converted to YUV (BT.601 limited range) once per item, chroma samples are
+ * blended with alpha averaged over pixels which share the sample. Frame is
+ * split into row bands processed in parallel by library thread pool (see
+ * FrameCompute.h), luma rows are blended by SIMD kernels.
+ */
+class FrameOverlay
+{
+public:
+
+    /**
+     * @brief Remove all items.
+     */
+    void clear();
+
+    /**
+     * @brief Add rectangle.
+     * @param x Left border position.
+     * @param y Top border position.
+     * @param width Rectangle width.
+     * @param height Rectangle height.
+     * @param color Color.
+     * @param thickness Border thickness (pixels). 0 - filled rectangle.
+     */
+    void addRect(int x, int y, int width, int height, OverlayColor color,
+                 int thickness = 0);
+
+    /**
+     * @brief Add sprite. Sprite alpha is multiplied by color alpha.
+     * @param x Sprite left border position.
+     * @param y Sprite top border position.
+     * @param sprite Sprite image.
+     * @param color Color of A8 sprite. Only alpha is used for RGBA sprite.
+     */
+    void addSprite(int x, int y, const OverlaySprite& sprite,
+                   OverlayColor color = OverlayColor());
+
+    /**
+     * @brief Add text line. Atlas must be valid until overlay is drawn.
+     * @param x Pen start position.
+     * @param y Top of line position.
+     * @param text Text.
+     * @param atlas Glyph atlas.
+     * @param color Text color.
+     */
+    void addText(int x, int y, const std::string& text, const GlyphAtlas& atlas,
+                 OverlayColor color);
+
+    /**
+     * @brief Get number of items (text line is one item per glyph, outlined
+     * rectangle is four items).
+     * @return Number of items.
+     */
+    int getItemsCount() const;
+
+    /**
+     * @brief Draw all items in frame in place.
+     * @param frame Frame. Supported pixel formats: NV12, NV21, YU12, YV12,
+     * YUYV, UYVY (even width and height) and GRAY.
+     * @return TRUE if items drawn or FALSE if pixel format not supported.
+     */
+    bool draw(Frame& frame) const;
+
+private:
+
+    /// Overlay item: rectangle filled by color or sprite.
+    struct Item
+    {
+        int x{0};
+        int y{0};
+        int width{0};
+        int height{0};
+        OverlayColor color;
+        /// Sprite data or nullptr for filled rectangle.
+        const uint8_t* data{nullptr};
+        int stride{0};
+        bool isAlphaOnly{true};
+    };
+
+    /// Items.
+    std::vector<Item> m_items;
+};
+}
+}
@@ -0,0 +1,69 @@
+#include "FramePlane.h"
+#include "FrameKernels.h"
+
+
+
+// Link namespaces.
+using namespace cr::video;
+
+
+
+int cr::video::getPlanes(const Frame& frame, FramePlane planes[3])
+{
+    // Check frame.
+    const int w = frame.width;
+    const int h = frame.height;
+    int64_t dataSize = kernels::getDataSize(frame.fourcc, w, h);
+    if (planes == nullptr || frame.data == nullptr || w <= 0 || h <= 0 ||
+        dataSize == 0 || frame.size < dataSize)
+        return 0;
+
+    // Function to fill plane.
+    auto setPlane = [&](FramePlane& plane, size_t offset, int width, int height,
+                        ptrdiff_t stride, int elementSize)
+    {
+        plane.data = frame.data + offset;
+        plane.width = width;
+        plane.height = height;
+        plane.stride = stride;
+        plane.elementSize = elementSize;
+    };
+
+    switch (frame.fourcc)
+    {
+    case Fourcc::RGB24:
+    case Fourcc::BGR24:
+    case Fourcc::YUV24:
+        setPlane(planes[0], 0, w, h, (ptrdiff_t)w * 3, 3);
+        return 1;
+    case Fourcc::GRAY:
+    case Fourcc::BGGR8:
+    case Fourcc::GBRG8:
+    case Fourcc::GRBG8:
+    case Fourcc::RGGB8:
+        setPlane(planes[0], 0, w, h, w, 1);
+        return 1;
+    case Fourcc::BGGR16:
+    case Fourcc::GBRG16:
+    case Fourcc::GRBG16:
+    case Fourcc::RGGB16:
+    case Fourcc::YUYV:
+    case Fourcc::UYVY:
+        setPlane(planes[0], 0, w, h, (ptrdiff_t)w * 2, 2);
+        return 1;
+    case Fourcc::NV12:
+    case Fourcc::NV21:
+        setPlane(planes[0], 0, w, h, w, 1);
+        setPlane(planes[1], (size_t)w * h, w / 2, h / 2, w, 2);
+        return 2;
+    case Fourcc::YU12:
+    case Fourcc::YV12:
+        setPlane(planes[0], 0, w, h, w, 1);
+        setPlane(planes[1], (size_t)w * h, w / 2, h / 2, w / 2, 1);
+        setPlane(planes[2], (size_t)w * h + (size_t)(w / 2) * (h / 2), w / 2, h / 2,
+                 w / 2, 1);
+        return 3;
+    default:
+        return 0;
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "Frame.h"
+
+
+
+namespace cr
+{
+namespace video
+{
+
+/**
+ * @brief Plane of raw frame data.
+ */
+struct FramePlane
+{
+    /// Pointer to first element of plane.
+    uint8_t* data{nullptr};
+    /// Plane width (elements).
+    int width{0};
+    /// Plane height (rows).
+    int height{0};
+    /// Distance between rows (bytes).
+    ptrdiff_t stride{0};
+    /// Element size (bytes).
+    int elementSize{0};
+};
+
+
+
+/**
+ * @brief Get planes of raw frame. Planes are returned in memory order:
+ * RGB24, BGR24, YUV24 - one plane of 3 bytes elements; GRAY and 8 bit
+ * Bayer - one plane of 1 byte elements; 16 bit Bayer - one plane of 2 bytes
+ * elements; YUYV, UYVY - one plane of 2 bytes elements (luma and one chroma
+ * component of pixel); NV12, NV21 - luma plane and plane of 2 bytes chroma
+ * pairs (width / 2 x height / 2); YU12, YV12 - luma plane and two chroma
+ * planes (width / 2 x height / 2).
+ * @param frame Frame.
+ * @param planes Output planes (up to 3).
+ * @return Number of planes or 0 if pixel format is not supported or frame
+ * data size doesn't match frame size.
+ */
+int getPlanes(const Frame& frame, FramePlane planes[3]);
+}
+}
@@ -0,0 +1,222 @@
+#include <algorithm>
+#include "FramePreEvent.h"
+
+
+
+// Link namespaces.
+using namespace std;
+using namespace cr::video;
+
+
+
+FramePreEventBuffer::FramePreEventBuffer(size_t capacity, int64_t maxDurationUs) :
+    m_arena(new uint8_t[capacity > 0 ? capacity : 1]),
+    m_capacity(capacity),
+    m_maxDurationUs(maxDurationUs > 0 ? maxDurationUs : 0)
+{
+
+}
+
+
+
+void FramePreEventBuffer::setMaxDuration(int64_t maxDurationUs)
+{
+    lock_guard<mutex> lock(m_mutex);
+    m_maxDurationUs = maxDurationUs > 0 ? maxDurationUs : 0;
+}
+
+
+
+bool FramePreEventBuffer::add(Frame& frame, int64_t timestampUs, bool withHash)
+{
+    // Check frame.
+    if (frame.size < 0 || (frame.size > 0 && frame.data == nullptr))
+        return false;
+    const int64_t serializedSize = frame.getSerializedSize(withHash);
+    if ((uint64_t)serializedSize > (uint64_t)m_capacity)
+        return false;
+    const size_t size = (size_t)serializedSize;
+
+    lock_guard<mutex> lock(m_mutex);
+    if (!m_records.empty() && timestampUs < m_records.back().timestampUs)
+        return false;
+
+    // Evict frames older than maximum duration.
+    if (m_maxDurationUs > 0)
+        while (!m_records.empty() &&
+               timestampUs - m_records.front().timestampUs > m_maxDurationUs)
+            evict();
+
+    // Find place for record: after newest record or from arena beginning
+    // (end of arena stays unused), evict oldest records until it's free.
+    size_t offset = 0;
+    while (!m_records.empty())
+    {
+        const size_t tail = m_records.front().offset;
+        if (tail < m_head)
+        {
+            // Records don't cross arena end: free space is after newest
+            // record and before oldest one.
+            if (m_head + size <= m_capacity)
+            {
+                offset = m_head;
+                break;
+            }
+            if (size <= tail)
+                break;
+        }
+        else if (m_head + size <= tail)
+        {
+            // Free space is between newest and oldest records.
+            offset = m_head;
+            break;
+        }
+        evict();
+    }
+
+    // Serialize frame directly to arena.
+    int64_t written = 0;
+    frame.serialize(&m_arena[offset], written, withHash);
+
+    Record record;
+    record.frameId = frame.frameId;
+    record.timestampUs = timestampUs;
+    record.offset = offset;
+    record.size = size;
+    m_records.push_back(record);
+    m_head = offset + size;
+    m_size += size;
+
+    return true;
+}
+
+
+
+int FramePreEventBuffer::getFramesCount() const
+{
+    lock_guard<mutex> lock(m_mutex);
+    return (int)m_records.size();
+}
+
+
+
+size_t FramePreEventBuffer::getSize() const
+{
+    lock_guard<mutex> lock(m_mutex);
+    return m_size;
+}
+
+
+
+bool FramePreEventBuffer::getTimeRange(int64_t& first, int64_t& last) const
+{
+    lock_guard<mutex> lock(m_mutex);
+    if (m_records.empty())
+        return false;
+    first = m_records.front().timestampUs;
+    last = m_records.back().timestampUs;
+    return true;
+}
+
+
+
+int FramePreEventBuffer::findFrame(int frameId) const
+{
+    lock_guard<mutex> lock(m_mutex);
+    for (int i = (int)m_records.size() - 1; i >= 0; --i)
+        if (m_records[i].frameId == frameId)
+            return i;
+    return -1;
+}
+
+
+
+int FramePreEventBuffer::findTime(int64_t timestampUs) const
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    // Timestamps don't decrease.
+    auto it = lower_bound(m_records.begin(), m_records.end(), timestampUs,
+                          [](const Record& record, int64_t value)
+                          { return record.timestampUs < value; });
+    if (it == m_records.end())
+        return -1;
+    return (int)(it - m_records.begin());
+}
+
+
+
+bool FramePreEventBuffer::getRecord(int index, const uint8_t*& data, size_t& size,
+                                    int64_t& timestampUs) const
+{
+    lock_guard<mutex> lock(m_mutex);
+    if (index < 0 || index >= (int)m_records.size())
+        return false;
+    const Record& record = m_records[index];
+    data = &m_arena[record.offset];
+    size = record.size;
+    timestampUs = record.timestampUs;
+    return true;
+}
+
+
+
+bool FramePreEventBuffer::getFrame(int index, Frame& frame) const
+{
+    lock_guard<mutex> lock(m_mutex);
+    if (index < 0 || index >= (int)m_records.size())
+        return false;
+    const Record& record = m_records[index];
+    return frame.deserialize(&m_arena[record.offset], (int64_t)record.size);
+}
+
+
+
+int FramePreEventBuffer::exportFrames(int first, const Writer& writer) const
+{
+    lock_guard<mutex> lock(m_mutex);
+    const int count = (int)m_records.size();
+    if (first < 0 || first > count || !writer)
+        return -1;
+
+    // Records which follow each other in arena are written by one call.
+    size_t begin = 0;
+    size_t size = 0;
+    for (int i = first; i < count; ++i)
+    {
+        const Record& record = m_records[i];
+        if (size > 0 && record.offset == begin + size)
+        {
+            size += record.size;
+            continue;
+        }
+        if (size > 0 && !writer(&m_arena[begin], size))
+            return -1;
+        begin = record.offset;
+        size = record.size;
+    }
+    if (size > 0 && !writer(&m_arena[begin], size))
+        return -1;
+
+    return count - first;
+}
+
+
+
+void FramePreEventBuffer::clear()
+{
+    lock_guard<mutex> lock(m_mutex);
+    m_records.clear();
+    m_head = 0;
+    m_size = 0;
+}
+
+
+
+void FramePreEventBuffer::evict()
+{
+    m_size -= m_records.front().size;
+    m_records.pop_front();
+    if (m_records.empty())
+        m_head = 0;
+}
@@ -0,0 +1,168 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include "Frame.h"
+
+
+
+namespace cr
+{
+namespace video
+{
+
+/**
+ * @brief Pre-event buffer: keeps last frames of camera (raw or compressed)
+ * serialized by Frame::serialize(...) one after another in one circular
+ * byte arena allocated once. Each record is one continuous serialized frame
+ * (record which doesn't fit the end of arena is written from arena
+ * beginning), oldest records are evicted when arena is full or when they
+ * are older than maximum duration. Records are indexed by frame ID and
+ * timestamp. Exported data is sequence of serialized frames which can be
+ * read by FrameDeserializer or Frame::deserialize(...). Methods are
+ * thread-safe.
+ */
+class FramePreEventBuffer
+{
+public:
+
+    /**
+     * @brief Exported data writer (file, socket etc.). Returns FALSE to
+     * stop export.
+     */
+    typedef std::function<bool(const uint8_t* data, size_t size)> Writer;
+
+    /**
+     * @brief Class constructor.
+     * @param capacity Arena size (bytes).
+     * @param maxDurationUs Maximum time between oldest and newest frames
+     * (microseconds). 0 - not limited (only arena size limits buffer).
+     */
+    explicit FramePreEventBuffer(size_t capacity, int64_t maxDurationUs = 0);
+
+    /**
+     * @brief Set maximum time between oldest and newest frames. Old frames
+     * are evicted on next add(...).
+     * @param maxDurationUs Maximum duration (microseconds). 0 - not limited.
+     */
+    void setMaxDuration(int64_t maxDurationUs);
+
+    /**
+     * @brief Serialize frame to arena evicting oldest frames if necessary.
+     * @param frame Frame.
+     * @param timestampUs Frame timestamp (microseconds), must not be less
+     * than timestamp of previous frame.
+     * @param withHash Write content hash (see Frame::getHash()) to header.
+     * @return TRUE if the frame added or FALSE if serialized frame is bigger
+     * than arena, frame is not valid or timestamp is less than previous.
+     */
+    bool add(Frame& frame, int64_t timestampUs, bool withHash = false);
+
+    /**
+     * @brief Get number of frames in buffer.
+     * @return Number of frames.
+     */
+    int getFramesCount() const;
+
+    /**
+     * @brief Get size of serialized frames in buffer.
+     * @return Size (bytes).
+     */
+    size_t getSize() const;
+
+    /**
+     * @brief Get timestamps of oldest and newest frames.
+     * @param first Output timestamp of oldest frame (microseconds).
+     * @param last Output timestamp of newest frame (microseconds).
+     * @return TRUE if timestamps are ready or FALSE if buffer is empty.
+     */
+    bool getTimeRange(int64_t& first, int64_t& last) const;
+
+    /**
+     * @brief Find newest frame with frame ID.
+     * @param frameId Frame ID.
+     * @return Frame index (0 - oldest frame) or -1 if not found.
+     */
+    int findFrame(int frameId) const;
+
+    /**
+     * @brief Find first frame with timestamp not less than given.
+     * @param timestampUs Timestamp (microseconds).
+     * @return Frame index (0 - oldest frame) or -1 if not found.
+     */
+    int findTime(int64_t timestampUs) const;
+
+    /**
+     * @brief Get serialized frame without copying. Data stays valid until
+     * next add(...) or clear() call.
+     * @param index Frame index (0 - oldest frame).
+     * @param data Output pointer to serialized frame.
+     * @param size Output size of serialized frame (bytes).
+     * @param timestampUs Output frame timestamp (microseconds).
+     * @return TRUE if the record is ready or FALSE if index not valid.
+     */
+    bool getRecord(int index, const uint8_t*& data, size_t& size,
+                   int64_t& timestampUs) const;
+
+    /**
+     * @brief Get copy of frame.
+     * @param index Frame index (0 - oldest frame).
+     * @param frame Output frame.
+     * @return TRUE if the frame is ready or FALSE if index not valid.
+     */
+    bool getFrame(int index, Frame& frame) const;
+
+    /**
+     * @brief Export frames from index to newest frame without copying:
+     * writer gets pointers to arena. Serialized frames which follow each
+     * other in arena are passed by one call (usually one or two calls for
+     * whole buffer). Buffer is locked (add(...) waits) until export is done.
+     * @param first Index of first exported frame (0 - oldest frame).
+     * @param writer Data writer.
+     * @return Number of exported frames or -1 if index not valid or writer
+     * returned FALSE.
+     */
+    int exportFrames(int first, const Writer& writer) const;
+
+    /**
+     * @brief Remove all frames. Arena is kept.
+     */
+    void clear();
+
+private:
+
+    /// Index record of serialized frame.
+    struct Record
+    {
+        /// Frame ID.
+        int frameId{0};
+        /// Timestamp (microseconds).
+        int64_t timestampUs{0};
+        /// Offset in arena.
+        size_t offset{0};
+        /// Size of serialized frame (bytes).
+        size_t size{0};
+    };
+
+    /// Remove oldest record (mutex must be locked).
+    void evict();
+
+    /// Arena.
+    std::unique_ptr<uint8_t[]> m_arena;
+    /// Arena size (bytes).
+    size_t m_capacity{0};
+    /// Offset to write next record.
+    size_t m_head{0};
+    /// Size of records (bytes).
+    size_t m_size{0};
+    /// Maximum duration (microseconds).
+    int64_t m_maxDurationUs{0};
+    /// Index of records from oldest to newest.
+    std::deque<Record> m_records;
+    /// Mutex to protect buffer.
+    mutable std::mutex m_mutex;
+};
+}
+}
@@ -0,0 +1,135 @@
+#include "FramePyramid.h"
+#include "FrameCompute.h"
+#include "FrameKernels.h"
+#include "FramePlane.h"
+
+
+
+// Link namespaces.
+using namespace std;
+using namespace cr::video;
+using namespace cr::video::kernels;
+
+
+
+namespace
+{
+
+/// Minimum number of source rows in band processed by one task.
+const int g_bandRows = 32;
+}
+
+
+
+bool FramePyramid::build(const Frame& frame, int levels)
+{
+    // Check frame.
+    FramePlane planes[3];
+    if (levels < 1 || levels > MAX_LEVELS || getPlanes(frame, planes) == 0)
+        return false;
+    switch (frame.fourcc)
+    {
+    case Fourcc::GRAY:
+    case Fourcc::NV12:
+    case Fourcc::NV21:
+    case Fourcc::YU12:
+    case Fourcc::YV12:
+        break;
+    default:
+        return false;
+    }
+
+    lock_guard<mutex> lock(m_mutex);
+
+    // Check cached pyramid.
+    if (m_levels > 0 && m_source == frame.data && m_widths[0] == frame.width &&
+        m_heights[0] == frame.height && m_fourcc == frame.fourcc &&
+        m_frameId == frame.frameId && m_sourceId == frame.sourceId &&
+        (m_levels >= levels || m_widths[m_levels - 1] == 1 ||
+         m_heights[m_levels - 1] == 1))
+        return true;
+
+    // Levels sizes.
+    m_levels = 1;
+    m_widths[0] = frame.width;
+    m_heights[0] = frame.height;
+    size_t size = 0;
+    while (m_levels < levels && m_widths[m_levels - 1] > 1 && m_heights[m_levels - 1] > 1)
+    {
+        m_offsets[m_levels] = (int)size;
+        m_widths[m_levels] = m_widths[m_levels - 1] / 2;
+        m_heights[m_levels] = m_heights[m_levels - 1] / 2;
+        size += (size_t)m_widths[m_levels] * m_heights[m_levels];
+        ++m_levels;
+    }
+    m_buffer.resize(size);
+    m_source = frame.data;
+    m_fourcc = frame.fourcc;
+    m_frameId = frame.frameId;
+    m_sourceId = frame.sourceId;
+
+    // Bands of source rows aligned to last level: level rows of band depend
+    // only on rows of previous level in the same band.
+    const int align = 1 << (m_levels - 1);
+    const int bandRows = ((g_bandRows + align - 1) / align) * align;
+    const int bands = (frame.height + bandRows - 1) / bandRows;
+    const KernelTable& table = getTable();
+    parallelFor(bands, 1, [&](int begin, int end)
+    {
+        for (int band = begin; band < end; ++band)
+        {
+            int first = band * bandRows;
+            bool isLast = first + bandRows >= frame.height;
+            for (int l = 1; l < m_levels; ++l)
+            {
+                const uint8_t* src = l == 1 ? frame.data : &m_buffer[m_offsets[l - 1]];
+                const int srcStride = m_widths[l - 1];
+                uint8_t* dst = &m_buffer[m_offsets[l]];
+                int last = isLast ? m_heights[l] : (first + bandRows) >> l;
+                for (int y = first >> l; y < last; ++y)
+                    table.downscaleRow(&src[(size_t)2 * y * srcStride],
+                                       &src[(size_t)(2 * y + 1) * srcStride],
+                                       m_widths[l], &dst[(size_t)y * m_widths[l]]);
+            }
+        }
+    });
+
+    return true;
+}
+
+
+
+int FramePyramid::getLevelsCount() const
+{
+    lock_guard<mutex> lock(m_mutex);
+    return m_levels;
+}
+
+
+
+bool FramePyramid::getLevel(int level, Frame& frame) const
+{
+    lock_guard<mutex> lock(m_mutex);
+    if (level < 0 || level >= m_levels)
+        return false;
+
+    // Release frame memory and point to level data.
+    frame.release();
+    frame.width = m_widths[level];
+    frame.height = m_heights[level];
+    frame.fourcc = Fourcc::GRAY;
+    frame.size = (int64_t)m_widths[level] * m_heights[level];
+    frame.frameId = m_frameId;
+    frame.sourceId = m_sourceId;
+    frame.data = level == 0 ? m_source : (uint8_t*)&m_buffer[m_offsets[level]];
+
+    return true;
+}
+
+
+
+void FramePyramid::invalidate()
+{
+    lock_guard<mutex> lock(m_mutex);
+    m_levels = 0;
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "Frame.h"
+
+
+
+namespace cr
+{
+namespace video
+{
+
+/**
+ * @brief Luma image pyramid. Level 0 is luma of source frame, each next
+ * level is 2x downscaled previous level (2x2 box filter, sizes rounded
+ * down). All levels are built in one pass by bands of source rows
+ * processed in parallel by library thread pool (see FrameCompute.h) and
+ * stored in one contiguous buffer. Pyramid is cached against source frame:
+ * build(...) doesn't rebuild levels for the same frame, so one pyramid
+ * object can be shared by many consumers.
+ */
+class FramePyramid
+{
+public:
+
+    /**
+     * @brief Maximum number of levels.
+     */
+    static const int MAX_LEVELS = 16;
+
+    /**
+     * @brief Build pyramid. Method is thread-safe: if many consumers call
+     * it for the same frame levels are built only once.
+     * @param frame Source frame. Supported pixel formats: GRAY, NV12, NV21,
+     * YU12 and YV12.
+     * @param levels Number of levels including level 0 [1, MAX_LEVELS].
+     * Number of levels is limited so the last level is at least 1 x 1.
+     * @return TRUE if the pyramid is built or FALSE if parameters not valid.
+     */
+    bool build(const Frame& frame, int levels);
+
+    /**
+     * @brief Get number of built levels including level 0.
+     * @return Number of levels or 0 if pyramid is not built.
+     */
+    int getLevelsCount() const;
+
+    /**
+     * @brief Get level as GRAY frame without copying data. Memory of output
+     * frame is released and frame data pointer is set to pyramid buffer
+     * (level 0 points to luma of source frame). Frame is valid until next
+     * build for another frame.
+     * @param level Level index.
+     * @param frame Output frame.
+     * @return TRUE if the frame is set or FALSE if level is not valid.
+     */
+    bool getLevel(int level, Frame& frame) const;
+
+    /**
+     * @brief Drop cached pyramid. Next build(...) rebuilds levels even for
+     * the same frame (for example if frame data is changed in place).
+     */
+    void invalidate();
+
+private:
+
+    /// Levels 1 ... N.
+    std::vector<uint8_t> m_buffer;
+    /// Offsets of levels in buffer (level 0 - not used).
+    int m_offsets[MAX_LEVELS]{};
+    int m_widths[MAX_LEVELS]{};
+    int m_heights[MAX_LEVELS]{};
+    /// Number of levels.
+    int m_levels{0};
+    /// Source frame of built pyramid.
+    uint8_t* m_source{nullptr};
+    int m_frameId{0};
+    int m_sourceId{0};
+    Fourcc m_fourcc{Fourcc::GRAY};
+    /// Mutex to build pyramid once.
+    mutable std::mutex m_mutex;
+};
+}
+}
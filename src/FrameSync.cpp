@@ -0,0 +1,291 @@
+#include <climits>
+#include <cstdlib>
+#include "FrameSync.h"
+
+
+
+// Link namespaces.
+using namespace std;
+using namespace std::chrono;
+using namespace cr::video;
+
+
+
+FrameSynchronizer::FrameSynchronizer(const vector<int>& sourceIds, int slots)
+{
+    for (int sourceId : sourceIds)
+    {
+        m_sources.emplace_back(new Source());
+        m_sources.back()->sourceId = sourceId;
+        m_sources.back()->slots.resize(slots > 0 ? (size_t)slots : 1);
+    }
+}
+
+
+
+void FrameSynchronizer::setKey(SyncKey key, int64_t toleranceUs)
+{
+    m_key = key;
+    m_toleranceUs = key == SyncKey::TIMESTAMP && toleranceUs > 0 ? toleranceUs : 0;
+}
+
+
+
+void FrameSynchronizer::setMissingPolicy(SyncPolicy policy, int64_t maxWaitUs)
+{
+    m_missingPolicy = policy;
+    m_maxWaitUs = maxWaitUs > 0 ? maxWaitUs : 0;
+}
+
+
+
+void FrameSynchronizer::setLatePolicy(SyncPolicy policy)
+{
+    m_latePolicy = policy;
+}
+
+
+
+bool FrameSynchronizer::push(const Frame& frame, int64_t timestampUs)
+{
+    shared_ptr<Frame> copy = make_shared<Frame>();
+    *copy = frame;
+    return push(shared_ptr<const Frame>(move(copy)), timestampUs);
+}
+
+
+
+bool FrameSynchronizer::push(shared_ptr<const Frame> frame, int64_t timestampUs)
+{
+    if (frame == nullptr)
+        return false;
+
+    // Find source.
+    Source* source = nullptr;
+    for (auto& item : m_sources)
+        if (item->sourceId == frame->sourceId)
+            source = item.get();
+    if (source == nullptr)
+        return false;
+
+    // Check free slot.
+    const uint64_t tail = source->tail.load(memory_order_relaxed);
+    if (tail - source->head.load(memory_order_acquire) >= source->slots.size())
+    {
+        source->overflow.fetch_add(1, memory_order_relaxed);
+        return false;
+    }
+
+    // Fill slot and pass it to consumer.
+    Slot& slot = source->slots[tail % source->slots.size()];
+    slot.key = m_key == SyncKey::FRAME_ID ? (int64_t)frame->frameId : timestampUs;
+    slot.timestampUs = timestampUs;
+    slot.arrival = steady_clock::now();
+    slot.frame = move(frame);
+    source->tail.store(tail + 1, memory_order_release);
+
+    return true;
+}
+
+
+
+bool FrameSynchronizer::getTuple(FrameTuple& tuple)
+{
+    const int count = (int)m_sources.size();
+    while (count > 0)
+    {
+        // Late frames.
+        for (int i = 0; i < count; ++i)
+        {
+            Slot* slot = nullptr;
+            while (m_hasLastKey && (slot = getSlot(i, 0)) != nullptr && slot->key <= m_lastKey)
+            {
+                m_late.fetch_add(1, memory_order_relaxed);
+                if (m_latePolicy == SyncPolicy::PARTIAL)
+                {
+                    begin(tuple);
+                    take(i, tuple);
+                    finish(tuple, false);
+                    return true;
+                }
+                drop(i);
+            }
+        }
+
+        // Newest head frame.
+        int64_t newest = INT64_MIN;
+        int available = 0;
+        for (int i = 0; i < count; ++i)
+        {
+            Slot* slot = getSlot(i, 0);
+            if (slot == nullptr)
+                continue;
+            ++available;
+            if (slot->key > newest)
+                newest = slot->key;
+        }
+        if (available == 0)
+            return false;
+
+        // Head frame can't be matched if it's older than newest head frame
+        // (more than tolerance) or next frame of source is closer to newest
+        // head frame.
+        int unmatched = -1;
+        for (int i = 0; i < count && unmatched < 0; ++i)
+        {
+            Slot* slot = getSlot(i, 0);
+            Slot* next = getSlot(i, 1);
+            if ((slot != nullptr && slot->key < newest - m_toleranceUs) ||
+                (next != nullptr && abs(next->key - newest) < abs(slot->key - newest)))
+                unmatched = i;
+        }
+        if (unmatched >= 0)
+        {
+            if (m_missingPolicy == SyncPolicy::PARTIAL)
+            {
+                begin(tuple);
+                take(unmatched, tuple);
+                finish(tuple, false);
+                return true;
+            }
+            m_dropped.fetch_add(1, memory_order_relaxed);
+            drop(unmatched);
+            continue;
+        }
+
+        // All sources have matched frames.
+        if (available == count)
+        {
+            begin(tuple);
+            for (int i = 0; i < count; ++i)
+                take(i, tuple);
+            finish(tuple, true);
+            return true;
+        }
+
+        // Wait for missing frames.
+        if (m_maxWaitUs == 0)
+            return false;
+        steady_clock::time_point first = steady_clock::time_point::max();
+        for (int i = 0; i < count; ++i)
+        {
+            Slot* slot = getSlot(i, 0);
+            if (slot != nullptr && slot->arrival < first)
+                first = slot->arrival;
+        }
+        if (steady_clock::now() - first < microseconds(m_maxWaitUs))
+            return false;
+
+        // Waiting time is over.
+        if (m_missingPolicy == SyncPolicy::PARTIAL)
+        {
+            begin(tuple);
+            for (int i = 0; i < count; ++i)
+                if (getSlot(i, 0) != nullptr)
+                    take(i, tuple);
+            finish(tuple, false);
+            return true;
+        }
+        m_dropped.fetch_add((uint64_t)available, memory_order_relaxed);
+        for (int i = 0; i < count; ++i)
+            if (getSlot(i, 0) != nullptr)
+                drop(i);
+    }
+
+    return false;
+}
+
+
+
+int FrameSynchronizer::getSourcesCount() const
+{
+    return (int)m_sources.size();
+}
+
+
+
+void FrameSynchronizer::getStats(FrameSyncStats& stats) const
+{
+    stats.tuples = m_tuples.load(memory_order_relaxed);
+    stats.partialTuples = m_partialTuples.load(memory_order_relaxed);
+    stats.dropped = m_dropped.load(memory_order_relaxed);
+    stats.late = m_late.load(memory_order_relaxed);
+    stats.overflow = 0;
+    for (const auto& source : m_sources)
+        stats.overflow += source->overflow.load(memory_order_relaxed);
+    const uint64_t tuples = stats.tuples + stats.partialTuples;
+    stats.averageLatencyUs = tuples > 0 ?
+        (double)m_totalLatencyUs.load(memory_order_relaxed) / (double)tuples : 0.0;
+    stats.maxLatencyUs = m_maxLatencyUs.load(memory_order_relaxed);
+}
+
+
+
+FrameSynchronizer::Slot* FrameSynchronizer::getSlot(int source, uint64_t position)
+{
+    Source& s = *m_sources[source];
+    const uint64_t head = s.head.load(memory_order_relaxed);
+    if (head + position >= s.tail.load(memory_order_acquire))
+        return nullptr;
+    return &s.slots[(head + position) % s.slots.size()];
+}
+
+
+
+void FrameSynchronizer::begin(FrameTuple& tuple)
+{
+    tuple.frames.assign(m_sources.size(), nullptr);
+    tuple.timestamps.assign(m_sources.size(), 0);
+    m_tupleKey = INT64_MAX;
+    m_firstArrival = steady_clock::time_point::max();
+}
+
+
+
+void FrameSynchronizer::take(int source, FrameTuple& tuple)
+{
+    Source& s = *m_sources[source];
+    const uint64_t head = s.head.load(memory_order_relaxed);
+    Slot& slot = s.slots[head % s.slots.size()];
+    tuple.frames[source] = move(slot.frame);
+    tuple.timestamps[source] = slot.timestampUs;
+    if (slot.key < m_tupleKey)
+        m_tupleKey = slot.key;
+    if (slot.arrival < m_firstArrival)
+        m_firstArrival = slot.arrival;
+
+    // Slot is free for producer.
+    s.head.store(head + 1, memory_order_release);
+}
+
+
+
+void FrameSynchronizer::drop(int source)
+{
+    Source& s = *m_sources[source];
+    const uint64_t head = s.head.load(memory_order_relaxed);
+    s.slots[head % s.slots.size()].frame.reset();
+    s.head.store(head + 1, memory_order_release);
+}
+
+
+
+void FrameSynchronizer::finish(FrameTuple& tuple, bool isComplete)
+{
+    tuple.isComplete = isComplete;
+    tuple.latencyUs = duration_cast<microseconds>(steady_clock::now() - m_firstArrival).count();
+
+    // Statistics.
+    if (isComplete)
+        m_tuples.fetch_add(1, memory_order_relaxed);
+    else
+        m_partialTuples.fetch_add(1, memory_order_relaxed);
+    m_totalLatencyUs.fetch_add(tuple.latencyUs, memory_order_relaxed);
+    if (tuple.latencyUs > m_maxLatencyUs.load(memory_order_relaxed))
+        m_maxLatencyUs.store(tuple.latencyUs, memory_order_relaxed);
+
+    // Frames not newer than the tuple are late.
+    if (!m_hasLastKey || m_tupleKey > m_lastKey)
+        m_lastKey = m_tupleKey;
+    m_hasLastKey = true;
+}
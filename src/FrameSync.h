@@ -0,0 +1,240 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Frame.h"
+
+
+
+namespace cr
+{
+namespace video
+{
+
+/**
+ * @brief Key to match frames of different sources.
+ */
+enum class SyncKey
+{
+    /// Frame ID (frameId field), frames match if IDs are equal.
+    FRAME_ID = 0,
+    /// Timestamp given to push(...), frames match if timestamps differ not
+    /// more than tolerance.
+    TIMESTAMP = 1
+};
+
+
+
+/**
+ * @brief Policies of frames which can't be matched.
+ */
+enum class SyncPolicy
+{
+    /// Frames are dropped.
+    DROP = 0,
+    /// Frames are returned in partial tuples (missing frames are nullptr).
+    PARTIAL = 1
+};
+
+
+
+/**
+ * @brief Tuple of matched frames.
+ */
+struct FrameTuple
+{
+    /// Frames in order of sources (nullptr - missing frame of partial
+    /// tuple). Frames are shared with producers, not copied.
+    std::vector<std::shared_ptr<const Frame>> frames;
+    /// Timestamps of frames (microseconds).
+    std::vector<int64_t> timestamps;
+    /// Time from arrival of first frame of tuple until tuple is returned
+    /// (microseconds).
+    int64_t latencyUs{0};
+    /// Flag of tuple with all frames.
+    bool isComplete{false};
+};
+
+
+
+/**
+ * @brief Statistics of synchronizer.
+ */
+struct FrameSyncStats
+{
+    /// Number of complete tuples.
+    uint64_t tuples{0};
+    /// Number of partial tuples.
+    uint64_t partialTuples{0};
+    /// Number of frames dropped because matching frames are missing.
+    uint64_t dropped{0};
+    /// Number of frames dropped because they came after newer tuple.
+    uint64_t late{0};
+    /// Number of frames rejected by push(...) because source slots are full.
+    uint64_t overflow{0};
+    /// Average pairing latency of tuples (microseconds).
+    double averageLatencyUs{0.0};
+    /// Maximum pairing latency of tuples (microseconds).
+    int64_t maxLatencyUs{0};
+};
+
+
+
+/**
+ * @brief Synchronizer of frames of several sources (stereo cameras,
+ * visible and thermal cameras etc.): matches frames of sources by frame ID
+ * or timestamp and returns tuples of matched frames. Each source has ring
+ * of preallocated slots: one producer thread per source puts frames by
+ * push(...) and one consumer thread gets tuples by getTuple(...) without
+ * locks. Frames are passed by shared pointers without copying (except
+ * push(const Frame&, ...) which copies frame). Frame keys
+ * (frame ID or timestamp) of each source must increase.
+ */
+class FrameSynchronizer
+{
+public:
+
+    /**
+     * @brief Class constructor.
+     * @param sourceIds Source IDs (sourceId field of frames). Frames of
+     * tuples are in the same order.
+     * @param slots Number of slots of each source (>= 1).
+     */
+    explicit FrameSynchronizer(const std::vector<int>& sourceIds, int slots = 8);
+
+    /**
+     * @brief Set matching key. Must be called before frames are pushed.
+     * @param key Matching key.
+     * @param toleranceUs Maximum difference of matched timestamps
+     * (microseconds) for TIMESTAMP key.
+     */
+    void setKey(SyncKey key, int64_t toleranceUs = 0);
+
+    /**
+     * @brief Set policy of frames which can't be matched because frames of
+     * other sources are missing. Must be called before frames are pushed.
+     * @param policy Policy.
+     * @param maxWaitUs Maximum time to wait for missing frames
+     * (microseconds). 0 - frames wait until newer frames of all sources come.
+     */
+    void setMissingPolicy(SyncPolicy policy, int64_t maxWaitUs = 0);
+
+    /**
+     * @brief Set policy of late frames (frames which come after newer
+     * tuple is returned). Must be called before frames are pushed.
+     * @param policy Policy.
+     */
+    void setLatePolicy(SyncPolicy policy);
+
+    /**
+     * @brief Put copy of frame to slots of source. Source is defined by
+     * sourceId field of frame. Method allocates new frame and copies frame
+     * data on every call: use push(std::shared_ptr<const Frame>, ...) which
+     * doesn't allocate memory and doesn't copy frames for real-time sources.
+     * @param frame Frame.
+     * @param timestampUs Frame timestamp (microseconds).
+     * @return TRUE if the frame is put or FALSE if source ID is unknown or
+     * source slots are full.
+     */
+    bool push(const Frame& frame, int64_t timestampUs = 0);
+
+    /**
+     * @brief Put frame to slots of source without copying. Source is defined
+     * by sourceId field of frame.
+     * @param frame Frame. Must not be changed after push.
+     * @param timestampUs Frame timestamp (microseconds).
+     * @return TRUE if the frame is put or FALSE if frame is nullptr, source
+     * ID is unknown or source slots are full.
+     */
+    bool push(std::shared_ptr<const Frame> frame, int64_t timestampUs = 0);
+
+    /**
+     * @brief Get next tuple (doesn't wait). Must be called by one thread.
+     * @param tuple Output tuple. Vectors of tuple are reused.
+     * @return TRUE if the tuple is ready or FALSE if frames are not matched
+     * yet.
+     */
+    bool getTuple(FrameTuple& tuple);
+
+    /**
+     * @brief Get number of sources.
+     * @return Number of sources.
+     */
+    int getSourcesCount() const;
+
+    /**
+     * @brief Get statistics.
+     * @param stats Output statistics.
+     */
+    void getStats(FrameSyncStats& stats) const;
+
+private:
+
+    /// Frame slot.
+    struct Slot
+    {
+        std::shared_ptr<const Frame> frame;
+        /// Matching key.
+        int64_t key{0};
+        /// Frame timestamp (microseconds).
+        int64_t timestampUs{0};
+        /// Time of push.
+        std::chrono::steady_clock::time_point arrival;
+    };
+
+    /// Single producer single consumer ring of slots.
+    struct Source
+    {
+        int sourceId{0};
+        std::vector<Slot> slots;
+        /// Index of next slot to read (written by consumer).
+        alignas(64) std::atomic<uint64_t> head{0};
+        /// Index of next slot to write (written by producer).
+        alignas(64) std::atomic<uint64_t> tail{0};
+        /// Number of frames rejected because slots are full.
+        std::atomic<uint64_t> overflow{0};
+    };
+
+    /// Get slot of source by position from head or nullptr if slot is empty.
+    Slot* getSlot(int source, uint64_t position);
+    /// Start new tuple.
+    void begin(FrameTuple& tuple);
+    /// Take head frame of source to tuple.
+    void take(int source, FrameTuple& tuple);
+    /// Drop head frame of source.
+    void drop(int source);
+    /// Finish tuple: update statistics.
+    void finish(FrameTuple& tuple, bool isComplete);
+
+    /// Sources.
+    std::vector<std::unique_ptr<Source>> m_sources;
+    /// Matching key.
+    SyncKey m_key{SyncKey::FRAME_ID};
+    /// Tolerance of timestamps (microseconds).
+    int64_t m_toleranceUs{0};
+    /// Missing frames policy.
+    SyncPolicy m_missingPolicy{SyncPolicy::DROP};
+    /// Maximum time to wait for missing frames (microseconds).
+    int64_t m_maxWaitUs{0};
+    /// Late frames policy.
+    SyncPolicy m_latePolicy{SyncPolicy::DROP};
+    /// Key of last returned tuple (minimum key of its frames).
+    int64_t m_lastKey{0};
+    /// Flag of returned tuple.
+    bool m_hasLastKey{false};
+    /// Minimum key of frames of current tuple.
+    int64_t m_tupleKey{0};
+    /// Earliest arrival of frames of current tuple.
+    std::chrono::steady_clock::time_point m_firstArrival;
+    /// Statistics (updated by consumer).
+    std::atomic<uint64_t> m_tuples{0};
+    std::atomic<uint64_t> m_partialTuples{0};
+    std::atomic<uint64_t> m_dropped{0};
+    std::atomic<uint64_t> m_late{0};
+    std::atomic<int64_t> m_totalLatencyUs{0};
+    std::atomic<int64_t> m_maxLatencyUs{0};
+};
+}
+}
@@ -0,0 +1,241 @@
+#include <cmath>
+#include <cstring>
+#include "FrameTemporal.h"
+#include "FrameCompute.h"
+#include "FrameKernels.h"
+#include "FrameLut.h"
+#include "FramePlane.h"
+
+
+
+// Link namespaces.
+using namespace std;
+using namespace cr::video;
+using namespace cr::video::kernels;
+
+
+
+namespace
+{
+
+/// Number of data bytes processed by one task of temporal mean and median.
+const int g_chunkSize = 4096;
+
+
+
+/// Get plane with 1 byte elements.
+bool getBytePlane(const Frame& frame, int plane, FramePlane& result)
+{
+    FramePlane planes[3];
+    int count = getPlanes(frame, planes);
+    if (plane < 0 || plane >= count || planes[plane].elementSize != 1)
+        return false;
+    result = planes[plane];
+    return true;
+}
+
+
+
+/// Check frames for temporal functions.
+bool checkFrames(const Frame* const frames[], int count, int maxCount, const Frame& dst)
+{
+    if (frames == nullptr || count < 1 || count > maxCount)
+        return false;
+    for (int i = 0; i < count; ++i)
+    {
+        const Frame* frame = frames[i];
+        if (frame == nullptr || frame == &dst || frame->data == nullptr ||
+            frame->width != frames[0]->width || frame->height != frames[0]->height ||
+            frame->fourcc != frames[0]->fourcc || getSampleBits(frame->fourcc) != 8 ||
+            frame->size < getDataSize(frame->fourcc, frame->width, frame->height))
+            return false;
+    }
+    return true;
+}
+
+
+
+/// Process frames data by chunks in parallel.
+template <typename Kernel>
+bool processFrames(const Frame* const frames[], int count, Frame& dst, Kernel kernel)
+{
+    const Frame& first = *frames[0];
+    if (!prepareFrame(dst, first.width, first.height, first.fourcc))
+        return false;
+    dst.frameId = frames[count - 1]->frameId;
+    dst.sourceId = frames[count - 1]->sourceId;
+
+    const int64_t size = dst.size;
+    parallelFor((int)((size + g_chunkSize - 1) / g_chunkSize), 16, [&](int begin, int end)
+    {
+        const uint8_t* rows[257];
+        for (int chunk = begin; chunk < end; ++chunk)
+        {
+            int64_t offset = (int64_t)chunk * g_chunkSize;
+            for (int i = 0; i < count; ++i)
+                rows[i] = &frames[i]->data[offset];
+            kernel(rows, count, size - offset < g_chunkSize ? (int)(size - offset) : g_chunkSize,
+                   &dst.data[offset]);
+        }
+    });
+
+    return true;
+}
+}
+
+
+
+bool FrameAccumulator::update(const Frame& frame, float alpha, int plane)
+{
+    return process(frame, alpha, 0, nullptr, plane);
+}
+
+
+
+bool FrameAccumulator::update(const Frame& frame, float alpha, int threshold,
+                              Frame& mask, int plane)
+{
+    return process(frame, alpha, threshold, &mask, plane);
+}
+
+
+
+bool FrameAccumulator::getAverage(Frame& dst) const
+{
+    if (m_data.empty() || !prepareFrame(dst, m_width, m_height, Fourcc::GRAY))
+        return false;
+    for (size_t i = 0; i < m_data.size(); ++i)
+        dst.data[i] = (uint8_t)((m_data[i] + 128) >> 8);
+    return true;
+}
+
+
+
+const uint16_t* FrameAccumulator::getData() const
+{
+    return m_data.empty() ? nullptr : m_data.data();
+}
+
+
+
+int FrameAccumulator::getWidth() const
+{
+    return m_width;
+}
+
+
+
+int FrameAccumulator::getHeight() const
+{
+    return m_height;
+}
+
+
+
+void FrameAccumulator::reset()
+{
+    m_data.clear();
+    m_width = 0;
+    m_height = 0;
+}
+
+
+
+bool FrameAccumulator::process(const Frame& frame, float alpha, int threshold,
+                               Frame* mask, int plane)
+{
+    // Check params.
+    FramePlane source;
+    if (!(alpha > 0.0f && alpha <= 1.0f) || threshold < 0 || threshold > 255 ||
+        mask == &frame || !getBytePlane(frame, plane, source))
+        return false;
+    if (mask != nullptr)
+    {
+        if (!prepareFrame(*mask, source.width, source.height, Fourcc::GRAY))
+            return false;
+        mask->frameId = frame.frameId;
+        mask->sourceId = frame.sourceId;
+    }
+
+    // First frame initializes average.
+    const int w = source.width;
+    if (m_data.empty() || m_width != source.width || m_height != source.height)
+    {
+        m_width = source.width;
+        m_height = source.height;
+        m_data.resize((size_t)m_width * m_height);
+        for (int y = 0; y < m_height; ++y)
+        {
+            const uint8_t* src = &source.data[(size_t)y * source.stride];
+            uint16_t* acc = &m_data[(size_t)y * w];
+            for (int x = 0; x < w; ++x)
+                acc[x] = (uint16_t)(src[x] << 8);
+        }
+        if (mask != nullptr)
+            memset(mask->data, 0, mask->size);
+        return true;
+    }
+
+    // Update average.
+    int weight = (int)lround(alpha * 65536.0f);
+    weight = weight < 1 ? 1 : (weight > 65535 ? 65535 : weight);
+    const KernelTable& table = getTable();
+    parallelFor(m_height, 16, [&](int begin, int end)
+    {
+        for (int y = begin; y < end; ++y)
+            table.accumulateRow(&source.data[(size_t)y * source.stride],
+                                &m_data[(size_t)y * w], weight, threshold,
+                                mask != nullptr ? &mask->data[(size_t)y * w] : nullptr, w);
+    });
+
+    return true;
+}
+
+
+
+bool cr::video::frameDifference(const Frame& a, const Frame& b, int threshold,
+                                Frame& mask, int plane)
+{
+    // Check params.
+    FramePlane first;
+    FramePlane second;
+    if (threshold < 0 || threshold > 255 || &mask == &a || &mask == &b ||
+        a.width != b.width || a.height != b.height || a.fourcc != b.fourcc ||
+        !getBytePlane(a, plane, first) || !getBytePlane(b, plane, second) ||
+        !prepareFrame(mask, first.width, first.height, Fourcc::GRAY))
+        return false;
+    mask.frameId = b.frameId;
+    mask.sourceId = b.sourceId;
+
+    const KernelTable& table = getTable();
+    const int w = first.width;
+    parallelFor(first.height, 16, [&](int begin, int end)
+    {
+        for (int y = begin; y < end; ++y)
+            table.differenceRow(&first.data[(size_t)y * first.stride],
+                                &second.data[(size_t)y * second.stride], threshold,
+                                &mask.data[(size_t)y * w], w);
+    });
+
+    return true;
+}
+
+
+
+bool cr::video::temporalMean(const Frame* const frames[], int count, Frame& dst)
+{
+    if (!checkFrames(frames, count, 257, dst))
+        return false;
+    const KernelTable& table = getTable();
+    return processFrames(frames, count, dst, table.meanRow);
+}
+
+
+
+bool cr::video::temporalMedian(const Frame* const frames[], int count, Frame& dst)
+{
+    if (!checkFrames(frames, count, 16, dst))
+        return false;
+    const KernelTable& table = getTable();
+    return processFrames(frames, count, dst, table.medianRow);
+}
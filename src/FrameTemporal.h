@@ -0,0 +1,131 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Frame.h"
+
+
+
+namespace cr
+{
+namespace video
+{
+
+/**
+ * @brief Exponential running average (background model) of frame plane.
+ * Average is stored in 16-bit accumulator (8.8 fixed point format). Reading
+ * new frame, foreground mask calculation and average update are done in one
+ * pass by SIMD kernels and library thread pool (see FrameCompute.h).
+ * Supported planes: planes with 1 byte elements (GRAY, 8 bit Bayer, luma
+ * of NV12 and NV21, all planes of YU12 and YV12).
+ */
+class FrameAccumulator
+{
+public:
+
+    /**
+     * @brief Update average: average = average + (frame - average) * alpha
+     * with change rounded away from zero in 8.8 fixed point format (average
+     * reaches value of constant frame for any alpha). First frame (or frame of other size) initializes average.
+     * @param frame Source frame.
+     * @param alpha Weight of frame (0, 1].
+     * @param plane Plane index (see FramePlane.h).
+     * @return TRUE if the average is updated or FALSE if parameters not valid.
+     */
+    bool update(const Frame& frame, float alpha, int plane = 0);
+
+    /**
+     * @brief Get foreground mask and update average (background model).
+     * Mask value is 255 if |frame - average| > threshold (average before
+     * update) or 0 if not. Mask of first frame is empty.
+     * @param frame Source frame.
+     * @param alpha Weight of frame (0, 1].
+     * @param threshold Threshold [0, 255].
+     * @param mask Output GRAY mask with plane size.
+     * @param plane Plane index (see FramePlane.h).
+     * @return TRUE if the mask is calculated or FALSE if parameters not valid.
+     */
+    bool update(const Frame& frame, float alpha, int threshold, Frame& mask,
+                int plane = 0);
+
+    /**
+     * @brief Get average as GRAY frame (rounded to nearest).
+     * @param dst Output frame.
+     * @return TRUE if the frame is ready or FALSE if average is empty.
+     */
+    bool getAverage(Frame& dst) const;
+
+    /**
+     * @brief Get accumulator data (8.8 fixed point format, width * height
+     * values).
+     * @return Pointer to accumulator data or nullptr if average is empty.
+     */
+    const uint16_t* getData() const;
+
+    /**
+     * @brief Get accumulator width.
+     * @return Width (elements).
+     */
+    int getWidth() const;
+
+    /**
+     * @brief Get accumulator height.
+     * @return Height (rows).
+     */
+    int getHeight() const;
+
+    /**
+     * @brief Reset average. Next frame initializes average.
+     */
+    void reset();
+
+private:
+
+    /// Update average with optional mask.
+    bool process(const Frame& frame, float alpha, int threshold, Frame* mask,
+                 int plane);
+
+    /// Accumulator.
+    std::vector<uint16_t> m_data;
+    /// Accumulator size.
+    int m_width{0};
+    int m_height{0};
+};
+
+
+
+/**
+ * @brief Thresholded absolute difference of frame planes (frame
+ * differencing). Mask value is 255 if |a - b| > threshold or 0 if not.
+ * Supported planes are the same as for FrameAccumulator.
+ * @param a First frame.
+ * @param b Second frame with the same size and pixel format.
+ * @param threshold Threshold [0, 255].
+ * @param mask Output GRAY mask with plane size.
+ * @param plane Plane index (see FramePlane.h).
+ * @return TRUE if the mask is calculated or FALSE if parameters not valid.
+ */
+bool frameDifference(const Frame& a, const Frame& b, int threshold, Frame& mask,
+                     int plane = 0);
+
+/**
+ * @brief Temporal mean of frames (all data bytes, rounded to nearest).
+ * @param frames Pointers to frames with the same size and pixel format.
+ * Supported: raw formats with 8 bit samples.
+ * @param count Number of frames [1, 257].
+ * @param dst Output frame. Frame ID and source ID are copied from last frame.
+ * @return TRUE if the frame is calculated or FALSE if parameters not valid.
+ */
+bool temporalMean(const Frame* const frames[], int count, Frame& dst);
+
+/**
+ * @brief Temporal median of frames (all data bytes). For even number of
+ * frames result is rounded up average of two middle values.
+ * @param frames Pointers to frames with the same size and pixel format.
+ * Supported: raw formats with 8 bit samples.
+ * @param count Number of frames [1, 16].
+ * @param dst Output frame. Frame ID and source ID are copied from last frame.
+ * @return TRUE if the frame is calculated or FALSE if parameters not valid.
+ */
+bool temporalMedian(const Frame* const frames[], int count, Frame& dst);
+}
+}
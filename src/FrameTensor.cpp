@@ -0,0 +1,304 @@
+#include <climits>
+#include <vector>
+#include "FrameTensor.h"
+#include "FrameBayer.h"
+#include "FrameCompute.h"
+#include "FrameKernels.h"
+
+
+
+// Link namespaces.
+using namespace std;
+using namespace cr::video;
+using namespace cr::video::kernels;
+
+
+
+namespace
+{
+
+/// Number of tensor rows processed by one task in batch mode.
+const int g_batchRows = 32;
+
+
+
+/// Conversion job for one frame.
+struct TensorJob
+{
+    /// Source frame.
+    const Frame* frame{nullptr};
+    /// Demosaiced Bayer source frame.
+    Frame rgb;
+    /// Tensor slot.
+    uint8_t* tensor{nullptr};
+    /// ROI.
+    int roiX{0};
+    int roiY{0};
+    int roiWidth{0};
+    int roiHeight{0};
+    /// Tensor size.
+    int width{0};
+    int height{0};
+    /// Source pixel index and weight (8 bit) for every tensor column.
+    vector<int> xIndex;
+    vector<int> xWeight;
+};
+
+
+
+/// Scratch buffers of processRows(...).
+struct TensorScratch
+{
+    vector<uint8_t> rgb;
+    vector<uint16_t> scaled;
+    vector<uint8_t> row;
+};
+
+/// Scratch buffers of current thread.
+thread_local TensorScratch t_scratch;
+
+
+
+/// Source position (8.8 fixed point) of destination pixel center.
+inline int sourcePosition(int dst, int srcSize, int dstSize)
+{
+    int64_t pos = (int64_t)(2 * dst + 1) * srcSize * 128 / dstSize - 128;
+    if (pos < 0)
+        pos = 0;
+    if (pos > (int64_t)(srcSize - 1) * 256)
+        pos = (int64_t)(srcSize - 1) * 256;
+    return (int)pos;
+}
+
+
+
+/// Check params and prepare job.
+bool prepareJob(const Frame& frame, const TensorParams& params, TensorJob& job)
+{
+    // Check frame.
+    if (frame.data == nullptr || (!isRgbReadable(frame.fourcc) && !isBayer(frame.fourcc)) ||
+        frame.width <= 0 || frame.height <= 0 ||
+        (isBayer(frame.fourcc) && (frame.width < 4 || frame.height < 4)) ||
+        frame.size < getDataSize(frame.fourcc, frame.width, frame.height))
+        return false;
+
+    // Check ROI.
+    job.frame = &frame;
+    job.roiX = params.roiX;
+    job.roiY = params.roiY;
+    job.roiWidth = params.roiWidth > 0 ? params.roiWidth : frame.width - params.roiX;
+    job.roiHeight = params.roiHeight > 0 ? params.roiHeight : frame.height - params.roiY;
+    if (job.roiX < 0 || job.roiY < 0 || job.roiWidth <= 0 || job.roiHeight <= 0 ||
+        job.roiX + job.roiWidth > frame.width ||
+        job.roiY + job.roiHeight > frame.height)
+        return false;
+
+    // Check tensor size.
+    job.width = params.width > 0 ? params.width : job.roiWidth;
+    job.height = params.height > 0 ? params.height : job.roiHeight;
+    if (params.width < 0 || params.height < 0 ||
+        (int64_t)job.width * job.height * 3 > INT_MAX)
+        return false;
+
+    // Check normalization.
+    for (int c = 0; c < 3; ++c)
+        if (params.std[c] == 0.0f)
+            return false;
+
+    // Horizontal interpolation table.
+    job.xIndex.resize(job.width);
+    job.xWeight.resize(job.width);
+    for (int x = 0; x < job.width; ++x)
+    {
+        int pos = sourcePosition(x, job.roiWidth, job.width);
+        job.xIndex[x] = pos >> 8;
+        job.xWeight[x] = pos & 255;
+    }
+
+    return true;
+}
+
+
+
+/// Demosaic Bayer source of job: rows are read from RGB24 frame.
+bool prepareSource(TensorJob& job)
+{
+    if (!isBayer(job.frame->fourcc))
+        return true;
+    if (!demosaic(*job.frame, job.rgb, Fourcc::RGB24))
+        return false;
+    job.frame = &job.rgb;
+    return true;
+}
+
+
+
+/// Convert tensor rows [begin, end) of job.
+void processRows(const TensorJob& job, const TensorParams& params, int begin, int end)
+{
+    const KernelTable& table = getTable();
+    const int w = job.width;
+    const int h = job.height;
+    const bool isHalf = params.type == TensorType::FLOAT16;
+    const size_t elementSize = isHalf ? 2 : 4;
+
+    // Tensor channel to RGB channel.
+    int channels[3] = {0, 1, 2};
+    if (params.order == ChannelOrder::BGR)
+    {
+        channels[0] = 2;
+        channels[2] = 0;
+    }
+
+    // Linear transformation of 8.8 fixed point values per tensor channel.
+    float scales[3];
+    float offsets[3];
+    for (int c = 0; c < 3; ++c)
+    {
+        scales[c] = params.scale / (256.0f * params.std[c]);
+        offsets[c] = -params.mean[c] / params.std[c];
+    }
+
+    // Buffers of thread are reused by following bands and frames: source RGB
+    // row (3 planes padded for resampleRow(...)), two horizontally scaled
+    // rows (3 channels each) and output row for interleaved layout.
+    TensorScratch& scratch = t_scratch;
+    const size_t planeSize = (size_t)job.roiWidth + 4;
+    if (scratch.rgb.size() < 3 * planeSize)
+        scratch.rgb.resize(3 * planeSize, 0);
+    if (scratch.scaled.size() < 2 * 3 * (size_t)w)
+        scratch.scaled.resize(2 * 3 * (size_t)w);
+    if (params.layout == TensorLayout::HWC && scratch.row.size() < 3 * w * elementSize)
+        scratch.row.resize(3 * w * elementSize);
+    uint8_t* const src[3] = {&scratch.rgb[0], &scratch.rgb[planeSize],
+                             &scratch.rgb[2 * planeSize]};
+    uint16_t* const scaled = scratch.scaled.data();
+    uint8_t* const row = scratch.row.data();
+    int scaledY[2] = {INT_MIN, INT_MIN};
+
+    // Function to get horizontally scaled source row.
+    auto getScaled = [&](int y) -> const uint16_t*
+    {
+        uint16_t* dst = &scaled[(y & 1) * 3 * w];
+        if (scaledY[y & 1] == y)
+            return dst;
+
+        readRgbRow(*job.frame, job.roiY + y, job.roiX, job.roiWidth, src[0], src[1], src[2]);
+        for (int c = 0; c < 3; ++c)
+            table.resampleRow(src[c], job.xIndex.data(), job.xWeight.data(), w, &dst[c * w]);
+
+        scaledY[y & 1] = y;
+        return dst;
+    };
+
+    for (int y = begin; y < end; ++y)
+    {
+        int pos = sourcePosition(y, job.roiHeight, h);
+        int y0 = pos >> 8;
+        int weight = pos & 255;
+        int y1 = y0 + 1 < job.roiHeight ? y0 + 1 : y0;
+        const uint16_t* top = getScaled(y0);
+        const uint16_t* bottom = getScaled(y1);
+
+        for (int c = 0; c < 3; ++c)
+        {
+            const uint16_t* t = &top[channels[c] * w];
+            const uint16_t* b = &bottom[channels[c] * w];
+
+            // Planar layout: write directly to tensor.
+            uint8_t* dst = nullptr;
+            if (params.layout == TensorLayout::CHW)
+                dst = &job.tensor[((size_t)c * h + y) * w * elementSize];
+            else
+                dst = &row[(size_t)c * w * elementSize];
+
+            if (isHalf)
+                table.tensorRowHalf(t, b, weight, w, scales[c], offsets[c], (uint16_t*)dst);
+            else
+                table.tensorRow(t, b, weight, w, scales[c], offsets[c], (float*)dst);
+        }
+
+        // Interleave channels.
+        if (params.layout == TensorLayout::HWC)
+        {
+            uint8_t* dst = &job.tensor[(size_t)y * w * 3 * elementSize];
+            for (int c = 0; c < 3; ++c)
+            {
+                const uint8_t* channel = &row[(size_t)c * w * elementSize];
+                for (int x = 0; x < w; ++x)
+                    memcpy(&dst[(3 * x + c) * elementSize], &channel[x * elementSize], elementSize);
+            }
+        }
+    }
+}
+}
+
+
+
+size_t cr::video::getTensorSize(const Frame& frame, const TensorParams& params)
+{
+    TensorJob job;
+    if (!prepareJob(frame, params, job))
+        return 0;
+    size_t elementSize = params.type == TensorType::FLOAT16 ? 2 : 4;
+    return (size_t)job.width * job.height * 3 * elementSize;
+}
+
+
+
+bool cr::video::frameToTensor(const Frame& frame, void* tensor, const TensorParams& params)
+{
+    // Check params.
+    TensorJob job;
+    if (tensor == nullptr || !prepareJob(frame, params, job) || !prepareSource(job))
+        return false;
+    job.tensor = (uint8_t*)tensor;
+
+    parallelFor(job.height, 16, [&](int begin, int end)
+    {
+        processRows(job, params, begin, end);
+    });
+
+    return true;
+}
+
+
+
+bool cr::video::framesToTensor(const Frame* const frames[], int count,
+                               void* tensor, const TensorParams& params)
+{
+    // Check params.
+    if (frames == nullptr || count <= 0 || tensor == nullptr ||
+        params.width <= 0 || params.height <= 0)
+        return false;
+
+    // Prepare jobs for all frames.
+    size_t elementSize = params.type == TensorType::FLOAT16 ? 2 : 4;
+    size_t slotSize = (size_t)params.width * params.height * 3 * elementSize;
+    vector<TensorJob> jobs(count);
+    for (int i = 0; i < count; ++i)
+    {
+        if (frames[i] == nullptr || !prepareJob(*frames[i], params, jobs[i]))
+            return false;
+        jobs[i].tensor = (uint8_t*)tensor + slotSize * i;
+    }
+    for (int i = 0; i < count; ++i)
+        if (!prepareSource(jobs[i]))
+            return false;
+
+    // Process bands of rows of all frames in parallel.
+    const int bands = (params.height + g_batchRows - 1) / g_batchRows;
+    parallelFor(count * bands, 1, [&](int begin, int end)
+    {
+        for (int i = begin; i < end; ++i)
+        {
+            const TensorJob& job = jobs[i / bands];
+            int band = i % bands;
+            processRows(job, params,
+                        (int)((int64_t)job.height * band / bands),
+                        (int)((int64_t)job.height * (band + 1) / bands));
+        }
+    });
+
+    return true;
+}
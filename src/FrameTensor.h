@@ -0,0 +1,122 @@
+#pragma once
+#include <cstddef>
+#include "Frame.h"
+
+
+
+namespace cr
+{
+namespace video
+{
+
+/**
+ * @brief Tensor memory layouts.
+ */
+enum class TensorLayout
+{
+    /// Planar layout: channel planes one after another.
+    CHW = 0,
+    /// Interleaved layout: channels of pixel one after another.
+    HWC = 1
+};
+
+
+
+/**
+ * @brief Tensor element types.
+ */
+enum class TensorType
+{
+    /// 32bit float.
+    FLOAT32 = 0,
+    /// 16bit half precision float (IEEE 754 binary16).
+    FLOAT16 = 1
+};
+
+
+
+/**
+ * @brief Order of tensor channels.
+ */
+enum class ChannelOrder
+{
+    /// Red, green, blue.
+    RGB = 0,
+    /// Blue, green, red.
+    BGR = 1
+};
+
+
+
+/**
+ * @brief Parameters of frame to tensor conversion. Tensor value for channel
+ * c: (pixel * scale - mean[c]) / std[c].
+ */
+struct TensorParams
+{
+    /// Tensor width (pixels). 0 - width of ROI.
+    int width{0};
+    /// Tensor height (pixels). 0 - height of ROI.
+    int height{0};
+    /// ROI top-left corner horizontal position (pixels).
+    int roiX{0};
+    /// ROI top-left corner vertical position (pixels).
+    int roiY{0};
+    /// ROI width (pixels). 0 - frame width.
+    int roiWidth{0};
+    /// ROI height (pixels). 0 - frame height.
+    int roiHeight{0};
+    /// Tensor memory layout.
+    TensorLayout layout{TensorLayout::CHW};
+    /// Tensor element type.
+    TensorType type{TensorType::FLOAT32};
+    /// Order of tensor channels.
+    ChannelOrder order{ChannelOrder::RGB};
+    /// Scale of pixel values [0, 255] before normalization.
+    float scale{1.0f / 255.0f};
+    /// Mean values of tensor channels.
+    float mean[3]{0.0f, 0.0f, 0.0f};
+    /// Standard deviations of tensor channels.
+    float std[3]{1.0f, 1.0f, 1.0f};
+};
+
+
+
+/**
+ * @brief Get size of tensor for one frame.
+ * @param frame Source frame.
+ * @param params Conversion parameters.
+ * @return Tensor size (bytes) or 0 if parameters are not valid.
+ */
+size_t getTensorSize(const Frame& frame, const TensorParams& params);
+
+/**
+ * @brief Convert frame to normalized 3 channels tensor. ROI scaling (bilinear),
+ * color conversion (BT.601 for YUV formats) and normalization are done in
+ * one pass by SIMD kernels and library thread pool (see FrameCompute.h).
+ * @param frame Source frame. Supported pixel formats: RGB24, BGR24, YUV24,
+ * GRAY, YUYV, UYVY, NV12, NV21, YU12, YV12 and Bayer formats. Bayer frames
+ * (width and height >= 4) are demosaiced (bilinear) to temporary RGB24 frame
+ * first.
+ * @param tensor Pointer to tensor buffer. Buffer size must be >=
+ * getTensorSize(frame, params).
+ * @param params Conversion parameters.
+ * @return TRUE if the frame converted or FALSE if not.
+ */
+bool frameToTensor(const Frame& frame, void* tensor, const TensorParams& params);
+
+/**
+ * @brief Convert frames to batch tensor (NCHW or NHWC). Frames are processed
+ * in parallel. Frames can have different size and pixel formats.
+ * @param frames Pointers to source frames.
+ * @param count Number of frames.
+ * @param tensor Pointer to batch tensor buffer. Frame with index i is
+ * written to slot i. Buffer size must be >= count * slot size.
+ * @param params Conversion parameters. Tensor width and height must be set.
+ * @return TRUE if all frames converted or FALSE if not. Function doesn't
+ * convert any frame if parameters are not valid for one of them.
+ */
+bool framesToTensor(const Frame* const frames[], int count, void* tensor,
+                    const TensorParams& params);
+}
+}
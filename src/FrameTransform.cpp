@@ -0,0 +1,423 @@
+#include <algorithm>
+#include <vector>
+#include "FrameTransform.h"
+#include "FrameCompute.h"
+#include "FrameKernels.h"
+#include "FramePlane.h"
+
+
+
+// Link namespaces.
+using namespace std;
+using namespace cr::video;
+using namespace cr::video::kernels;
+
+
+
+namespace
+{
+
+/// Tile size (elements) of transposition.
+const int g_tile = 64;
+
+
+
+/// Check if transformation swaps width and height.
+inline bool isTransposing(FrameTransform transform)
+{
+    return transform == FrameTransform::ROTATE_90 ||
+           transform == FrameTransform::ROTATE_270 ||
+           transform == FrameTransform::TRANSPOSE;
+}
+
+
+
+/// Get source pixel of destination pixel (x, y). Source frame has size w x h.
+inline void sourcePixel(FrameTransform transform, int w, int h, int x, int y,
+                        int& sx, int& sy)
+{
+    switch (transform)
+    {
+    case FrameTransform::ROTATE_90:
+        sx = y;
+        sy = h - 1 - x;
+        break;
+    case FrameTransform::ROTATE_180:
+        sx = w - 1 - x;
+        sy = h - 1 - y;
+        break;
+    case FrameTransform::ROTATE_270:
+        sx = w - 1 - y;
+        sy = x;
+        break;
+    case FrameTransform::FLIP_HORIZONTAL:
+        sx = w - 1 - x;
+        sy = y;
+        break;
+    case FrameTransform::FLIP_VERTICAL:
+        sx = x;
+        sy = h - 1 - y;
+        break;
+    default:
+        sx = y;
+        sy = x;
+        break;
+    }
+}
+
+
+
+/// Get colors of 2x2 Bayer cell (row by row) or nullptr if not Bayer format.
+const char* getBayerCell(Fourcc fourcc)
+{
+    switch (fourcc)
+    {
+    case Fourcc::RGGB8:
+    case Fourcc::RGGB16:
+        return "RGGB";
+    case Fourcc::BGGR8:
+    case Fourcc::BGGR16:
+        return "BGGR";
+    case Fourcc::GRBG8:
+    case Fourcc::GRBG16:
+        return "GRBG";
+    case Fourcc::GBRG8:
+    case Fourcc::GBRG16:
+        return "GBRG";
+    default:
+        return nullptr;
+    }
+}
+
+
+
+/// Get pixel format of transformed frame.
+Fourcc getOutputFourcc(Fourcc fourcc, FrameTransform transform)
+{
+    const char* cell = getBayerCell(fourcc);
+    if (cell == nullptr)
+        return fourcc;
+
+    // Transform 2x2 cell (frame size is even so parity is the same).
+    char dst[4] = {0, 0, 0, 0};
+    for (int y = 0; y < 2; ++y)
+    {
+        for (int x = 0; x < 2; ++x)
+        {
+            int sx = 0;
+            int sy = 0;
+            sourcePixel(transform, 2, 2, x, y, sx, sy);
+            dst[y * 2 + x] = cell[sy * 2 + sx];
+        }
+    }
+
+    const bool is16bit = fourcc == Fourcc::RGGB16 || fourcc == Fourcc::BGGR16 ||
+                         fourcc == Fourcc::GRBG16 || fourcc == Fourcc::GBRG16;
+    if (memcmp(dst, "RGGB", 4) == 0)
+        return is16bit ? Fourcc::RGGB16 : Fourcc::RGGB8;
+    if (memcmp(dst, "BGGR", 4) == 0)
+        return is16bit ? Fourcc::BGGR16 : Fourcc::BGGR8;
+    if (memcmp(dst, "GRBG", 4) == 0)
+        return is16bit ? Fourcc::GRBG16 : Fourcc::GRBG8;
+    return is16bit ? Fourcc::GBRG16 : Fourcc::GBRG8;
+}
+
+
+
+/// Check frame and transformation.
+bool checkFrame(const Frame& frame, FrameTransform transform)
+{
+    const int w = frame.width;
+    const int h = frame.height;
+    int64_t dataSize = getDataSize(frame.fourcc, w, h);
+    if (frame.data == nullptr || w <= 0 || h <= 0 || dataSize == 0 ||
+        frame.size < dataSize || (int)transform < 0 || (int)transform > 5)
+        return false;
+
+    switch (frame.fourcc)
+    {
+    case Fourcc::YUYV:
+    case Fourcc::UYVY:
+        return w % 2 == 0 && (!isTransposing(transform) || h % 2 == 0);
+    case Fourcc::NV12:
+    case Fourcc::NV21:
+    case Fourcc::YU12:
+    case Fourcc::YV12:
+        return w % 2 == 0 && h % 2 == 0;
+    default:
+        return getBayerCell(frame.fourcc) == nullptr || (w % 2 == 0 && h % 2 == 0);
+    }
+}
+
+
+
+/// Get planes of frame. YUYV and UYVY plane consists of 4 bytes macropixels.
+int getTransformPlanes(const Frame& frame, FramePlane planes[3])
+{
+    int count = getPlanes(frame, planes);
+    if (frame.fourcc == Fourcc::YUYV || frame.fourcc == Fourcc::UYVY)
+    {
+        planes[0].width /= 2;
+        planes[0].elementSize = 4;
+    }
+    return count;
+}
+
+
+
+/// Copy row in reverse order of elements. Luma samples of YUYV and UYVY
+/// macropixels (positions lumaPos and lumaPos + 2) are swapped.
+void reverseRow(const KernelTable& table, const uint8_t* src, uint8_t* dst,
+                int width, int elementSize, int lumaPos)
+{
+    switch (elementSize)
+    {
+    case 1:
+        table.reverse8(src, dst, width);
+        break;
+    case 2:
+        table.reverse16(src, dst, width);
+        break;
+    case 3:
+        for (int x = 0; x < width; ++x)
+            memcpy(&dst[x * 3], &src[(width - 1 - x) * 3], 3);
+        break;
+    default:
+        for (int x = 0; x < width; ++x)
+        {
+            const uint8_t* s = &src[(width - 1 - x) * 4];
+            uint8_t* d = &dst[x * 4];
+            d[lumaPos] = s[lumaPos + 2];
+            d[lumaPos ^ 1] = s[lumaPos ^ 1];
+            d[lumaPos + 2] = s[lumaPos];
+            d[(lumaPos ^ 1) + 2] = s[(lumaPos ^ 1) + 2];
+        }
+        break;
+    }
+}
+
+
+
+/// Flip or rotate by 180 degrees plane. Rows are processed by pairs (row and
+/// its mirror) so source and destination can be the same plane.
+void transformRows(const FramePlane& src, const FramePlane& dst,
+                   FrameTransform transform, int lumaPos)
+{
+    const KernelTable& table = getTable();
+    const bool flipRows = transform != FrameTransform::FLIP_HORIZONTAL;
+    const bool flipColumns = transform != FrameTransform::FLIP_VERTICAL;
+    const bool inPlace = src.data == dst.data;
+    const int h = src.height;
+    const size_t rowSize = (size_t)src.width * src.elementSize;
+    const int count = flipRows ? (h + 1) / 2 : h;
+
+    // Function to copy row.
+    auto copyRow = [&](const uint8_t* from, uint8_t* to)
+    {
+        if (flipColumns)
+            reverseRow(table, from, to, src.width, src.elementSize, lumaPos);
+        else
+            memcpy(to, from, rowSize);
+    };
+
+    parallelFor(count, 32, [&](int begin, int end)
+    {
+        vector<uint8_t> buffer(inPlace ? rowSize : 0);
+        for (int a = begin; a < end; ++a)
+        {
+            int b = flipRows ? h - 1 - a : a;
+            const uint8_t* sa = src.data + (size_t)a * src.stride;
+            const uint8_t* sb = src.data + (size_t)b * src.stride;
+            uint8_t* da = dst.data + (size_t)a * dst.stride;
+            uint8_t* db = dst.data + (size_t)b * dst.stride;
+
+            // Middle row of vertical flip in place.
+            if (inPlace && !flipColumns && a == b)
+                continue;
+
+            // Row a goes to row b and row b goes to row a. In place row a
+            // is saved to buffer first.
+            uint8_t* target = inPlace ? buffer.data() : db;
+            copyRow(sa, target);
+            if (a != b)
+                copyRow(sb, da);
+            if (inPlace)
+                memcpy(db, target, rowSize);
+        }
+    });
+}
+
+
+
+/// Transpose tile of 3 bytes elements.
+void transpose24(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst,
+                 ptrdiff_t dstStride, int width, int height)
+{
+    for (int x = 0; x < width; ++x)
+    {
+        uint8_t* d = dst + x * dstStride;
+        for (int y = 0; y < height; ++y)
+            memcpy(&d[y * 3], &src[y * srcStride + x * 3], 3);
+    }
+}
+
+
+
+/// Rotate by 90 or 270 degrees or transpose plane. Rotations are
+/// transpositions with reversed source or destination row order.
+void transposePlane(const FramePlane& src, const FramePlane& dst,
+                    FrameTransform transform)
+{
+    const KernelTable& table = getTable();
+    const int es = src.elementSize;
+    const uint8_t* s = src.data;
+    uint8_t* d = dst.data;
+    ptrdiff_t srcStride = src.stride;
+    ptrdiff_t dstStride = dst.stride;
+    if (transform == FrameTransform::ROTATE_90)
+    {
+        s += (ptrdiff_t)(src.height - 1) * srcStride;
+        srcStride = -srcStride;
+    }
+    else if (transform == FrameTransform::ROTATE_270)
+    {
+        d += (ptrdiff_t)(dst.height - 1) * dstStride;
+        dstStride = -dstStride;
+    }
+
+    // Each task writes band of destination rows (source columns).
+    const int bands = (src.width + g_tile - 1) / g_tile;
+    parallelFor(bands, 1, [&](int begin, int end)
+    {
+        for (int band = begin; band < end; ++band)
+        {
+            int x = band * g_tile;
+            int tileWidth = min(g_tile, src.width - x);
+            for (int y = 0; y < src.height; y += g_tile)
+            {
+                int tileHeight = min(g_tile, src.height - y);
+                const uint8_t* ts = s + y * srcStride + x * es;
+                uint8_t* td = d + x * dstStride + y * es;
+                if (es == 1)
+                    table.transpose8(ts, srcStride, td, dstStride, tileWidth, tileHeight);
+                else if (es == 2)
+                    table.transpose16(ts, srcStride, td, dstStride, tileWidth, tileHeight);
+                else
+                    transpose24(ts, srcStride, td, dstStride, tileWidth, tileHeight);
+            }
+        }
+    });
+}
+
+
+
+/// Rotate by 90 or 270 degrees or transpose YUYV or UYVY frame. Chroma of
+/// output macropixel is average of chroma of two source pixels.
+void transposePacked(const Frame& src, Frame& dst, FrameTransform transform)
+{
+    const int lumaPos = src.fourcc == Fourcc::YUYV ? 0 : 1;
+    const int chromaPos = 1 - lumaPos;
+    const int srcStride = src.width * 2;
+    const int dstStride = dst.width * 2;
+    const int macropixels = dst.width / 2;
+    const int tileMacropixels = g_tile / 2;
+
+    const int bands = (dst.height + g_tile - 1) / g_tile;
+    parallelFor(bands, 1, [&](int begin, int end)
+    {
+        for (int band = begin; band < end; ++band)
+        {
+            int y0 = band * g_tile;
+            int y1 = min(y0 + g_tile, dst.height);
+            for (int k0 = 0; k0 < macropixels; k0 += tileMacropixels)
+            {
+                int k1 = min(k0 + tileMacropixels, macropixels);
+                for (int y = y0; y < y1; ++y)
+                {
+                    uint8_t* d = dst.data + (size_t)y * dstStride;
+                    for (int k = k0; k < k1; ++k)
+                    {
+                        int x0 = 0, sy0 = 0, x1 = 0, sy1 = 0;
+                        sourcePixel(transform, src.width, src.height, 2 * k, y, x0, sy0);
+                        sourcePixel(transform, src.width, src.height, 2 * k + 1, y, x1, sy1);
+                        const uint8_t* r0 = src.data + (size_t)sy0 * srcStride;
+                        const uint8_t* r1 = src.data + (size_t)sy1 * srcStride;
+                        const uint8_t* m0 = &r0[(x0 / 2) * 4];
+                        const uint8_t* m1 = &r1[(x1 / 2) * 4];
+                        uint8_t* m = &d[k * 4];
+                        m[lumaPos] = r0[x0 * 2 + lumaPos];
+                        m[lumaPos + 2] = r1[x1 * 2 + lumaPos];
+                        m[chromaPos] = (uint8_t)((m0[chromaPos] + m1[chromaPos] + 1) >> 1);
+                        m[chromaPos + 2] = (uint8_t)((m0[chromaPos + 2] +
+                                                      m1[chromaPos + 2] + 1) >> 1);
+                    }
+                }
+            }
+        }
+    });
+}
+}
+
+
+
+bool cr::video::transformFrame(const Frame& src, Frame& dst, FrameTransform transform)
+{
+    // Same frame.
+    if (&src == &dst)
+        return transformFrame(dst, transform);
+
+    // Check source frame.
+    if (!checkFrame(src, transform))
+        return false;
+
+    // Prepare output frame.
+    const bool transposing = isTransposing(transform);
+    int width = transposing ? src.height : src.width;
+    int height = transposing ? src.width : src.height;
+    if (!prepareFrame(dst, width, height, getOutputFourcc(src.fourcc, transform)))
+        return false;
+    dst.frameId = src.frameId;
+    dst.sourceId = src.sourceId;
+
+    // Packed YUV with averaging of chroma.
+    if (transposing && (src.fourcc == Fourcc::YUYV || src.fourcc == Fourcc::UYVY))
+    {
+        transposePacked(src, dst, transform);
+        return true;
+    }
+
+    // Transform planes.
+    FramePlane srcPlanes[3];
+    FramePlane dstPlanes[3];
+    int count = getTransformPlanes(src, srcPlanes);
+    getTransformPlanes(dst, dstPlanes);
+    const int lumaPos = src.fourcc == Fourcc::UYVY ? 1 : 0;
+    for (int i = 0; i < count; ++i)
+    {
+        if (transposing)
+            transposePlane(srcPlanes[i], dstPlanes[i], transform);
+        else
+            transformRows(srcPlanes[i], dstPlanes[i], transform, lumaPos);
+    }
+
+    return true;
+}
+
+
+
+bool cr::video::transformFrame(Frame& frame, FrameTransform transform)
+{
+    // Check frame and transformation.
+    if (isTransposing(transform) || !checkFrame(frame, transform))
+        return false;
+    frame.invalidateCache();
+
+    FramePlane planes[3];
+    int count = getTransformPlanes(frame, planes);
+    const int lumaPos = frame.fourcc == Fourcc::UYVY ? 1 : 0;
+    for (int i = 0; i < count; ++i)
+        transformRows(planes[i], planes[i], transform, lumaPos);
+    frame.fourcc = getOutputFourcc(frame.fourcc, transform);
+
+    return true;
+}
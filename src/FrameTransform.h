@@ -0,0 +1,66 @@
+#pragma once
+#include "Frame.h"
+
+
+
+namespace cr
+{
+namespace video
+{
+
+/**
+ * @brief Geometric transformations of frame.
+ */
+enum class FrameTransform
+{
+    /// Rotation by 90 degrees clockwise.
+    ROTATE_90 = 0,
+    /// Rotation by 180 degrees.
+    ROTATE_180 = 1,
+    /// Rotation by 270 degrees clockwise (90 degrees counterclockwise).
+    ROTATE_270 = 2,
+    /// Mirror around vertical axis.
+    FLIP_HORIZONTAL = 3,
+    /// Mirror around horizontal axis.
+    FLIP_VERTICAL = 4,
+    /// Mirror around main diagonal (rows become columns).
+    TRANSPOSE = 5
+};
+
+
+
+/**
+ * @brief Rotate, flip or transpose frame. Planes are processed by cache
+ * sized tiles with SIMD kernels and library thread pool (see FrameCompute.h).
+ * Chroma planes of YUV formats are transformed as planes (chroma pairs of
+ * NV12 and NV21 are kept together). Chroma of YUYV and UYVY is averaged
+ * for two pixels of macropixel when frame is rotated by 90 or 270 degrees
+ * or transposed. Bayer pattern of output frame is changed according to
+ * transformation (for example, horizontal flip of RGGB frame gives GRBG
+ * frame).
+ * @param src Source frame. Supported pixel formats: RGB24, BGR24, YUV24,
+ * GRAY, YUYV, UYVY, NV12, NV21, YU12, YV12 and Bayer formats. Width of YUYV
+ * and UYVY frames must be even (and height for rotation by 90 or 270 degrees
+ * and transposition). Width and height of other YUV 4:2:0 and Bayer frames
+ * must be even.
+ * @param dst Output frame. Memory will be reallocated if output frame has
+ * another size or pixel format. Function copies frame ID and source ID. If
+ * dst is src the frame is transformed in place (only for ROTATE_180,
+ * FLIP_HORIZONTAL and FLIP_VERTICAL).
+ * @param transform Transformation.
+ * @return TRUE if the frame transformed or FALSE if not.
+ */
+bool transformFrame(const Frame& src, Frame& dst, FrameTransform transform);
+
+/**
+ * @brief Transform frame in place without additional frame buffer. Frame
+ * size is kept so only ROTATE_180, FLIP_HORIZONTAL and FLIP_VERTICAL
+ * transformations are supported.
+ * @param frame Frame to transform. Requirements are the same as for
+ * source frame of transformFrame(src, dst, transform).
+ * @param transform Transformation.
+ * @return TRUE if the frame transformed or FALSE if not.
+ */
+bool transformFrame(Frame& frame, FrameTransform transform);
+}
+}
@@ -1,5 +1,32 @@
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <chrono>
 #include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 #include "Frame.h"
+#include "FrameBayer.h"
+#include "FrameCompute.h"
+#include "FrameTensor.h"
+#include "FramePlane.h"
+#include "FrameTransform.h"
+#include "FrameLut.h"
+#include "FrameOverlay.h"
+#include "FrameBatch.h"
+#include "FrameDeserializer.h"
+#include "FrameMosaic.h"
+#include "FramePyramid.h"
+#include "FrameTemporal.h"
+#include "FrameDeinterlace.h"
+#include "FrameNuma.h"
+#include "FrameCounters.h"
+#include "FrameCopy.h"
+#include "FrameGraph.h"
+#include "FrameHash.h"
+#include "FramePreEvent.h"
+#include "FrameSync.h"
 
 
 
@@ -24,6 +51,66 @@ bool compareTest();
 /// Serialization test.
 bool serializationTest();
 
+/// Demosaic test.
+bool demosaicTest();
+
+/// Frame to tensor test.
+bool tensorTest();
+
+/// Rotate, flip and transpose test.
+bool transformTest();
+
+/// Statistics and lookup table test.
+bool lutTest();
+
+/// Overlay test.
+bool overlayTest();
+
+/// Batch serialization test.
+bool batchTest();
+
+/// Stream deserializer test.
+bool deserializerTest();
+
+/// Mosaic test.
+bool mosaicTest();
+
+/// Pyramid test.
+bool pyramidTest();
+
+/// Derived representations cache test.
+bool derivedTest();
+
+/// Temporal kernels test.
+bool temporalTest();
+
+/// Deinterlacing test.
+bool deinterlaceTest();
+
+/// NUMA allocation test.
+bool numaTest();
+
+/// Counters test.
+bool countersTest();
+
+/// Copy engine test.
+bool copyEngineTest();
+
+/// Processing graph test.
+bool graphTest();
+
+/// Large frames test.
+bool largeFrameTest();
+
+/// Content hash test.
+bool hashTest();
+
+/// Pre-event buffer test.
+bool preEventTest();
+
+/// Frame synchronizer test.
+bool synchronizerTest();
+
 
 
 /// Entry point.
@@ -63,6 +150,126 @@ int main(void)
     else
         cout << "OK" << endl << endl;
 
+    cout << "Demosaic test:" << endl;
+    if (!demosaicTest())
+        cout << "ERROR" << endl << endl;
+    else
+        cout << "OK" << endl << endl;
+
+    cout << "Frame to tensor test:" << endl;
+    if (!tensorTest())
+        cout << "ERROR" << endl << endl;
+    else
+        cout << "OK" << endl << endl;
+
+    cout << "Transform test:" << endl;
+    if (!transformTest())
+        cout << "ERROR" << endl << endl;
+    else
+        cout << "OK" << endl << endl;
+
+    cout << "LUT and statistics test:" << endl;
+    if (!lutTest())
+        cout << "ERROR" << endl << endl;
+    else
+        cout << "OK" << endl << endl;
+
+    cout << "Overlay test:" << endl;
+    if (!overlayTest())
+        cout << "ERROR" << endl << endl;
+    else
+        cout << "OK" << endl << endl;
+
+    cout << "Batch test:" << endl;
+    if (!batchTest())
+        cout << "ERROR" << endl << endl;
+    else
+        cout << "OK" << endl << endl;
+
+    cout << "Stream deserializer test:" << endl;
+    if (!deserializerTest())
+        cout << "ERROR" << endl << endl;
+    else
+        cout << "OK" << endl << endl;
+
+    cout << "Mosaic test:" << endl;
+    if (!mosaicTest())
+        cout << "ERROR" << endl << endl;
+    else
+        cout << "OK" << endl << endl;
+
+    cout << "Pyramid test:" << endl;
+    if (!pyramidTest())
+        cout << "ERROR" << endl << endl;
+    else
+        cout << "OK" << endl << endl;
+
+    cout << "Derived representations test:" << endl;
+    if (!derivedTest())
+        cout << "ERROR" << endl << endl;
+    else
+        cout << "OK" << endl << endl;
+
+    cout << "Temporal kernels test:" << endl;
+    if (!temporalTest())
+        cout << "ERROR" << endl << endl;
+    else
+        cout << "OK" << endl << endl;
+
+    cout << "Deinterlacing test:" << endl;
+    if (!deinterlaceTest())
+        cout << "ERROR" << endl << endl;
+    else
+        cout << "OK" << endl << endl;
+
+    cout << "NUMA allocation test:" << endl;
+    if (!numaTest())
+        cout << "ERROR" << endl << endl;
+    else
+        cout << "OK" << endl << endl;
+
+    cout << "Counters test:" << endl;
+    if (!countersTest())
+        cout << "ERROR" << endl << endl;
+    else
+        cout << "OK" << endl << endl;
+
+    cout << "Copy engine test:" << endl;
+    if (!copyEngineTest())
+        cout << "ERROR" << endl << endl;
+    else
+        cout << "OK" << endl << endl;
+
+    cout << "Processing graph test:" << endl;
+    if (!graphTest())
+        cout << "ERROR" << endl << endl;
+    else
+        cout << "OK" << endl << endl;
+
+    cout << "Large frames test:" << endl;
+    if (!largeFrameTest())
+        cout << "ERROR" << endl << endl;
+    else
+        cout << "OK" << endl << endl;
+
+    cout << "Content hash test:" << endl;
+    if (!hashTest())
+        cout << "ERROR" << endl << endl;
+    else
+        cout << "OK" << endl << endl;
+
+    cout << "Pre-event buffer test:" << endl;
+    if (!preEventTest())
+        cout << "ERROR" << endl << endl;
+    else
+        cout << "OK" << endl << endl;
+
+    cout << "Frame synchronizer test:" << endl;
+    if (!synchronizerTest())
+        cout << "ERROR" << endl << endl;
+    else
+        cout << "OK" << endl << endl;
+
     return 1;
 }
 
@@ -511,4 +718,2753 @@ bool serializationTest()
     }
 
     return true;
-}
\ No newline at end of file
+}
+
+
+
+/// Demosaic test.
+bool demosaicTest()
+{
+    // Bayer formats to check.
+    Fourcc formats[8] = {Fourcc::RGGB8, Fourcc::BGGR8, Fourcc::GRBG8,
+                         Fourcc::GBRG8, Fourcc::RGGB16, Fourcc::BGGR16,
+                         Fourcc::GRBG16, Fourcc::GBRG16};
+
+    // Colors of pixels: [pixel phase][RGB index], phase = (y % 2) * 2 + x % 2.
+    int colors[8][4] = {{0, 1, 1, 2}, {2, 1, 1, 0}, {1, 0, 2, 1}, {1, 2, 0, 1},
+                        {0, 1, 1, 2}, {2, 1, 1, 0}, {1, 0, 2, 1}, {1, 2, 0, 1}};
+
+    // Source image with smooth gradients.
+    const int width = 64;
+    const int height = 48;
+    Frame rgb(width, height, Fourcc::RGB24);
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            rgb.data[(y * width + x) * 3 + 0] = (uint8_t)(2 * x + y);
+            rgb.data[(y * width + x) * 3 + 1] = (uint8_t)(3 * y + 20);
+            rgb.data[(y * width + x) * 3 + 2] = (uint8_t)(200 - x - y);
+        }
+    }
+
+    for (int f = 0; f < 8; ++f)
+    {
+        // Make Bayer frame from RGB image.
+        Frame bayer(width, height, formats[f]);
+        bool is16bit = bayer.size == width * height * 2;
+        for (int y = 0; y < height; ++y)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                int c = colors[f][(y % 2) * 2 + x % 2];
+                uint8_t value = rgb.data[(y * width + x) * 3 + c];
+                if (is16bit)
+                {
+                    bayer.data[(y * width + x) * 2 + 0] = 0x80;
+                    bayer.data[(y * width + x) * 2 + 1] = value;
+                }
+                else
+                {
+                    bayer.data[y * width + x] = value;
+                }
+            }
+        }
+        bayer.frameId = 10;
+
+        // Check both methods. Inner pixels of linear gradients are exact.
+        for (int m = 0; m < 2; ++m)
+        {
+            Frame result;
+            if (!demosaic(bayer, result, Fourcc::RGB24, (DemosaicMethod)m))
+            {
+                cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                return false;
+            }
+            if (result.fourcc != Fourcc::RGB24 || result.frameId != 10 ||
+                result.size != width * height * 3)
+            {
+                cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                return false;
+            }
+            for (int y = 2; y < height - 2; ++y)
+            {
+                for (int x = 2; x < width - 2; ++x)
+                {
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        int i = (y * width + x) * 3 + c;
+                        if (abs(result.data[i] - rgb.data[i]) > 1)
+                        {
+                            cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                            return false;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // SIMD results must be identical to scalar on random data with odd width.
+    Frame bayer(101, 37, Fourcc::GRBG8);
+    for (int i = 0; i < bayer.size; ++i)
+        bayer.data[i] = (uint8_t)(rand() % 256);
+    for (int m = 0; m < 2; ++m)
+    {
+        Frame reference;
+        setSimdLevel(SimdLevel::SCALAR);
+        demosaic(bayer, reference, Fourcc::BGR24, (DemosaicMethod)m);
+        for (int level = 1; level <= (int)getMaxSimdLevel(); ++level)
+        {
+            Frame result;
+            setSimdLevel((SimdLevel)level);
+            demosaic(bayer, result, Fourcc::BGR24, (DemosaicMethod)m);
+            if (memcmp(result.data, reference.data, reference.size) != 0)
+            {
+                cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                return false;
+            }
+        }
+    }
+    setSimdLevel(getMaxSimdLevel());
+
+    // NV12 output.
+    Frame nv12;
+    if (demosaic(bayer, nv12, Fourcc::NV12) ||
+        !demosaic(Frame(100, 36, Fourcc::RGGB8), nv12, Fourcc::NV12) ||
+        nv12.fourcc != Fourcc::NV12 || nv12.size != 100 * 54)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+
+/// Frame to tensor test.
+bool tensorTest()
+{
+    // Source frame.
+    Frame bgr(33, 17, Fourcc::BGR24);
+    for (int i = 0; i < bgr.size; ++i)
+        bgr.data[i] = (uint8_t)(rand() % 256);
+
+    // Without scaling and normalization tensor contains pixel values.
+    TensorParams params;
+    params.scale = 1.0f;
+    params.roiX = 3;
+    params.roiY = 2;
+    params.roiWidth = 20;
+    params.roiHeight = 10;
+    vector<float> chw(getTensorSize(bgr, params) / sizeof(float));
+    if (chw.size() != 20 * 10 * 3 || !frameToTensor(bgr, chw.data(), params))
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+    params.layout = TensorLayout::HWC;
+    params.order = ChannelOrder::BGR;
+    params.type = TensorType::FLOAT16;
+    vector<uint16_t> hwc(chw.size());
+    if (!frameToTensor(bgr, hwc.data(), params))
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+    for (int y = 0; y < 10; ++y)
+    {
+        for (int x = 0; x < 20; ++x)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                // Half precision float of integer value < 2048.
+                int value = bgr.data[((y + 2) * 33 + x + 3) * 3 + c];
+                uint16_t half = hwc[(y * 20 + x) * 3 + c];
+                int exponent = (half >> 10) - 15;
+                float h = value == 0 ? 0.0f :
+                          (1.0f + (half & 0x3FF) / 1024.0f) * (float)(1 << exponent);
+                if (chw[(2 - c) * 200 + y * 20 + x] != (float)value || h != (float)value)
+                {
+                    cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                    return false;
+                }
+            }
+        }
+    }
+
+    // Batch conversion of frames with different formats and scaling.
+    Frame nv12(64, 48, Fourcc::NV12);
+    Frame yuyv(38, 21, Fourcc::YUYV);
+    for (int i = 0; i < nv12.size; ++i)
+        nv12.data[i] = (uint8_t)(rand() % 256);
+    for (int i = 0; i < yuyv.size; ++i)
+        yuyv.data[i] = (uint8_t)(rand() % 256);
+    TensorParams batchParams;
+    batchParams.width = 29;
+    batchParams.height = 23;
+    batchParams.mean[0] = 0.485f;
+    batchParams.mean[1] = 0.456f;
+    batchParams.mean[2] = 0.406f;
+    batchParams.std[0] = 0.229f;
+    batchParams.std[1] = 0.224f;
+    batchParams.std[2] = 0.225f;
+    const Frame* frames[3] = {&nv12, &bgr, &yuyv};
+    const size_t slot = 29 * 23 * 3;
+    for (int type = 0; type < 2; ++type)
+    {
+        batchParams.type = (TensorType)type;
+        size_t slotSize = slot * (type == 0 ? 4 : 2);
+        setSimdLevel(SimdLevel::SCALAR);
+        vector<uint8_t> reference(3 * slotSize);
+        if (!framesToTensor(frames, 3, reference.data(), batchParams))
+        {
+            cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+            return false;
+        }
+
+        // Batch slots must be equal to single frame conversion.
+        vector<uint8_t> single(slotSize);
+        for (int i = 0; i < 3; ++i)
+        {
+            frameToTensor(*frames[i], single.data(), batchParams);
+            if (memcmp(single.data(), &reference[i * slotSize], slotSize) != 0)
+            {
+                cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                return false;
+            }
+        }
+
+        // SIMD results must be identical to scalar.
+        for (int level = 1; level <= (int)getMaxSimdLevel(); ++level)
+        {
+            setSimdLevel((SimdLevel)level);
+            vector<uint8_t> result(3 * slotSize);
+            framesToTensor(frames, 3, result.data(), batchParams);
+            if (result != reference)
+            {
+                cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                return false;
+            }
+        }
+    }
+    setSimdLevel(getMaxSimdLevel());
+
+    // Frames of subsampled formats with odd width or height: last column and
+    // row have chroma of previous ones.
+    const Fourcc subsampled[6] = {Fourcc::NV12, Fourcc::NV21, Fourcc::YU12,
+                                  Fourcc::YV12, Fourcc::YUYV, Fourcc::UYVY};
+    const int sizes[3][2] = {{5, 5}, {6, 5}, {5, 6}};
+    TensorParams oddParams;
+    oddParams.scale = 1.0f;
+    for (int f = 0; f < 6; ++f)
+    {
+        for (int s = 0; s < 3; ++s)
+        {
+            const int w = sizes[s][0];
+            const int h = sizes[s][1];
+            Frame odd(w, h, subsampled[f]);
+            for (int i = 0; i < odd.size; ++i)
+                odd.data[i] = (uint8_t)(rand() % 256);
+
+            // Constant luma.
+            bool isPacked = subsampled[f] == Fourcc::YUYV || subsampled[f] == Fourcc::UYVY;
+            for (int i = 0; i < w * h; ++i)
+                odd.data[isPacked ? 2 * i + (subsampled[f] == Fourcc::YUYV ? 0 : 1) : i] = 100;
+
+            vector<float> tensor(getTensorSize(odd, oddParams) / sizeof(float));
+            if (tensor.size() != (size_t)(w * h * 3) ||
+                !frameToTensor(odd, tensor.data(), oddParams))
+            {
+                cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                return false;
+            }
+            for (int c = 0; c < 3; ++c)
+            {
+                const float* plane = &tensor[(size_t)c * w * h];
+                if ((w % 2 != 0 && plane[w - 1] != plane[w - 2]) ||
+                    (h % 2 != 0 && !isPacked && plane[(h - 1) * w] != plane[(h - 2) * w]))
+                {
+                    cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                    return false;
+                }
+            }
+        }
+    }
+
+    // Bayer frame is demosaiced to RGB24 first.
+    Frame bayer(32, 24, Fourcc::RGGB8);
+    for (int i = 0; i < bayer.size; ++i)
+        bayer.data[i] = (uint8_t)(rand() % 256);
+    Frame demosaiced;
+    if (!demosaic(bayer, demosaiced, Fourcc::RGB24))
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+    batchParams.type = TensorType::FLOAT32;
+    vector<float> bayerTensor(getTensorSize(bayer, batchParams) / sizeof(float));
+    vector<float> rgbTensor(getTensorSize(demosaiced, batchParams) / sizeof(float));
+    if (bayerTensor.empty() || !frameToTensor(bayer, bayerTensor.data(), batchParams) ||
+        !frameToTensor(demosaiced, rgbTensor.data(), batchParams) || bayerTensor != rgbTensor)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Wrong ROI.
+    params.roiX = 30;
+    if (frameToTensor(bgr, hwc.data(), params))
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+
+/// Rotate, flip and transpose test.
+bool transformTest()
+{
+    // Formats with element-wise transformation of planes.
+    Fourcc formats[7] = {Fourcc::RGB24, Fourcc::GRAY, Fourcc::NV12,
+                         Fourcc::YV12, Fourcc::RGGB16, Fourcc::BGGR8,
+                         Fourcc::YUV24};
+
+    for (int f = 0; f < 7; ++f)
+    {
+        // Even size with not aligned width for all formats.
+        Frame src(70, 38, formats[f]);
+        for (int i = 0; i < src.size; ++i)
+            src.data[i] = (uint8_t)(rand() % 256);
+        src.frameId = 5;
+        FramePlane srcPlanes[3];
+        int count = getPlanes(src, srcPlanes);
+
+        for (int t = 0; t < 6; ++t)
+        {
+            Frame dst;
+            if (!transformFrame(src, dst, (FrameTransform)t) || dst.frameId != 5)
+            {
+                cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                return false;
+            }
+
+            // Compare every element of every plane with source element.
+            FramePlane dstPlanes[3];
+            if (getPlanes(dst, dstPlanes) != count)
+            {
+                cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                return false;
+            }
+            for (int p = 0; p < count; ++p)
+            {
+                const FramePlane& s = srcPlanes[p];
+                const FramePlane& d = dstPlanes[p];
+                for (int y = 0; y < d.height; ++y)
+                {
+                    for (int x = 0; x < d.width; ++x)
+                    {
+                        // Source element for rotation by 90, 180, 270,
+                        // horizontal flip, vertical flip and transposition.
+                        int sxs[6] = {y, s.width - 1 - x, s.width - 1 - y,
+                                      s.width - 1 - x, x, y};
+                        int sys[6] = {s.height - 1 - x, s.height - 1 - y, x,
+                                      y, s.height - 1 - y, x};
+                        int sx = sxs[t];
+                        int sy = sys[t];
+                        if (memcmp(&d.data[y * d.stride + x * d.elementSize],
+                                   &s.data[sy * s.stride + sx * s.elementSize],
+                                   s.elementSize) != 0)
+                        {
+                            cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                            return false;
+                        }
+                    }
+                }
+            }
+        }
+
+        // In place transformations give the same result.
+        for (int t = 1; t < 5; t += (t == 1 ? 2 : 1))
+        {
+            Frame expected;
+            transformFrame(src, expected, (FrameTransform)t);
+            Frame frame(src);
+            if (!transformFrame(frame, (FrameTransform)t) || frame != expected)
+            {
+                cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                return false;
+            }
+        }
+    }
+
+    // Bayer pattern follows transformation.
+    Frame rggb(8, 4, Fourcc::RGGB8);
+    Fourcc patterns[6] = {Fourcc::GRBG8, Fourcc::BGGR8, Fourcc::GBRG8,
+                          Fourcc::GRBG8, Fourcc::GBRG8, Fourcc::RGGB8};
+    for (int t = 0; t < 6; ++t)
+    {
+        Frame dst;
+        if (!transformFrame(rggb, dst, (FrameTransform)t) || dst.fourcc != patterns[t])
+        {
+            cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+            return false;
+        }
+    }
+
+    // YUYV: horizontal flip swaps luma in macropixels, rotation averages chroma.
+    Frame yuyv(4, 2, Fourcc::YUYV);
+    uint8_t yuyvData[16] = {1, 100, 2, 200, 3, 101, 4, 201,
+                            5, 102, 6, 202, 7, 103, 8, 203};
+    memcpy(yuyv.data, yuyvData, 16);
+    Frame flipped;
+    uint8_t flippedData[16] = {4, 101, 3, 201, 2, 100, 1, 200,
+                               8, 103, 7, 203, 6, 102, 5, 202};
+    if (!transformFrame(yuyv, flipped, FrameTransform::FLIP_HORIZONTAL) ||
+        memcmp(flipped.data, flippedData, 16) != 0)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+    Frame rotated;
+    uint8_t rotatedData[16] = {5, 101, 1, 201, 6, 101, 2, 201,
+                               7, 102, 3, 202, 8, 102, 4, 202};
+    if (!transformFrame(yuyv, rotated, FrameTransform::ROTATE_90) ||
+        rotated.width != 2 || rotated.height != 4 ||
+        memcmp(rotated.data, rotatedData, 16) != 0)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Not supported cases.
+    Frame result;
+    if (transformFrame(Frame(7, 4, Fourcc::NV12), result, FrameTransform::ROTATE_90) ||
+        transformFrame(yuyv, FrameTransform::ROTATE_90) ||
+        transformFrame(Frame(4, 3, Fourcc::YUYV), result, FrameTransform::TRANSPOSE))
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // SIMD results must be identical to scalar (odd sizes, 8 and 16 bit).
+    Frame simdFrames[2] = {Frame(203, 131, Fourcc::GRAY),
+                           Frame(202, 130, Fourcc::RGGB16)};
+    for (int f = 0; f < 2; ++f)
+    {
+        Frame& src = simdFrames[f];
+        for (int i = 0; i < src.size; ++i)
+            src.data[i] = (uint8_t)(rand() % 256);
+        for (int t = 0; t < 6; ++t)
+        {
+            Frame reference;
+            setSimdLevel(SimdLevel::SCALAR);
+            transformFrame(src, reference, (FrameTransform)t);
+            for (int level = 1; level <= (int)getMaxSimdLevel(); ++level)
+            {
+                Frame dst;
+                setSimdLevel((SimdLevel)level);
+                transformFrame(src, dst, (FrameTransform)t);
+                if (dst.size != reference.size ||
+                    memcmp(dst.data, reference.data, reference.size) != 0)
+                {
+                    cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                    return false;
+                }
+            }
+        }
+    }
+    setSimdLevel(getMaxSimdLevel());
+
+    return true;
+}
+
+
+
+/// Statistics and lookup table test.
+bool lutTest()
+{
+    // Frames, planes and channels to check.
+    Frame frames[4] = {Frame(67, 33, Fourcc::GRAY), Frame(67, 33, Fourcc::RGB24),
+                       Frame(68, 34, Fourcc::NV21), Frame(68, 34, Fourcc::RGGB16)};
+    int planes[4] = {0, 0, 1, 0};
+    int channels[4] = {-1, 2, 1, -1};
+    for (int f = 0; f < 4; ++f)
+    {
+        Frame& frame = frames[f];
+        for (int i = 0; i < frame.size; ++i)
+            frame.data[i] = (uint8_t)(rand() % 200 + 20);
+
+        // Reference statistics.
+        FramePlane plane[3];
+        getPlanes(frame, plane);
+        const FramePlane& p = plane[planes[f]];
+        const bool is16bit = getSampleBits(frame.fourcc) == 16;
+        const int sampleSize = is16bit ? 2 : 1;
+        const int perElement = p.elementSize / sampleSize;
+        vector<uint32_t> histogram(is16bit ? 65536 : 256, 0);
+        int count = 0;
+        int minValue = 65536;
+        int maxValue = -1;
+        double sum = 0.0;
+        for (int y = 0; y < p.height; ++y)
+        {
+            for (int i = 0; i < p.width * perElement; ++i)
+            {
+                if (channels[f] >= 0 && i % perElement != channels[f])
+                    continue;
+                const uint8_t* sample = &p.data[y * p.stride + i * sampleSize];
+                int value = is16bit ? sample[0] + sample[1] * 256 : sample[0];
+                ++histogram[value];
+                ++count;
+                minValue = value < minValue ? value : minValue;
+                maxValue = value > maxValue ? value : maxValue;
+                sum += value;
+            }
+        }
+
+        // Statistics with and without histogram for all SIMD levels.
+        for (int level = 0; level <= (int)getMaxSimdLevel(); ++level)
+        {
+            setSimdLevel((SimdLevel)level);
+            for (int h = 0; h < 2; ++h)
+            {
+                PlaneStatistics stats;
+                if (!getPlaneStatistics(frame, planes[f], stats, channels[f], h == 1) ||
+                    stats.count != count || stats.min != minValue ||
+                    stats.max != maxValue || stats.mean != sum / count ||
+                    (h == 1 && stats.histogram != histogram) ||
+                    (h == 0 && !stats.histogram.empty()))
+                {
+                    cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                    return false;
+                }
+            }
+        }
+        setSimdLevel(getMaxSimdLevel());
+
+        // Copy with statistics.
+        Frame copy;
+        PlaneStatistics stats;
+        if (!copyWithStatistics(frame, copy, planes[f], stats, channels[f]) ||
+            copy != frame || stats.histogram != histogram ||
+            stats.min != minValue || stats.max != maxValue)
+        {
+            cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+            return false;
+        }
+    }
+
+    // 8 bit lookup table applied to one channel only.
+    Frame rgb(frames[1]);
+    uint8_t invert[256];
+    for (int i = 0; i < 256; ++i)
+        invert[i] = (uint8_t)(255 - i);
+    if (!applyLut(rgb, 0, invert, 1))
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+    for (int i = 0; i < rgb.size; ++i)
+    {
+        int expected = i % 3 == 1 ? 255 - frames[1].data[i] : frames[1].data[i];
+        if (rgb.data[i] != expected)
+        {
+            cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+            return false;
+        }
+    }
+
+    // 16 bit lookup table.
+    Frame bayer(frames[3]);
+    vector<uint16_t> halve(65536);
+    for (int i = 0; i < 65536; ++i)
+        halve[i] = (uint16_t)(i / 2);
+    if (!applyLut(bayer, 0, halve.data()) || applyLut(bayer, 0, invert))
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+    for (int i = 0; i < bayer.size; i += 2)
+    {
+        int value = (frames[3].data[i] + frames[3].data[i + 1] * 256) / 2;
+        if (bayer.data[i] + bayer.data[i + 1] * 256 != value)
+        {
+            cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+            return false;
+        }
+    }
+
+    // Gain and offset with saturation.
+    Frame gray(frames[0]);
+    if (!applyGainOffset(gray, 0, 1.5f, -40.0f))
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+    for (int i = 0; i < gray.size; ++i)
+    {
+        int value = (int)floor(frames[0].data[i] * 1.5 - 40.0 + 0.5);
+        value = value < 0 ? 0 : (value > 255 ? 255 : value);
+        if (gray.data[i] != value)
+        {
+            cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+            return false;
+        }
+    }
+
+    // Wrong plane or channel.
+    PlaneStatistics stats;
+    if (getPlaneStatistics(frames[0], 1, stats) ||
+        getPlaneStatistics(frames[1], 0, stats, 3) ||
+        getPlaneStatistics(Frame(64, 64, Fourcc::JPEG), 0, stats))
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+
+/// Overlay test.
+bool overlayTest()
+{
+    // Opaque red rectangle with odd position and size in NV12 frame.
+    Frame nv12(64, 32, Fourcc::NV12);
+    memset(nv12.data, 128, nv12.size);
+    FrameOverlay overlay;
+    OverlayColor red;
+    red.r = 255;
+    overlay.addRect(11, 5, 19, 10, red);
+    if (!overlay.draw(nv12))
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Red in BT.601 limited range: Y = 82, U = 90, V = 240.
+    for (int y = 0; y < 32; ++y)
+    {
+        for (int x = 0; x < 64; ++x)
+        {
+            bool inside = x >= 11 && x < 30 && y >= 5 && y < 15;
+            if (nv12.data[y * 64 + x] != (inside ? 82 : 128))
+            {
+                cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                return false;
+            }
+        }
+    }
+
+    // Chroma: full blocks get color, blocks covered by 2 of 4 pixels get average.
+    uint8_t* uv = nv12.data + 64 * 32;
+    if (uv[4 * 64 + 8 * 2] != 90 || uv[4 * 64 + 8 * 2 + 1] != 240 ||
+        uv[2 * 64 + 8 * 2] != 109 || uv[2 * 64 + 8 * 2 + 1] != 184 ||
+        uv[4 * 64 + 5 * 2] != 109 || uv[0] != 128 || uv[4 * 64 + 15 * 2] != 128)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Outlined rectangle doesn't change interior and blends border once.
+    Frame gray(40, 30, Fourcc::GRAY);
+    memset(gray.data, 100, gray.size);
+    overlay.clear();
+    OverlayColor white;
+    white.r = 255;
+    white.g = 255;
+    white.b = 255;
+    white.a = 128;
+    overlay.addRect(5, 5, 20, 15, white, 2);
+    if (overlay.getItemsCount() != 4 || !overlay.draw(gray))
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+    int blended = (100 * 127 + 235 * 128 + 127) / 255;
+    for (int y = 0; y < 30; ++y)
+    {
+        for (int x = 0; x < 40; ++x)
+        {
+            bool border = x >= 5 && x < 25 && y >= 5 && y < 20 &&
+                          (x < 7 || x >= 23 || y < 7 || y >= 18);
+            if (gray.data[y * 40 + x] != (border ? blended : 100))
+            {
+                cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                return false;
+            }
+        }
+    }
+
+    // Text from glyph atlas: glyph 'A' is 3x2 opaque box, space is empty.
+    uint8_t atlasImage[8] = {255, 255, 255, 0, 255, 255, 255, 0};
+    GlyphAtlas atlas;
+    if (!atlas.setImage(atlasImage, 4, 2, 4) ||
+        !atlas.addGlyph('A', 0, 0, 3, 2, 0, 1, 4) ||
+        !atlas.addGlyph(' ', 0, 0, 0, 0, 0, 0, 2) ||
+        atlas.addGlyph('B', 2, 0, 3, 2, 0, 0, 4) ||
+        atlas.getTextWidth("A A") != 10)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+    memset(gray.data, 100, gray.size);
+    overlay.clear();
+    white.a = 255;
+    overlay.addText(2, 3, "A A", atlas, white);
+    if (overlay.getItemsCount() != 2 || !overlay.draw(gray) ||
+        gray.data[4 * 40 + 2] != 235 || gray.data[5 * 40 + 4] != 235 ||
+        gray.data[4 * 40 + 5] != 100 || gray.data[4 * 40 + 8] != 235 ||
+        gray.data[3 * 40 + 2] != 100)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // RGBA and A8 sprites on all formats: SIMD results identical to scalar.
+    vector<uint8_t> rgba(37 * 21 * 4);
+    vector<uint8_t> mask(50 * 40);
+    for (size_t i = 0; i < rgba.size(); ++i)
+        rgba[i] = (uint8_t)(rand() % 256);
+    for (size_t i = 0; i < mask.size(); ++i)
+        mask[i] = (uint8_t)(rand() % 256);
+    OverlaySprite rgbaSprite;
+    rgbaSprite.data = rgba.data();
+    rgbaSprite.width = 37;
+    rgbaSprite.height = 21;
+    rgbaSprite.stride = 37 * 4;
+    OverlaySprite maskSprite;
+    maskSprite.data = mask.data();
+    maskSprite.width = 50;
+    maskSprite.height = 40;
+    maskSprite.stride = 50;
+    maskSprite.isAlphaOnly = true;
+    overlay.clear();
+    overlay.addSprite(-5, 3, rgbaSprite, white);
+    overlay.addSprite(30, 20, maskSprite, red);
+    overlay.addRect(20, 10, 60, 30, white, 3);
+
+    Fourcc formats[5] = {Fourcc::NV12, Fourcc::YV12, Fourcc::YUYV,
+                         Fourcc::UYVY, Fourcc::GRAY};
+    for (int f = 0; f < 5; ++f)
+    {
+        Frame src(100, 50, formats[f]);
+        for (int i = 0; i < src.size; ++i)
+            src.data[i] = (uint8_t)(rand() % 256);
+        Frame reference(src);
+        setSimdLevel(SimdLevel::SCALAR);
+        overlay.draw(reference);
+        for (int level = 1; level <= (int)getMaxSimdLevel(); ++level)
+        {
+            Frame result(src);
+            setSimdLevel((SimdLevel)level);
+            if (!overlay.draw(result) || result != reference)
+            {
+                cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                return false;
+            }
+        }
+        setSimdLevel(getMaxSimdLevel());
+
+        // Luma of RGBA sprite pixel.
+        Frame result(src);
+        overlay.draw(result);
+        int yPos = formats[f] == Fourcc::UYVY ? 1 : 0;
+        int step = formats[f] == Fourcc::YUYV || formats[f] == Fourcc::UYVY ? 2 : 1;
+        const uint8_t* p = &rgba[(2 * 37 + 7) * 4];
+        int color = ((66 * p[0] + 129 * p[1] + 25 * p[2] + 128) >> 8) + 16;
+        int a = (p[3] * 255 + 127) / 255;
+        int luma = src.data[(5 * 100 + 2) * step + yPos];
+        if (result.data[(5 * 100 + 2) * step + yPos] !=
+            (luma * (255 - a) + color * a + 127) / 255)
+        {
+            cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+            return false;
+        }
+    }
+
+    // Rectangles with end coordinates out of int range: first is out of
+    // frame, second covers frame from (2, 3), third has left and top
+    // borders only in frame.
+    Frame huge(40, 30, Fourcc::GRAY);
+    memset(huge.data, 100, huge.size);
+    overlay.clear();
+    white.a = 255;
+    overlay.addRect(INT_MAX - 5, INT_MAX - 5, INT_MAX, INT_MAX, white);
+    overlay.addRect(INT_MAX - 5, INT_MAX - 5, INT_MAX, INT_MAX, white, 3);
+    overlay.addRect(2, 3, INT_MAX, INT_MAX, red);
+    overlay.addRect(-1, -1, INT_MAX, INT_MAX, white, 2);
+    if (!overlay.draw(huge))
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+    for (int y = 0; y < 30; ++y)
+    {
+        for (int x = 0; x < 40; ++x)
+        {
+            int expected = x < 1 || y < 1 ? 235 : (x < 2 || y < 3 ? 100 : 82);
+            if (huge.data[y * 40 + x] != expected)
+            {
+                cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                return false;
+            }
+        }
+    }
+
+    // Not supported formats and sizes.
+    Frame bgr(64, 32, Fourcc::BGR24);
+    Frame odd(63, 32, Fourcc::NV12);
+    if (overlay.draw(bgr) || overlay.draw(odd))
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+
+/// Batch serialization test.
+bool batchTest()
+{
+    // Frames from different sources.
+    const int count = 5;
+    Frame frames[count] = {Frame(32, 24, Fourcc::NV12), Frame(16, 16, Fourcc::GRAY),
+                           Frame(20, 10, Fourcc::BGR24), Frame(8, 8, Fourcc::YUYV),
+                           Frame(64, 48, Fourcc::JPEG)};
+    frames[4].size = 100;
+    for (int i = 0; i < count; ++i)
+    {
+        for (int j = 0; j < frames[i].size; ++j)
+            frames[i].data[j] = (uint8_t)(rand() % 256);
+        frames[i].frameId = 100 + i;
+        frames[i].sourceId = i;
+    }
+
+    // Batch limited by size: 4 frames fit.
+    FrameBatchWriter writer;
+    int maxBytes = FrameBatchWriter::HEADER_SIZE;
+    for (int i = 0; i < 4; ++i)
+        maxBytes += frames[i].size + FrameBatchWriter::RECORD_SIZE;
+    writer.setFlushPolicy(maxBytes, 0);
+    for (int i = 0; i < 4; ++i)
+    {
+        if (writer.isReady() || !writer.add(frames[i]))
+        {
+            cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+            return false;
+        }
+    }
+    if (!writer.isReady() || writer.add(frames[4]) ||
+        writer.getFramesCount() != 4 || writer.getSize() != maxBytes)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Read frames without copy.
+    int size = 0;
+    const uint8_t* data = writer.getData(size);
+    vector<uint8_t> batch(data, data + size);
+    FrameBatchReader reader;
+    if (size != maxBytes || !reader.open(batch.data(), size) ||
+        reader.getFramesCount() != 4)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+    for (int i = 0; i < 4; ++i)
+    {
+        Frame frame(4, 4, Fourcc::GRAY);
+        if (!reader.getFrame(i, frame) || frame != frames[i] ||
+            frame.data < batch.data() || frame.data >= batch.data() + size)
+        {
+            cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+            return false;
+        }
+    }
+
+    // Records which don't match data size are rejected, frame is not changed.
+    vector<uint8_t> corrupted = batch;
+    uint8_t* record = &corrupted[size - 3 * FrameBatchWriter::RECORD_SIZE];
+    int value = 32;
+    memcpy(&record[0], &value, 4);
+    record += FrameBatchWriter::RECORD_SIZE;
+    value = -8;
+    memcpy(&record[4], &value, 4);
+    Frame unchanged(4, 4, Fourcc::GRAY);
+    if (!reader.open(corrupted.data(), size) || reader.getFrame(1, unchanged) ||
+        reader.getFrame(2, unchanged) || unchanged.width != 4 ||
+        unchanged.data == nullptr || !reader.getFrame(3, unchanged))
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Next batch with latency policy.
+    writer.clear();
+    writer.setFlushPolicy(0, 1);
+    if (writer.getSize() != FrameBatchWriter::HEADER_SIZE || writer.isReady() ||
+        !writer.add(frames[4]))
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    if (!writer.isReady())
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Adding frame after getData(...) continues batch.
+    data = writer.getData(size);
+    writer.add(frames[0]);
+    data = writer.getData(size);
+    Frame frame;
+    if (!reader.open((uint8_t*)data, size) || reader.getFramesCount() != 2 ||
+        !reader.getFrame(0, frame) || frame != frames[4] ||
+        !reader.getFrame(1, frame) || frame != frames[0] || reader.getFrame(2, frame))
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Corrupted batch.
+    batch[6] = 0;
+    if (reader.open(batch.data(), (int)batch.size()) ||
+        reader.open(batch.data(), 5) || reader.getFramesCount() != 0)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+
+/// Stream deserializer test.
+bool deserializerTest()
+{
+    // Prepare stream of frames.
+    Frame frames[3];
+    frames[0] = Frame(64, 32, Fourcc::NV12);
+    frames[1] = Frame(64, 32, Fourcc::NV12);
+    frames[2] = Frame(32, 16, Fourcc::JPEG);
+    frames[2].size = 100;
+    vector<uint8_t> stream;
+    for (int i = 0; i < 3; ++i)
+    {
+        for (int j = 0; j < frames[i].size; ++j)
+            frames[i].data[j] = (uint8_t)(j * 7 + i);
+        frames[i].frameId = i + 1;
+        frames[i].sourceId = 10;
+        vector<uint8_t> data(frames[i].size + FrameDeserializer::HEADER_SIZE);
+        int size = 0;
+        frames[i].serialize(data.data(), size);
+        stream.insert(stream.end(), data.begin(), data.begin() + size);
+    }
+
+    // Push stream by small chunks.
+    FrameDeserializer deserializer;
+    int position = 0;
+    int count = 0;
+    uint8_t* buffer = nullptr;
+    while (position < (int)stream.size())
+    {
+        int chunk = (int)stream.size() - position < 5 ? (int)stream.size() - position : 5;
+        int consumed = deserializer.push(&stream[position], chunk);
+        if (consumed < 0)
+        {
+            cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+            return false;
+        }
+        position += consumed;
+        if (deserializer.isReady())
+        {
+            // Frame memory is reused for the same format.
+            Frame& frame = deserializer.getFrame();
+            if (count > 2 || frame != frames[count] ||
+                frame.frameId != count + 1 || frame.sourceId != 10 ||
+                (count == 1 && frame.data != buffer))
+            {
+                cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                return false;
+            }
+            buffer = frame.data;
+            deserializer.next();
+            ++count;
+        }
+    }
+    if (count != 3)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Receive directly to frame buffer.
+    position = 0;
+    while (!deserializer.isReady())
+    {
+        int size = 0;
+        uint8_t* data = deserializer.getBuffer(size);
+        if (data == nullptr || size <= 0)
+        {
+            cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+            return false;
+        }
+        memcpy(data, &stream[position], size);
+        position += size;
+        deserializer.commit(size);
+    }
+    if (position != frames[0].size + FrameDeserializer::HEADER_SIZE ||
+        deserializer.getFrame() != frames[0])
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Frame size limit and wrong header.
+    deserializer.reset();
+    deserializer.setMaxFrameSize(1000);
+    if (deserializer.push(stream.data(), (int)stream.size()) != -1 ||
+        !deserializer.isError())
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+    // Compressed frame with small data size and huge width and height is
+    // rejected by limit of frame buffer (width * height * 4 bytes).
+    vector<uint8_t> huge(frames[2].size + FrameDeserializer::HEADER_SIZE);
+    int hugeSize = 0;
+    frames[2].serialize(huge.data(), hugeSize);
+    const int hugeWidth = 100000;
+    memcpy(&huge[2], &hugeWidth, 4);
+    memcpy(&huge[6], &hugeWidth, 4);
+    deserializer.reset();
+    deserializer.setMaxFrameSize(1 << 20);
+    if (deserializer.push(huge.data(), hugeSize) != -1 || !deserializer.isError())
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Empty frame is accepted as by Frame::deserialize(...).
+    Frame empty;
+    empty.frameId = 7;
+    vector<uint8_t> header(FrameDeserializer::HEADER_SIZE);
+    int headerSize = 0;
+    empty.serialize(header.data(), headerSize);
+    Frame emptyCopy;
+    deserializer.reset();
+    if (!emptyCopy.deserialize(header.data(), headerSize) ||
+        deserializer.push(header.data(), headerSize) != headerSize ||
+        !deserializer.isReady() || deserializer.getFrame().size != 0 ||
+        deserializer.getFrame().frameId != 7)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    deserializer.reset();
+    deserializer.setMaxFrameSize(0);
+    stream[0] += 1;
+    if (deserializer.push(stream.data(), (int)stream.size()) != -1)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+
+/// Mosaic test.
+bool mosaicTest()
+{
+    // Sources: solid color RGB frame, NV12 frame with cell size and GRAY
+    // frame with gradient.
+    Frame rgb(16, 16, Fourcc::RGB24);
+    for (int i = 0; i < rgb.size; i += 3)
+    {
+        rgb.data[i] = 200;
+        rgb.data[i + 1] = 100;
+        rgb.data[i + 2] = 50;
+    }
+    Frame nv12(32, 24, Fourcc::NV12);
+    for (int i = 0; i < nv12.size; ++i)
+        nv12.data[i] = (uint8_t)(i * 13);
+    Frame gray(64, 48, Fourcc::GRAY);
+    for (int i = 0; i < gray.size; ++i)
+        gray.data[i] = (uint8_t)(i % 64);
+    const Frame* frames[3] = {&rgb, &nv12, &gray};
+
+    // Grid 2 x 2 in NV12 frame. Last cell is empty.
+    FrameMosaic mosaic;
+    Frame dst(64, 48, Fourcc::NV12);
+    memset(dst.data, 0, dst.size);
+    if (!mosaic.setGrid(2, 2, 64, 48) || mosaic.getLayout().size() != 4 ||
+        !mosaic.compose(frames, 3, dst) || mosaic.getUpdatedCellsCount() != 4)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+    const uint8_t* uv = &dst.data[64 * 48];
+    for (int y = 0; y < 24; ++y)
+    {
+        for (int x = 0; x < 32; ++x)
+        {
+            // Solid color.
+            if (dst.data[y * 64 + x] != 123 || uv[(y / 2) * 64 + (x / 2) * 2] != 91 ||
+                uv[(y / 2) * 64 + (x / 2) * 2 + 1] != 175)
+            {
+                cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                return false;
+            }
+            // Source with cell size is copied.
+            if (dst.data[y * 64 + 32 + x] != nv12.data[y * 32 + x] ||
+                uv[(y / 2) * 64 + 32 + x] != nv12.data[32 * 24 + (y / 2) * 32 + x])
+            {
+                cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                return false;
+            }
+            // Black cell.
+            if (dst.data[(y + 24) * 64 + 32 + x] != 16 ||
+                uv[((y + 24) / 2) * 64 + 32 + x] != 128)
+            {
+                cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                return false;
+            }
+        }
+    }
+
+    // Downscaled gradient: pixels x * 2 and x * 2 + 1 are averaged.
+    for (int x = 0; x < 32; ++x)
+    {
+        int value = (((220 * 2 * x + 128) >> 8) + ((220 * (2 * x + 1) + 128) >> 8)) / 2 + 16;
+        if (abs(dst.data[30 * 64 + x] - value) > 1)
+        {
+            cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+            return false;
+        }
+    }
+
+    // Unchanged cells are skipped.
+    if (!mosaic.compose(frames, 3, dst) || mosaic.getUpdatedCellsCount() != 0)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+    nv12.frameId = 1;
+    frames[0] = nullptr;
+    if (!mosaic.compose(frames, 3, dst) || mosaic.getUpdatedCellsCount() != 2 ||
+        dst.data[0] != 16 || dst.data[32] != nv12.data[0])
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // RGB output: GRAY source with cell size is copied to all channels.
+    Frame bgr(96, 48, Fourcc::BGR24);
+    vector<MosaicCell> cells(2);
+    cells[0].width = 64;
+    cells[0].height = 48;
+    cells[1].x = 64;
+    cells[1].width = 31;
+    cells[1].height = 17;
+    frames[0] = &gray;
+    frames[1] = &rgb;
+    if (!mosaic.setLayout(cells) || !mosaic.compose(frames, 2, bgr))
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+    for (int i = 0; i < 64 * 48; ++i)
+    {
+        const uint8_t* p = &bgr.data[((i / 64) * 96 + i % 64) * 3];
+        if (p[0] != gray.data[i] || p[1] != gray.data[i] || p[2] != gray.data[i])
+        {
+            cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+            return false;
+        }
+    }
+    const uint8_t* p = &bgr.data[(16 * 96 + 94) * 3];
+    if (p[0] != 50 || p[1] != 100 || p[2] != 200)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // SIMD results must be identical to scalar (upscaled NV12 source).
+    Frame reference(96, 48, Fourcc::YU12);
+    frames[0] = &nv12;
+    cells[0].width = 62;
+    cells[0].height = 40;
+    cells[1].width = 30;
+    cells[1].height = 16;
+    setSimdLevel(SimdLevel::SCALAR);
+    if (!mosaic.setLayout(cells) || !mosaic.compose(frames, 1, reference))
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+    for (int level = 1; level <= (int)getMaxSimdLevel(); ++level)
+    {
+        Frame result(96, 48, Fourcc::YU12);
+        memcpy(result.data, reference.data, reference.size);
+        setSimdLevel((SimdLevel)level);
+        mosaic.invalidate();
+        if (!mosaic.compose(frames, 1, result) ||
+            memcmp(result.data, reference.data, reference.size) != 0)
+        {
+            cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+            return false;
+        }
+    }
+    setSimdLevel(getMaxSimdLevel());
+
+    // Not valid layouts: odd cell for NV12 output, overlapping cells.
+    cells[1].width = 31;
+    if (!mosaic.setLayout(cells) || mosaic.compose(frames, 2, reference))
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+    cells[1].x = 60;
+    if (mosaic.setLayout(cells))
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Cells with right or bottom edge beyond int range.
+    vector<MosaicCell> farCells(2);
+    farCells[0].x = 10;
+    farCells[0].width = INT_MAX;
+    farCells[0].height = 2;
+    farCells[1].x = 20;
+    farCells[1].width = 10;
+    farCells[1].height = 2;
+    if (mosaic.setLayout(farCells))
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+    farCells.resize(1);
+    farCells[0].x = INT_MAX - 1;
+    farCells[0].width = 64;
+    if (!mosaic.setLayout(farCells) || mosaic.compose(frames, 1, reference))
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Odd-sized subsampled sources: gray frames give gray cells.
+    Frame oddNv12(5, 5, Fourcc::NV12);
+    Frame oddYu12(5, 5, Fourcc::YU12);
+    Frame oddYuyv(5, 5, Fourcc::YUYV);
+    memset(oddNv12.data, 128, oddNv12.size);
+    memset(oddYu12.data, 128, oddYu12.size);
+    memset(oddYuyv.data, 128, oddYuyv.size);
+    const Frame* oddFrames[3] = {&oddNv12, &oddYu12, &oddYuyv};
+    Frame rgbOut(64, 64, Fourcc::RGB24);
+    if (!mosaic.setGrid(3, 1, 64, 64) || !mosaic.compose(oddFrames, 3, rgbOut))
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+    for (const MosaicCell& cell : mosaic.getLayout())
+    {
+        const uint8_t* first = &rgbOut.data[(cell.y * 64 + cell.x) * 3];
+        for (int y = cell.y; y < cell.y + cell.height; ++y)
+        {
+            for (int x = cell.x; x < cell.x + cell.width; ++x)
+            {
+                const uint8_t* pixel = &rgbOut.data[(y * 64 + x) * 3];
+                if (pixel[0] != first[0] || pixel[1] != first[0] || pixel[2] != first[0])
+                {
+                    cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+
+
+/// Pyramid test.
+bool pyramidTest()
+{
+    // NV12 frame with odd size of levels.
+    Frame nv12(150, 118, Fourcc::NV12);
+    for (int i = 0; i < nv12.size; ++i)
+        nv12.data[i] = (uint8_t)(rand() % 256);
+    nv12.frameId = 1;
+
+    for (int level = 0; level <= (int)getMaxSimdLevel(); ++level)
+    {
+        setSimdLevel((SimdLevel)level);
+        FramePyramid pyramid;
+        if (!pyramid.build(nv12, 5) || pyramid.getLevelsCount() != 5)
+        {
+            cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+            return false;
+        }
+
+        // Compare levels with reference 2x2 box filter.
+        Frame previous;
+        Frame current;
+        pyramid.getLevel(0, previous);
+        if (previous.data != nv12.data || previous.width != 150 ||
+            previous.fourcc != Fourcc::GRAY)
+        {
+            cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+            return false;
+        }
+        for (int l = 1; l < 5; ++l)
+        {
+            if (!pyramid.getLevel(l, current) || current.width != previous.width / 2 ||
+                current.height != previous.height / 2 || current.frameId != 1)
+            {
+                cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                return false;
+            }
+            for (int y = 0; y < current.height; ++y)
+            {
+                for (int x = 0; x < current.width; ++x)
+                {
+                    const uint8_t* p = &previous.data[2 * y * previous.width + 2 * x];
+                    int value = (p[0] + p[1] + p[previous.width] + p[previous.width + 1] + 2) >> 2;
+                    if (current.data[y * current.width + x] != value)
+                    {
+                        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                        return false;
+                    }
+                }
+            }
+            previous = current;
+        }
+    }
+    setSimdLevel(getMaxSimdLevel());
+
+    // Levels are cached for the same frame.
+    FramePyramid pyramid;
+    Frame level;
+    pyramid.build(nv12, 3);
+    pyramid.getLevel(1, level);
+    uint8_t value = level.data[0];
+    nv12.data[0] += 100;
+    if (!pyramid.build(nv12, 2) || pyramid.getLevelsCount() != 3 ||
+        !pyramid.getLevel(1, level) || level.data[0] != value)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+    nv12.frameId = 2;
+    if (!pyramid.build(nv12, 2) || !pyramid.getLevel(1, level) || level.data[0] == value)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Number of levels is limited by frame size. Not supported format.
+    Frame gray(5, 3, Fourcc::GRAY);
+    if (!pyramid.build(gray, 8) || pyramid.getLevelsCount() != 2 ||
+        pyramid.getLevel(2, level) || pyramid.build(Frame(8, 8, Fourcc::BGR24), 2))
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+
+/// Derived representations cache test.
+bool derivedTest()
+{
+    Frame frame(64, 48, Fourcc::NV12);
+    for (int i = 0; i < frame.size; ++i)
+        frame.data[i] = (uint8_t)(i * 5);
+    frame.frameId = 7;
+
+    // Concurrent requests get the same representation.
+    shared_ptr<const Frame> results[4];
+    vector<thread> threads;
+    for (int i = 0; i < 4; ++i)
+        threads.emplace_back([&frame, &results, i]()
+        {
+            results[i] = frame.getDerived(Fourcc::BGR24, 32, 24);
+        });
+    for (thread& t : threads)
+        t.join();
+    for (int i = 0; i < 4; ++i)
+    {
+        if (results[i] == nullptr || results[i] != results[0] ||
+            results[i]->width != 32 || results[i]->height != 24 ||
+            results[i]->fourcc != Fourcc::BGR24 || results[i]->frameId != 7)
+        {
+            cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+            return false;
+        }
+    }
+
+    // GRAY of NV12 frame is luma plane.
+    shared_ptr<const Frame> gray = frame.getDerived(Fourcc::GRAY);
+    if (gray == nullptr || gray->size != 64 * 48 ||
+        memcmp(gray->data, frame.data, gray->size) != 0 ||
+        frame.getDerived(Fourcc::GRAY) != gray)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Cache is invalidated by writing data, new frame ID and explicitly.
+    uint8_t lut[256];
+    for (int i = 0; i < 256; ++i)
+        lut[i] = (uint8_t)(255 - i);
+    applyLut(frame, 0, lut);
+    shared_ptr<const Frame> inverted = frame.getDerived(Fourcc::GRAY);
+    if (inverted == gray || inverted->data[1] != 255 - gray->data[1])
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+    frame.frameId = 8;
+    shared_ptr<const Frame> next = frame.getDerived(Fourcc::GRAY);
+    if (next == inverted || next->frameId != 8)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+    frame.invalidateCache();
+    if (frame.getDerived(Fourcc::GRAY) == next)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Bayer source and not supported conversions.
+    Frame bayer(32, 32, Fourcc::RGGB8);
+    Frame jpeg(32, 32, Fourcc::JPEG);
+    shared_ptr<const Frame> rgb = bayer.getDerived(Fourcc::RGB24);
+    shared_ptr<const Frame> small = bayer.getDerived(Fourcc::GRAY, 16, 16);
+    if (rgb == nullptr || rgb->fourcc != Fourcc::RGB24 || small == nullptr ||
+        small->width != 16 || jpeg.getDerived(Fourcc::BGR24) != nullptr ||
+        frame.getDerived(Fourcc::YUV24) != nullptr)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+
+/// Temporal kernels test.
+bool temporalTest()
+{
+    // Random YU12 frames.
+    const int count = 6;
+    Frame frames[count];
+    const Frame* pointers[count];
+    for (int i = 0; i < count; ++i)
+    {
+        frames[i] = Frame(70, 38, Fourcc::YU12);
+        for (int j = 0; j < frames[i].size; ++j)
+            frames[i].data[j] = (uint8_t)(rand() % 256);
+        frames[i].frameId = i;
+        pointers[i] = &frames[i];
+    }
+
+    for (int level = 0; level <= (int)getMaxSimdLevel(); ++level)
+    {
+        setSimdLevel((SimdLevel)level);
+
+        // Background model of second chroma plane (35 x 19).
+        FrameAccumulator accumulator;
+        vector<uint16_t> reference(35 * 19);
+        const int offset = 70 * 38 + 35 * 19;
+        Frame mask;
+        for (int i = 0; i < count; ++i)
+        {
+            if (!accumulator.update(frames[i], 0.1f, 20, mask, 2) ||
+                mask.width != 35 || mask.height != 19 || mask.frameId != i)
+            {
+                cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                return false;
+            }
+            for (int j = 0; j < 35 * 19; ++j)
+            {
+                int value = frames[i].data[offset + j];
+                int expected = 0;
+                if (i == 0)
+                {
+                    reference[j] = (uint16_t)(value << 8);
+                }
+                else
+                {
+                    expected = abs(value - ((reference[j] + 128) >> 8)) > 20 ? 255 : 0;
+                    int difference = (value << 8) - reference[j];
+                    int change = abs(difference) -
+                                 (int)(((uint32_t)abs(difference) * (65536u - 6554u)) >> 16);
+                    reference[j] = (uint16_t)(reference[j] + (difference > 0 ? change : -change));
+                }
+                if (mask.data[j] != expected || accumulator.getData()[j] != reference[j])
+                {
+                    cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                    return false;
+                }
+            }
+        }
+
+        // Average of constant frame with small alpha reaches frame value
+        // (growing and falling).
+        Frame constant(67, 3, Fourcc::GRAY);
+        memset(constant.data, 0, constant.size);
+        FrameAccumulator background;
+        background.update(constant, 0.001f);
+        for (int value : {100, 30})
+        {
+            memset(constant.data, value, constant.size);
+            for (int i = 0; i < 8000; ++i)
+                background.update(constant, 0.001f);
+            for (int j = 0; j < 67 * 3; ++j)
+            {
+                if (background.getData()[j] != value << 8)
+                {
+                    cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                    return false;
+                }
+            }
+        }
+
+        // Frame differencing of luma.
+        if (!frameDifference(frames[0], frames[1], 50, mask))
+        {
+            cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+            return false;
+        }
+        for (int j = 0; j < 70 * 38; ++j)
+        {
+            if (mask.data[j] != (abs(frames[0].data[j] - frames[1].data[j]) > 50 ? 255 : 0))
+            {
+                cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                return false;
+            }
+        }
+
+        // Temporal mean and median of 1 ... 6 frames.
+        for (int n = 1; n <= count; ++n)
+        {
+            Frame mean;
+            Frame median;
+            if (!temporalMean(pointers, n, mean) || !temporalMedian(pointers, n, median) ||
+                mean.fourcc != Fourcc::YU12 || median.frameId != n - 1)
+            {
+                cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                return false;
+            }
+            for (int j = 0; j < mean.size; ++j)
+            {
+                int values[count];
+                int sum = 0;
+                for (int i = 0; i < n; ++i)
+                {
+                    values[i] = frames[i].data[j];
+                    sum += values[i];
+                }
+                std::sort(values, values + n);
+                int expected = n % 2 != 0 ? values[n / 2] :
+                               (values[n / 2 - 1] + values[n / 2] + 1) / 2;
+                if (median.data[j] != expected ||
+                    mean.data[j] != (uint8_t)((float)sum * (1.0f / (float)n) + 0.5f))
+                {
+                    cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                    return false;
+                }
+            }
+        }
+    }
+    setSimdLevel(getMaxSimdLevel());
+
+    // Average of constant frame.
+    FrameAccumulator accumulator;
+    Frame gray(16, 16, Fourcc::GRAY);
+    memset(gray.data, 100, gray.size);
+    Frame average;
+    if (!accumulator.update(gray, 0.5f) || !accumulator.update(gray, 0.5f) ||
+        !accumulator.getAverage(average) || average.data[0] != 100)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Not valid params: NV12 chroma plane, different frames, too many frames.
+    Frame nv12(16, 16, Fourcc::NV12);
+    const Frame* mixed[2] = {&gray, &nv12};
+    if (accumulator.update(nv12, 0.5f, 1) || accumulator.update(gray, 0.0f) ||
+        frameDifference(gray, nv12, 10, average) || temporalMean(mixed, 2, average) ||
+        temporalMedian(pointers, 17, average))
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+
+/// Deinterlacing test.
+bool deinterlaceTest()
+{
+    // Field views of GRAY and YU12 frames.
+    Frame gray(40, 7, Fourcc::GRAY);
+    for (int i = 0; i < gray.size; ++i)
+        gray.data[i] = (uint8_t)(rand() % 256);
+    FramePlane planes[3];
+    if (getFieldPlanes(gray, Field::TOP, planes) != 1 || planes[0].height != 4 ||
+        planes[0].stride != 80 || planes[0].data != gray.data ||
+        getFieldPlanes(gray, Field::BOTTOM, planes) != 1 || planes[0].height != 3 ||
+        planes[0].data[2 * planes[0].stride + 5] != gray.data[5 * 40 + 5])
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+    Frame yu12(40, 8, Fourcc::YU12);
+    if (getFieldPlanes(yu12, Field::BOTTOM, planes) != 3 || planes[1].height != 2 ||
+        planes[2].stride != 40 || planes[2].data != yu12.data + 40 * 8 + 20 * 4 + 20 ||
+        getFieldPlanes(Frame(40, 2, Fourcc::YU12), Field::TOP, planes) != 0)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Deinterlacers vs per-pixel reference.
+    const Fourcc formats[] = {Fourcc::YUYV, Fourcc::NV12, Fourcc::YU12, Fourcc::GRAY};
+    for (int level = 0; level <= (int)getMaxSimdLevel(); ++level)
+    {
+        setSimdLevel((SimdLevel)level);
+        for (Fourcc fourcc : formats)
+        {
+            Frame current(70, 22, fourcc);
+            Frame previous(70, 22, fourcc);
+            for (int i = 0; i < current.size; ++i)
+            {
+                current.data[i] = (uint8_t)(rand() % 256);
+                previous.data[i] = i % 3 == 0 ? current.data[i] : (uint8_t)(rand() % 256);
+            }
+            current.frameId = 7;
+            FramePlane src[3];
+            FramePlane old[3];
+            FramePlane out[3];
+            int count = getPlanes(current, src);
+            getPlanes(previous, old);
+
+            for (int f = 0; f < 2; ++f)
+            {
+                Frame bob;
+                Frame adaptive;
+                Frame inPlace;
+                inPlace = current;
+                if (!deinterlaceBob(current, (Field)f, bob) ||
+                    !deinterlaceAdaptive(current, previous, (Field)f, 30, adaptive) ||
+                    !deinterlaceBob(inPlace, (Field)f, inPlace) || !(inPlace == bob) ||
+                    bob.frameId != 7 || adaptive.fourcc != fourcc)
+                {
+                    cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                    return false;
+                }
+                for (int k = 0; k < 2; ++k)
+                {
+                    getPlanes(k == 0 ? bob : adaptive, out);
+                    for (int p = 0; p < count; ++p)
+                    {
+                        const int bytes = src[p].width * src[p].elementSize;
+                        const int h = src[p].height;
+                        for (int y = 0; y < h; ++y)
+                        {
+                            int above = y > 0 ? y - 1 : y + 1;
+                            int below = y + 1 < h ? y + 1 : y - 1;
+                            for (int x = 0; x < bytes; ++x)
+                            {
+                                int value = src[p].data[y * src[p].stride + x];
+                                int expected = value;
+                                bool hasMotion = k == 0 ||
+                                    abs(value - old[p].data[y * src[p].stride + x]) > 30;
+                                if (y % 2 != f && hasMotion)
+                                    expected = (src[p].data[above * src[p].stride + x] +
+                                                src[p].data[below * src[p].stride + x] + 1) / 2;
+                                if (out[p].data[y * out[p].stride + x] != expected)
+                                {
+                                    cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                                    return false;
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+
+            // Weave: even rows from current, odd rows from previous.
+            Frame weave;
+            if (!deinterlaceWeave(current, previous, weave))
+            {
+                cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                return false;
+            }
+            getPlanes(weave, out);
+            for (int p = 0; p < count; ++p)
+            {
+                for (int y = 0; y < out[p].height; ++y)
+                {
+                    const FramePlane& s = y % 2 == 0 ? src[p] : old[p];
+                    if (memcmp(&out[p].data[y * out[p].stride], &s.data[y * s.stride],
+                               s.width * s.elementSize) != 0)
+                    {
+                        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                        return false;
+                    }
+                }
+            }
+            uint8_t odd = src[0].data[src[0].stride];
+            if (!deinterlaceWeave(previous, current, current) ||
+                getPlanes(current, src) != count || src[0].data[0] != old[0].data[0] ||
+                src[0].data[src[0].stride] != odd)
+            {
+                cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                return false;
+            }
+        }
+    }
+    setSimdLevel(getMaxSimdLevel());
+
+    // Not valid params: Bayer, 16 bit, different frames, threshold.
+    Frame dst;
+    Frame other(40, 8, Fourcc::NV12);
+    if (deinterlaceBob(Frame(40, 8, Fourcc::RGGB8), Field::TOP, dst) ||
+        deinterlaceBob(Frame(40, 8, Fourcc::BGGR16), Field::TOP, dst) ||
+        deinterlaceBob(Frame(40, 1, Fourcc::GRAY), Field::TOP, dst) ||
+        deinterlaceWeave(yu12, other, dst) ||
+        deinterlaceAdaptive(yu12, other, Field::TOP, 10, dst) ||
+        deinterlaceAdaptive(yu12, yu12, Field::TOP, 256, dst))
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+
+/// NUMA allocation test.
+bool numaTest()
+{
+    // Nodes.
+    const int nodes = getNumaNodesCount();
+    int node = getCurrentNumaNode();
+    if (nodes < 1 || node < 0 || node >= nodes || setThreadNumaNode(nodes) ||
+        setThreadNumaNode(-1))
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Frames on every node.
+    Frame frame;
+    for (int i = 0; i < nodes; ++i)
+    {
+        if (!allocateOnNumaNode(frame, 1920, 1080, Fourcc::NV12, i) ||
+            frame.size != 1920 * 1080 * 3 / 2 || frame.fourcc != Fourcc::NV12)
+        {
+            cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+            return false;
+        }
+        int home = getFrameNumaNode(frame);
+        if (home < 0 || home >= nodes || (nodes == 1 && home != 0))
+        {
+            cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+            return false;
+        }
+    }
+    Frame empty;
+    if (allocateOnNumaNode(frame, 64, 64, Fourcc::GRAY, nodes) ||
+        allocateOnNumaNode(frame, 64, 64, Fourcc::JPEG) || getFrameNumaNode(empty) != -1)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Pool: released frames return to node list.
+    FrameNodePool pool(640, 480, Fourcc::YUYV, 2);
+    {
+        shared_ptr<Frame> a = pool.acquire(0);
+        shared_ptr<Frame> b = pool.acquire(0);
+        shared_ptr<Frame> c = pool.acquire();
+        if (a == nullptr || b == nullptr || c == nullptr || a->width != 640 ||
+            a->fourcc != Fourcc::YUYV || a->data == b->data || pool.getFreeCount(0) != 0 ||
+            pool.acquire(nodes) != nullptr)
+        {
+            cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+            return false;
+        }
+    }
+    int freeCount = 0;
+    for (int i = 0; i < nodes; ++i)
+        freeCount += pool.getFreeCount(i);
+    shared_ptr<Frame> reused = pool.acquire(0);
+    if (freeCount != 2 || reused == nullptr || (nodes == 1 && pool.getFreeCount(0) != 1))
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Frame changed by user is restored.
+    reused->release();
+    reused.reset();
+    reused = pool.acquire(0);
+    shared_ptr<Frame> other = pool.acquire(0);
+    if (reused->data == nullptr || other->data == nullptr || reused->size != 640 * 480 * 2)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Processing on node workers.
+    vector<int> rows(1000, 0);
+    for (int i = -1; i < nodes; ++i)
+    {
+        parallelForNode(i, (int)rows.size(), 10, [&rows](int begin, int end)
+        {
+            for (int y = begin; y < end; ++y)
+                ++rows[y];
+        });
+    }
+    for (int value : rows)
+    {
+        if (value != nodes + 1)
+        {
+            cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+
+/// Counters test.
+bool countersTest()
+{
+    resetCounters();
+    setLatencySampling(1);
+
+    // Operations of this thread.
+    {
+        Frame a(64, 32, Fourcc::GRAY);
+        Frame b(a);
+        Frame c;
+        c = a;
+        c = a;
+        if (!(a == b) || a != c)
+        {
+            cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+            return false;
+        }
+        vector<uint8_t> buffer(a.size + 26);
+        int size = 0;
+        a.serialize(buffer.data(), size);
+        Frame d;
+        d.deserialize(buffer.data(), size);
+    }
+
+    // Operations of other thread.
+    std::thread worker([]()
+    {
+        Frame frame(16, 16, Fourcc::RGB24);
+        frame.release();
+    });
+    worker.join();
+
+    FrameCounters counters = getCounters();
+    setLatencySampling(0);
+    if (!isCountersEnabled())
+    {
+        // Counters are not compiled: empty snapshot.
+        if (counters.allocations != 0 || counters.copies != 0 ||
+            counters.latency[(int)FrameOperation::COPY].samples != 0)
+        {
+            cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+            return false;
+        }
+        return true;
+    }
+
+    // 5 allocations in this thread (a, b, c, d) and 1 in worker.
+    const uint64_t frameSize = 64 * 32;
+    if (counters.allocations != 5 || counters.frees != 5 ||
+        counters.bytesAllocated != 4 * frameSize + 16 * 16 * 3 ||
+        counters.bytesZeroed != frameSize + 16 * 16 * 3 ||
+        counters.bytesCopied != 5 * frameSize || counters.copies != 3 ||
+        counters.compares != 2 || counters.serializations != 1 ||
+        counters.deserializations != 1 ||
+        counters.latency[(int)FrameOperation::COPY].samples != 3 ||
+        counters.latency[(int)FrameOperation::COMPARE].samples != 2 ||
+        counters.latency[(int)FrameOperation::DESERIALIZE].samples != 1 ||
+        counters.latency[(int)FrameOperation::SERIALIZE].maxNs >
+        counters.latency[(int)FrameOperation::SERIALIZE].totalNs)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Reset.
+    resetCounters();
+    counters = getCounters();
+    if (counters.allocations != 0 || counters.bytesCopied != 0 ||
+        counters.latency[(int)FrameOperation::COPY].samples != 0)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+
+/// Copy engine test.
+bool copyEngineTest()
+{
+    // All strategies with not aligned pointers and sizes.
+    const size_t size = (3 << 20) + 77;
+    vector<uint8_t> src(size + 64);
+    vector<uint8_t> dst(size + 64);
+    for (size_t i = 0; i < src.size(); ++i)
+        src[i] = (uint8_t)(rand() % 256);
+    const CopyStrategy strategies[] = {CopyStrategy::AUTO, CopyStrategy::MEMCPY,
+                                       CopyStrategy::STREAM, CopyStrategy::PARALLEL};
+    for (int level = 0; level <= (int)getMaxSimdLevel(); ++level)
+    {
+        setSimdLevel((SimdLevel)level);
+        for (CopyStrategy strategy : strategies)
+        {
+            for (size_t offset : {(size_t)0, (size_t)1, (size_t)13})
+            {
+                for (size_t count : {(size_t)0, (size_t)5, (size_t)100, (size_t)4099, size})
+                {
+                    memset(dst.data(), 0, dst.size());
+                    copyData(dst.data() + offset, src.data() + 7, count, strategy);
+                    if (memcmp(dst.data() + offset, src.data() + 7, count) != 0 ||
+                        (offset > 0 && dst[offset - 1] != 0) || dst[offset + count] != 0)
+                    {
+                        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+    setSimdLevel(getMaxSimdLevel());
+
+    // Plane with stride (bottom field of GRAY frame) to continuous plane.
+    Frame field(301, 97, Fourcc::GRAY);
+    memcpy(field.data, src.data(), field.size);
+    Frame out(301, 48, Fourcc::GRAY);
+    FramePlane planes[3];
+    FramePlane outPlanes[3];
+    if (getFieldPlanes(field, Field::BOTTOM, planes) != 1 || getPlanes(out, outPlanes) != 1)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+    for (CopyStrategy strategy : strategies)
+    {
+        memset(out.data, 0, out.size);
+        if (!copyPlane(planes[0], outPlanes[0], strategy))
+        {
+            cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+            return false;
+        }
+        for (int y = 0; y < 48; ++y)
+        {
+            if (memcmp(&out.data[y * 301], &field.data[(2 * y + 1) * 301], 301) != 0)
+            {
+                cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                return false;
+            }
+        }
+    }
+    if (copyPlane(planes[0], planes[0]) == false ||
+        copyPlane(outPlanes[0], FramePlane()) || copyPlane(FramePlane(), outPlanes[0]))
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Negative and zero strides are rejected.
+    FramePlane reversed = outPlanes[0];
+    reversed.data += (size_t)47 * 301;
+    reversed.stride = -301;
+    FramePlane repeated = outPlanes[0];
+    repeated.stride = 0;
+    if (copyPlane(reversed, planes[0]) || copyPlane(planes[0], reversed) ||
+        copyPlane(repeated, planes[0]) || copyPlane(planes[0], repeated))
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Frame copies with small thresholds (stream and parallel paths).
+    size_t streamBytes = 0;
+    size_t parallelBytes = 0;
+    getCopyThresholds(streamBytes, parallelBytes);
+    setCopyThresholds(1000, 100000);
+    Frame frames[] = {Frame(16, 16, Fourcc::GRAY), Frame(320, 240, Fourcc::GRAY),
+                      Frame(640, 480, Fourcc::RGB24)};
+    for (Frame& frame : frames)
+    {
+        memcpy(frame.data, src.data(), frame.size);
+        frame.frameId = 3;
+        Frame copy(frame);
+        Frame assigned;
+        assigned = frame;
+        if (!(copy == frame) || !(assigned == frame))
+        {
+            cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+            return false;
+        }
+    }
+    setCopyThresholds(streamBytes, parallelBytes);
+    getCopyThresholds(streamBytes, parallelBytes);
+    if (streamBytes != ((size_t)4 << 20) || parallelBytes != ((size_t)32 << 20))
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+
+/// Processing graph test.
+bool graphTest()
+{
+    // Function to add value to all bytes.
+    auto addValue = [](int value)
+    {
+        return [value](const Frame& src, Frame& dst)
+        {
+            dst = src;
+            for (int i = 0; i < dst.size; ++i)
+                dst.data[i] = (uint8_t)(dst.data[i] + value);
+            return true;
+        };
+    };
+
+    // Diamond graph: A -> B, A -> C, B -> D, C -> D with 1 and 4 threads.
+    for (int threads : {1, 4})
+    {
+        FrameGraph graph;
+        mutex resultsMutex;
+        vector<int> results;
+        int a = graph.addStage("A", addValue(1));
+        int b = graph.addStage("B", addValue(10));
+        int c = graph.addStage("C", addValue(20));
+        int d = graph.addStage("D", [&](const Frame& src, Frame&)
+        {
+            lock_guard<mutex> lock(resultsMutex);
+            results.push_back(src.frameId * 1000 + src.data[0]);
+            return false;
+        });
+        if (a != 0 || d != 3 || !graph.connect(a, b, 1) || !graph.connect(a, c, 2) ||
+            !graph.connect(b, d, 1) || !graph.connect(c, d, 3) || !graph.setInput(a, 1, Backpressure::BLOCK) ||
+            graph.connect(d, a) || graph.connect(a, b) || graph.connect(a, a) ||
+            graph.connect(a, 4) || !graph.start(threads) || graph.start() ||
+            graph.addStage("E", addValue(0)) != -1 || graph.connect(b, c))
+        {
+            cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+            return false;
+        }
+
+        const int count = 50;
+        for (int i = 0; i < count; ++i)
+        {
+            Frame frame(8, 8, Fourcc::GRAY);
+            memset(frame.data, i, frame.size);
+            frame.frameId = i;
+            if (!graph.push(a, frame))
+            {
+                cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                return false;
+            }
+        }
+        graph.flush();
+
+        // Every frame passes both branches, frames of branch keep order.
+        FrameStageStats stats;
+        if (results.size() != 2 * count || !graph.getStats(d, stats) ||
+            stats.processed != 2 * count || stats.produced != 0 || stats.name != "D" ||
+            stats.queued != 0 || !graph.getStats(a, stats) || stats.produced != count ||
+            stats.dropped != 0 || stats.throughput <= 0.0 || graph.getStats(4, stats))
+        {
+            cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+            return false;
+        }
+        int lastB = -1;
+        int lastC = -1;
+        for (int value : results)
+        {
+            int id = value / 1000;
+            int data = value % 1000;
+            int& last = data == id + 11 ? lastB : lastC;
+            if ((data != id + 11 && data != id + 21) || id <= last)
+            {
+                cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                return false;
+            }
+            last = id;
+        }
+        graph.stop();
+    }
+
+    // Exception of stage drops frame, graph continues processing.
+    {
+        FrameGraph graph;
+        atomic<int> passed{0};
+        int thrower = graph.addStage("Thrower", [](const Frame& src, Frame& dst)
+        {
+            if (src.frameId % 2 == 1)
+                throw runtime_error("stage error");
+            dst = src;
+            return true;
+        });
+        int counter = graph.addStage("Counter", [&passed](const Frame&, Frame&)
+        {
+            ++passed;
+            return false;
+        });
+        if (!graph.connect(thrower, counter) || !graph.start(2))
+        {
+            cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+            return false;
+        }
+        Frame frame(4, 4, Fourcc::GRAY);
+        for (int i = 0; i < 10; ++i)
+        {
+            frame.frameId = i;
+            graph.push(thrower, frame);
+        }
+        graph.flush();
+        FrameStageStats stats;
+        graph.getStats(thrower, stats);
+        if (passed != 5 || stats.processed != 10 || stats.produced != 5 ||
+            stats.failed != 5 || !graph.getStats(counter, stats) || stats.failed != 0)
+        {
+            cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+            return false;
+        }
+        graph.stop();
+    }
+
+    // Drop oldest: slow stage with input queue of 2 frames.
+    FrameGraph graph;
+    atomic<bool> isStarted{false};
+    atomic<bool> isReleased{false};
+    int slow = graph.addStage("Slow", [&](const Frame&, Frame&)
+    {
+        isStarted = true;
+        while (!isReleased)
+            this_thread::sleep_for(chrono::milliseconds(1));
+        return false;
+    });
+    graph.setInput(slow, 2, Backpressure::DROP_OLDEST);
+    Frame frame(4, 4, Fourcc::GRAY);
+    if (graph.push(slow, frame) || !graph.start(2) || !graph.push(slow, frame))
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+    while (!isStarted)
+        this_thread::sleep_for(chrono::milliseconds(1));
+    for (int i = 0; i < 5; ++i)
+        graph.push(slow, frame);
+    FrameStageStats stats;
+    graph.getStats(slow, stats);
+    if (stats.dropped != 3 || stats.queued != 2)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+    isReleased = true;
+    graph.flush();
+    graph.getStats(slow, stats);
+    if (stats.processed != 3 || stats.queued != 0 || stats.maxLatencyMs <= 0.0)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Stop without processing queued frames.
+    isReleased = false;
+    isStarted = false;
+    graph.push(slow, frame);
+    while (!isStarted)
+        this_thread::sleep_for(chrono::milliseconds(1));
+    graph.push(slow, frame);
+    thread releaser([&isReleased]()
+    {
+        this_thread::sleep_for(chrono::milliseconds(20));
+        isReleased = true;
+    });
+    graph.stop(false);
+    releaser.join();
+    graph.getStats(slow, stats);
+    if (stats.processed != 4 || stats.queued != 0 || graph.push(slow, frame))
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+
+/// Large frames test.
+bool largeFrameTest()
+{
+    // Size which doesn't fit address space and negative geometry.
+    Frame huge(INT32_MAX, INT32_MAX, Fourcc::JPEG);
+    Frame negative(-16, 16, Fourcc::GRAY);
+    if (huge.data != nullptr || huge.size != 0 ||
+        negative.data != nullptr || negative.size != 0)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Size is calculated in 64 bits for all formats.
+    Frame src(640, 360, Fourcc::NV12);
+    for (int64_t i = 0; i < src.size; ++i)
+        src.data[i] = (uint8_t)(rand() % 256);
+    src.frameId = 11;
+    src.sourceId = 22;
+    if (src.size != 640 * 540 || src.getSerializedSize() != src.size + 26)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Both serialize methods write the same 32-bit header.
+    vector<uint8_t> buffer((size_t)src.getSerializedSize());
+    vector<uint8_t> buffer64((size_t)src.getSerializedSize());
+    int size = 0;
+    int64_t size64 = 0;
+    src.serialize(buffer.data(), size);
+    src.serialize(buffer64.data(), size64);
+    if (size != src.getSerializedSize() || size64 != size || buffer != buffer64)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Header with 64-bit size: 32-bit size field is -1 and 64-bit size
+    // follows source ID.
+    vector<uint8_t> large(buffer.size() + 8);
+    int32_t marker = -1;
+    memcpy(large.data(), buffer.data(), 26);
+    memcpy(&large[14], &marker, 4);
+    memcpy(&large[26], &src.size, 8);
+    memcpy(&large[34], &buffer[26], (size_t)src.size);
+    Frame dst;
+    if (!dst.deserialize(large.data(), (int64_t)large.size()) || dst != src)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Move takes data without copying.
+    uint8_t* data = dst.data;
+    Frame moved(std::move(dst));
+    if (moved.data != data || moved != src || dst.data != nullptr || dst.size != 0)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Wrong sizes: truncated header, size bigger than frame buffer.
+    int64_t wrongSize = src.size + 1;
+    memcpy(&large[26], &wrongSize, 8);
+    if (dst.deserialize(large.data(), 30) ||
+        dst.deserialize(large.data(), (int64_t)large.size() + 1))
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+    memcpy(&large[26], &src.size, 8);
+
+    // Stream deserializer with both headers by small chunks.
+    FrameDeserializer deserializer;
+    for (const vector<uint8_t>* data : {&buffer, &large, &buffer})
+    {
+        size_t pos = 0;
+        while (!deserializer.isReady() && pos < data->size())
+        {
+            int count = (int)min((size_t)7, data->size() - pos);
+            int consumed = deserializer.push(&(*data)[pos], count);
+            if (consumed < 0)
+            {
+                cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                return false;
+            }
+            pos += (size_t)consumed;
+        }
+        if (!deserializer.isReady() || pos != data->size() ||
+            deserializer.getFrame() != src)
+        {
+            cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+            return false;
+        }
+        deserializer.next();
+    }
+
+    return true;
+}
+
+
+
+/// Content hash test.
+bool hashTest()
+{
+    // XXH64 reference values.
+    const char* text = "Nobody inspects the spammish repetition";
+    if (getDataHash(nullptr, 0) != 0xEF46DB3751D8E999ULL ||
+        getDataHash((const uint8_t*)"abc", 3) != 0x44BC2CF5AD770999ULL ||
+        getDataHash((const uint8_t*)text, strlen(text)) != 0xFBCEA83C8A378BF1ULL)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Hash of large data doesn't depend on number of threads.
+    vector<uint8_t> buffer((5 << 20) + 77);
+    for (size_t i = 0; i < buffer.size(); ++i)
+        buffer[i] = (uint8_t)(rand() % 256);
+    const int threads = getThreadsCount();
+    setThreadsCount(1);
+    uint64_t hash = getDataHash(buffer.data(), buffer.size());
+    setThreadsCount(4);
+    if (getDataHash(buffer.data(), buffer.size()) != hash)
+    {
+        setThreadsCount(threads);
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+    setThreadsCount(threads);
+    buffer[buffer.size() - 1] ^= 1;
+    if (getDataHash(buffer.data(), buffer.size()) == hash)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Hash is calculated on request and cached.
+    Frame frame(1280, 720, Fourcc::NV12);
+    for (int64_t i = 0; i < frame.size; ++i)
+        frame.data[i] = (uint8_t)(rand() % 256);
+    if (frame.hasHash() || frame.getHash() != getDataHash(frame.data, (size_t)frame.size) ||
+        !frame.hasHash())
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+    hash = frame.getHash();
+
+    // Hash is carried by copy, operator "=" and clone.
+    Frame copy(frame);
+    Frame assigned;
+    assigned = frame;
+    Frame clone;
+    frame.cloneTo(clone);
+    if (!copy.hasHash() || copy.getHash() != hash || !assigned.hasHash() ||
+        assigned.getHash() != hash || !clone.hasHash() || clone.getHash() != hash)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Hash is invalidated on mutation.
+    copy.data[100] ^= 1;
+    copy.invalidateCache();
+    assigned.frameId = 5;
+    if (copy.hasHash() || copy.getHash() == hash || assigned.hasHash())
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Frames are compared by data.
+    assigned.frameId = frame.frameId;
+    if (copy == frame || !(copy != frame) || !(assigned == frame) || assigned != frame)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Comparison is correct after writes through data pointer without
+    // invalidateCache() (cached hashes are stale).
+    copy.getHash();
+    copy.data[100] ^= 1;
+    if (!copy.hasHash() || copy.getHash() == hash || !(copy == frame) || copy != frame)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+    assigned.getHash();
+    assigned.data[200] ^= 1;
+    if (!assigned.hasHash() || assigned.getHash() != hash ||
+        assigned == frame || !(assigned != frame))
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+    assigned.data[200] ^= 1;
+
+    // Serialization with and without hash.
+    vector<uint8_t> data((size_t)frame.getSerializedSize(true));
+    int64_t size = 0;
+    frame.serialize(data.data(), size, true);
+    Frame dst;
+    if (size != frame.size + 42 || !dst.deserialize(data.data(), size) ||
+        !dst.hasHash() || dst.getHash() != hash || dst != frame)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+    FrameDeserializer deserializer;
+    if (deserializer.push(data.data(), 30) != 30 ||
+        deserializer.push(&data[30], (int)size - 30) != (int)size - 30 ||
+        !deserializer.isReady() || !deserializer.getFrame().hasHash() ||
+        deserializer.getFrame().getHash() != hash)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+    frame.serialize(data.data(), size);
+    if (size != frame.size + 26 || !dst.deserialize(data.data(), size) || dst.hasHash())
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+
+/// Pre-event buffer test.
+bool preEventTest()
+{
+    // Frames: 3098 bytes serialized.
+    const int recordSize = 64 * 48 + 26;
+    vector<Frame> frames(20);
+    for (int i = 0; i < 20; ++i)
+    {
+        frames[i] = Frame(64, 48, Fourcc::GRAY);
+        for (int64_t j = 0; j < frames[i].size; ++j)
+            frames[i].data[j] = (uint8_t)(rand() % 256);
+        frames[i].frameId = i;
+        frames[i].sourceId = 3;
+    }
+
+    // Arena size limits buffer: record doesn't fit arena end is written
+    // from arena beginning.
+    FramePreEventBuffer buffer(recordSize * 5 + 1000);
+    for (int i = 0; i < 20; ++i)
+    {
+        if (!buffer.add(frames[i], i * 40000))
+        {
+            cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+            return false;
+        }
+    }
+    int64_t first = 0;
+    int64_t last = 0;
+    if (buffer.getFramesCount() != 5 || buffer.getSize() != (size_t)recordSize * 5 ||
+        !buffer.getTimeRange(first, last) || first != 15 * 40000 || last != 19 * 40000)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Index by frame ID and timestamp.
+    if (buffer.findFrame(17) != 2 || buffer.findFrame(3) != -1 ||
+        buffer.findTime(17 * 40000 - 1) != 2 || buffer.findTime(0) != 0 ||
+        buffer.findTime(20 * 40000) != -1)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+    Frame frame;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    int64_t timestamp = 0;
+    if (!buffer.getFrame(2, frame) || frame != frames[17] ||
+        !buffer.getRecord(4, data, size, timestamp) || size != (size_t)recordSize ||
+        timestamp != 19 * 40000 || buffer.getFrame(5, frame))
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Export without copying is read by stream deserializer.
+    vector<uint8_t> stream;
+    int calls = 0;
+    auto writer = [&](const uint8_t* chunk, size_t chunkSize)
+    {
+        stream.insert(stream.end(), chunk, chunk + chunkSize);
+        ++calls;
+        return true;
+    };
+    if (buffer.exportFrames(1, writer) != 4 || calls > 2 ||
+        stream.size() != (size_t)recordSize * 4)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+    FrameDeserializer deserializer;
+    size_t pos = 0;
+    for (int i = 16; i < 20; ++i)
+    {
+        pos += deserializer.push(&stream[pos], (int)(stream.size() - pos));
+        if (!deserializer.isReady() || deserializer.getFrame() != frames[i])
+        {
+            cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+            return false;
+        }
+        deserializer.next();
+    }
+    if (buffer.exportFrames(0, [](const uint8_t*, size_t) { return false; }) != -1 ||
+        buffer.exportFrames(6, writer) != -1)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Time-based eviction, compressed frames and content hash.
+    buffer.clear();
+    buffer.setMaxDuration(200000);
+    vector<uint8_t> compressed(200, 7);
+    for (int i = 0; i < 20; ++i)
+    {
+        Frame jpeg(64, 48, Fourcc::JPEG, 100 + i, compressed.data());
+        jpeg.frameId = i;
+        if (!buffer.add(jpeg, i * 40000, true))
+        {
+            cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+            return false;
+        }
+    }
+    if (buffer.getFramesCount() != 6 || !buffer.getTimeRange(first, last) ||
+        first != 14 * 40000 || !buffer.getFrame(0, frame) || frame.size != 114 ||
+        frame.fourcc != Fourcc::JPEG || !frame.hasHash())
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Too big frame and timestamp less than previous are rejected.
+    FramePreEventBuffer small(recordSize - 1);
+    if (small.add(frames[0], 0) || buffer.add(frames[0], 0) ||
+        buffer.getFramesCount() != 6)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+
+/// Frame synchronizer test.
+bool synchronizerTest()
+{
+    // Match by frame ID: frame 3 of second source is missing.
+    FrameSynchronizer sync({1, 2});
+    vector<shared_ptr<const Frame>> frames;
+    for (int i = 1; i <= 5; ++i)
+    {
+        for (int source = 1; source <= 2; ++source)
+        {
+            if (source == 2 && i == 3)
+                continue;
+            shared_ptr<Frame> frame = make_shared<Frame>(32, 16, Fourcc::GRAY);
+            frame->frameId = i;
+            frame->sourceId = source;
+            frames.push_back(frame);
+            if (!sync.push(frames.back()))
+            {
+                cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+                return false;
+            }
+        }
+    }
+    FrameTuple tuple;
+    vector<int> ids;
+    while (sync.getTuple(tuple))
+    {
+        // Frames are not copied.
+        if (!tuple.isComplete || tuple.frames.size() != 2 ||
+            tuple.frames[0]->frameId != tuple.frames[1]->frameId ||
+            tuple.frames[0]->sourceId != 1 || tuple.frames[1]->sourceId != 2 ||
+            find(frames.begin(), frames.end(), tuple.frames[0]) == frames.end())
+        {
+            cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+            return false;
+        }
+        ids.push_back(tuple.frames[0]->frameId);
+    }
+    FrameSyncStats stats;
+    sync.getStats(stats);
+    if (ids != vector<int>({1, 2, 4, 5}) || stats.tuples != 4 || stats.dropped != 1 ||
+        stats.late != 0 || stats.partialTuples != 0)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Late frame is dropped, unknown source is rejected.
+    Frame late(32, 16, Fourcc::GRAY);
+    late.frameId = 3;
+    late.sourceId = 2;
+    Frame unknown(late);
+    unknown.sourceId = 7;
+    if (!sync.push(late) || sync.push(unknown) || sync.getTuple(tuple))
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+    sync.getStats(stats);
+    if (stats.late != 1)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Match by timestamp with tolerance, full slots.
+    FrameSynchronizer stereo({1, 2}, 2);
+    stereo.setKey(SyncKey::TIMESTAMP, 5000);
+    Frame left(32, 16, Fourcc::GRAY);
+    left.sourceId = 1;
+    Frame right(left);
+    right.sourceId = 2;
+    if (!stereo.push(left, 0) || !stereo.push(left, 33000) || stereo.push(left, 66000) ||
+        !stereo.push(right, 30000) || !stereo.getTuple(tuple) || !tuple.isComplete ||
+        tuple.timestamps[0] != 33000 || tuple.timestamps[1] != 30000)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+    stereo.getStats(stats);
+    if (stats.tuples != 1 || stats.dropped != 1 || stats.overflow != 1)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Head frame is dropped if next frame of source is closer to newest head
+    // frame (even newer than it).
+    FrameSynchronizer closest({1, 2});
+    closest.setKey(SyncKey::TIMESTAMP, 10);
+    if (!closest.push(left, 100) || !closest.push(left, 112) || !closest.push(right, 108) ||
+        !closest.getTuple(tuple) || !tuple.isComplete ||
+        tuple.timestamps[0] != 112 || tuple.timestamps[1] != 108)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Partial tuple when frame of third source doesn't come in time.
+    FrameSynchronizer rig({1, 2, 3});
+    rig.setMissingPolicy(SyncPolicy::PARTIAL, 10000);
+    late.frameId = 10;
+    late.sourceId = 1;
+    rig.push(late);
+    late.sourceId = 2;
+    rig.push(late);
+    if (rig.getTuple(tuple))
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+    this_thread::sleep_for(chrono::milliseconds(20));
+    if (!rig.getTuple(tuple) || tuple.isComplete || tuple.frames[0] == nullptr ||
+        tuple.frames[1] == nullptr || tuple.frames[2] != nullptr || tuple.latencyUs < 10000)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    // Producer threads and consumer thread.
+    const int count = 2000;
+    FrameSynchronizer pair({1, 2});
+    auto producer = [&](int source)
+    {
+        shared_ptr<Frame> frame = make_shared<Frame>(32, 16, Fourcc::GRAY);
+        for (int i = 0; i < count; ++i)
+        {
+            shared_ptr<Frame> next = make_shared<Frame>(*frame);
+            next->frameId = i;
+            next->sourceId = source;
+            while (!pair.push(next))
+                this_thread::yield();
+        }
+    };
+    thread first(producer, 1);
+    thread second(producer, 2);
+    int received = 0;
+    bool isOrdered = true;
+    while (received < count)
+    {
+        if (!pair.getTuple(tuple))
+        {
+            this_thread::yield();
+            continue;
+        }
+        isOrdered = isOrdered && tuple.isComplete && tuple.frames[0]->frameId == received &&
+                    tuple.frames[1]->frameId == received;
+        ++received;
+    }
+    first.join();
+    second.join();
+    pair.getStats(stats);
+    if (!isOrdered || stats.tuples != (uint64_t)count || stats.dropped != 0 ||
+        stats.maxLatencyUs < 0)
+    {
+        cout << "[" << __LINE__ << "] " << __FILE__ << " : ERROR" << endl;
+        return false;
+    }
+
+    return true;
+}